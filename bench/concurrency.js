@@ -0,0 +1,237 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+// Concurrency benchmarks against the mock dbcapi library with added server
+// latency. Shows how throughput scales with the number of connections, the
+// size of the libuv threadpool and the number of requests each connection
+// has outstanding (queue depth).
+//
+//   node bench/concurrency.js [--time=seconds] [--latency=ms] [--jitter=ms]
+//	[--fetch-latency=ms] [--rows=n] [--pools=1,4,...]
+//	[--connections=1,2,...] [--depths=1,4,...] [--out=file]
+//
+// Each threadpool size is run in its own process, since UV_THREADPOOL_SIZE
+// is only read when the pool starts. Requests to one connection run one at
+// a time, so a request queued behind another on the same connection holds
+// a pool thread while it waits; idealOpsPerSec assumes it does not.
+'use strict';
+
+var fs = require( 'fs' );
+var child_process = require( 'child_process' );
+var mock = require( './mock' );
+
+var defaults = {
+    time: 1,
+    latency: 2,
+    jitter: 0.5,
+    'fetch-latency': 0,
+    rows: 10,
+    pools: '1,4,16',
+    connections: '1,2,4,8,16,32',
+    depths: '1,4',
+    out: null,
+    child: null
+};
+
+function parseArgs( argv )
+{
+    var options = JSON.parse( JSON.stringify( defaults ) );
+    argv.forEach( function( arg ) {
+	var match = arg.match( /^--([a-z-]+)=(.*)$/ );
+	if( match === null || !( match[1] in defaults ) ) {
+	    throw new Error( "Unknown argument: " + arg );
+	}
+	options[match[1]] = match[2];
+    } );
+    [ 'time', 'latency', 'jitter', 'fetch-latency', 'rows' ].forEach( function( key ) {
+	options[key] = Number( options[key] );
+    } );
+    [ 'pools', 'connections', 'depths' ].forEach( function( key ) {
+	options[key] = String( options[key] ).split( ',' ).map( Number );
+    } );
+    return options;
+}
+
+function now()
+{
+    var t = process.hrtime();
+    return t[0] * 1e3 + t[1] / 1e6;
+}
+
+function percentile( sorted, p )
+{
+    if( sorted.length === 0 ) {
+	return 0;
+    }
+    return sorted[Math.min( sorted.length - 1, Math.floor( p * sorted.length ) )];
+}
+
+function connectAll( sqlanywhere, count, shape, done )
+{
+    var conns = [];
+    var pending = count;
+    var failed = null;
+    for( var i = 0; i < count; i++ ) {
+	var conn = sqlanywhere.createConnection();
+	conns.push( conn );
+	conn.connect( mock.connectionString( shape ), function( err ) {
+	    failed = failed || err;
+	    if( --pending === 0 ) {
+		done( failed, conns );
+	    }
+	} );
+    }
+}
+
+function disconnectAll( conns, done )
+{
+    var pending = conns.length;
+    conns.forEach( function( conn ) {
+	conn.disconnect( function() {
+	    if( --pending === 0 ) {
+		done();
+	    }
+	} );
+    } );
+}
+
+// Keeps depth requests outstanding on each connection for the given time
+function runPoint( sqlanywhere, options, pool, connections, depth, done )
+{
+    var shape = {
+	rows: options.rows,
+	cols: 3,
+	executeLatency: options.latency,
+	fetchLatency: options['fetch-latency'],
+	jitter: options.jitter
+    };
+    connectAll( sqlanywhere, connections, shape, function( err, conns ) {
+	if( err ) {
+	    return done( err );
+	}
+	var latencies = [];
+	var start = now();
+	var end = start + options.time * 1000;
+	var running = connections * depth;
+	var failed = null;
+
+	function loop( conn ) {
+	    var t = now();
+	    if( t >= end || failed ) {
+		if( --running === 0 ) {
+		    finish();
+		}
+		return;
+	    }
+	    conn.exec( "SELECT * FROM bench", function( err ) {
+		failed = failed || err;
+		latencies.push( now() - t );
+		loop( conn );
+	    } );
+	}
+
+	function finish() {
+	    var seconds = ( now() - start ) / 1000;
+	    latencies.sort( function( a, b ) { return a - b; } );
+	    disconnectAll( conns, function() {
+		if( failed ) {
+		    return done( failed );
+		}
+		var round_trip = options.latency + options.jitter / 2 +
+		    options['fetch-latency'] * options.rows;
+		done( null, {
+		    threadpool: pool,
+		    connections: connections,
+		    depth: depth,
+		    iterations: latencies.length,
+		    seconds: seconds,
+		    opsPerSec: latencies.length / seconds,
+		    idealOpsPerSec: Math.min( connections, pool ) * 1000 / round_trip,
+		    latency: {
+			p50: percentile( latencies, 0.5 ),
+			p99: percentile( latencies, 0.99 ),
+			max: latencies.length > 0 ? latencies[latencies.length - 1] : 0
+		    }
+		} );
+	    } );
+	}
+
+	conns.forEach( function( conn ) {
+	    for( var d = 0; d < depth; d++ ) {
+		loop( conn );
+	    }
+	} );
+    } );
+}
+
+// Runs every point for one threadpool size and prints the results
+function runChild( options )
+{
+    mock.install();
+    var sqlanywhere = require( '../lib/index' );
+    var pool = Number( options.child );
+    var points = [];
+    options.connections.forEach( function( connections ) {
+	options.depths.forEach( function( depth ) {
+	    points.push( [ connections, depth ] );
+	} );
+    } );
+
+    var results = [];
+    var i = 0;
+    function next( err, result ) {
+	if( err ) {
+	    console.error( err );
+	    process.exit( 1 );
+	}
+	if( result ) {
+	    results.push( result );
+	}
+	if( i >= points.length ) {
+	    process.stdout.write( JSON.stringify( results ) );
+	    return;
+	}
+	var point = points[i++];
+	runPoint( sqlanywhere, options, pool, point[0], point[1], next );
+    }
+    next( null, null );
+}
+
+function main()
+{
+    var options = parseArgs( process.argv.slice( 2 ) );
+    if( options.child !== null ) {
+	return runChild( options );
+    }
+
+    var report = {
+	driver: require( '../package.json' ).version,
+	node: process.version,
+	platform: process.platform + '-' + process.arch,
+	date: new Date().toISOString(),
+	library: mock.install(),
+	latency: options.latency,
+	jitter: options.jitter,
+	fetchLatency: options['fetch-latency'],
+	rows: options.rows,
+	seconds: options.time,
+	results: []
+    };
+
+    options.pools.forEach( function( pool ) {
+	var args = process.argv.slice( 1 ).concat( [ '--child=' + pool ] );
+	var env = JSON.parse( JSON.stringify( process.env ) );
+	env.UV_THREADPOOL_SIZE = String( pool );
+	var output = child_process.execFileSync( process.execPath, args,
+						 { env: env } );
+	report.results = report.results.concat( JSON.parse( output.toString() ) );
+    } );
+
+    var json = JSON.stringify( report, null, 2 );
+    if( options.out ) {
+	fs.writeFileSync( options.out, json + '\n' );
+    }
+    console.log( json );
+}
+
+main();
@@ -0,0 +1,302 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+// Microbenchmarks of the driver core (src/core.cpp) against the mock dbcapi
+// library, without Node. The cases match those of bench/run.js, so the
+// difference between the two is the cost of the V8 side. Run it under perf
+// or a heap profiler to see where fetch and bind time goes.
+//
+//   core_bench [--time=seconds] [--iterations=n] [--filter=text]
+//		[--lib=path] [--trace=file]
+//
+// --iterations runs each case a fixed number of times instead of for a
+// fixed time, and --trace writes a trace of the dbcapi calls (see trace.h).
+// The mock library is found from --lib, SQLANY_MOCK_DLL or SQLANY_API_DLL,
+// in that order. The report is printed as JSON.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "sqlany_core.h"
+#include "trace.h"
+
+struct benchOptions {
+    double		seconds;
+    unsigned long	iterations;
+    const char *	filter;
+    const char *	lib;
+    const char *	trace;
+};
+
+struct benchResult {
+    unsigned long	iterations;
+    double		seconds;
+    uint64_t		rows;
+    uint64_t		bytes;
+};
+
+struct benchCase;
+typedef bool (*benchStep)( a_sqlany_connection *, a_sqlany_stmt *,
+			   const benchCase &, driverStats & );
+
+struct benchCase {
+    const char *	name;
+    const char *	shape;	// mock connection parameters
+    const char *	sql;
+    benchStep		step;
+    unsigned		rows;	// rows bound per execute
+};
+
+static double elapsedSince( std::chrono::steady_clock::time_point start )
+/***********************************************************************/
+{
+    return std::chrono::duration<double>(
+	std::chrono::steady_clock::now() - start ).count();
+}
+
+static void fail( a_sqlany_connection *conn, const char *what )
+/*************************************************************/
+{
+    char msg[256] = "";
+    sacapi_i32 code = conn != NULL ? api.sqlany_error( conn, msg, sizeof( msg ) ) : 0;
+    fprintf( stderr, "core_bench: %s failed (%d) %s\n", what, (int)code, msg );
+    exit( 1 );
+}
+
+// Executes the statement and fetches the whole result set, as
+// executeStatement does on a worker thread
+static bool fetchStep( a_sqlany_connection *conn, a_sqlany_stmt *stmt,
+		       const benchCase &c, driverStats &stats )
+/**********************************************************************/
+{
+    ExecuteData				data;
+    std::vector<char *>			col_names;
+    std::vector<a_sqlany_data_type>	col_types;
+    int					rows_affected;
+
+    if( !api.sqlany_reset( stmt ) ) {
+	return false;
+    }
+    {
+	traceSpan span( "sqlany_execute" );
+	if( !api.sqlany_execute( stmt ) ) {
+	    return false;
+	}
+    }
+    bool ok = fetchResultSet( stmt, rows_affected, col_names, &data,
+			      col_types, &stats );
+    CLEAN_STRINGS( col_names );
+    if( !ok ) {
+	char msg[8];
+	return api.sqlany_error( conn, msg, sizeof( msg ) ) == 100;
+    }
+    return true;
+}
+
+// Copies one row, or c.rows rows, of parameters the way getBindParameters
+// does, then binds them and executes the statement
+static bool bindStep( a_sqlany_connection *conn, a_sqlany_stmt *stmt,
+		      const benchCase &c, driverStats &stats )
+/*********************************************************************/
+{
+    static const char text[] = "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx";
+    ExecuteData				data;
+    std::vector<a_sqlany_bind_param>	params;
+
+    if( c.rows == 1 ) {
+	bindInt( &data, params, 1 );
+	bindBytes( &data, params, A_STRING, text, sizeof( text ) - 1 );
+	bindDouble( &data, params, 1.5 );
+    } else {
+	wideColumn ids = addWideColumn( &data, params, A_DOUBLE, c.rows );
+	wideColumn names = addWideColumn( &data, params, A_STRING, c.rows );
+	wideColumn values = addWideColumn( &data, params, A_DOUBLE, c.rows );
+	for( unsigned r = 0; r < c.rows; r++ ) {
+	    setWideDouble( ids, r, r );
+	    setWideBytes( names, r, text, sizeof( text ) - 1, true );
+	    setWideDouble( values, r, r + 0.5 );
+	}
+    }
+
+    if( !api.sqlany_reset( stmt ) ||
+	!bindParameters( stmt, params, c.rows ) ) {
+	return false;
+    }
+    stats.add( STAT_ROWS_BOUND, c.rows );
+    stats.add( STAT_BYTES_BOUND, boundBytes( params, c.rows ) );
+    traceSpan span( "sqlany_execute" );
+    return api.sqlany_execute( stmt ) != 0;
+}
+
+// Prepares and frees a statement
+static bool prepareStep( a_sqlany_connection *conn, a_sqlany_stmt *,
+			 const benchCase &c, driverStats & )
+/**********************************************************************/
+{
+    a_sqlany_stmt *stmt = api.sqlany_prepare( conn, c.sql );
+    if( stmt == NULL ) {
+	return false;
+    }
+    api.sqlany_free_stmt( stmt );
+    return true;
+}
+
+static const benchCase cases[] = {
+    { "fetch.mixed_1000x4",
+      "MockRows=1000;MockCols=4;MockWidth=16;MockTypes=int,string,double,bigint",
+      "SELECT * FROM bench", fetchStep, 1 },
+    { "fetch.strings_1000x20",
+      "MockRows=1000;MockCols=20;MockWidth=64;MockTypes=string",
+      "SELECT * FROM bench", fetchStep, 1 },
+    { "fetch.binary_200x2",
+      "MockRows=200;MockCols=2;MockWidth=4096;MockTypes=int,binary",
+      "SELECT * FROM bench", fetchStep, 1 },
+    { "bind.row", "",
+      "INSERT INTO bench VALUES ( ?, ?, ? )", bindStep, 1 },
+    { "bind.wide_100", "",
+      "INSERT INTO bench VALUES ( ?, ?, ? )", bindStep, 100 },
+    { "prepare", "",
+      "SELECT * FROM bench WHERE id = ?", prepareStep, 1 }
+};
+
+static benchResult runCase( const benchCase &c, const benchOptions &options )
+/***************************************************************************/
+{
+    std::string conn_str = std::string( "UID=mock;PWD=mock;" ) + c.shape;
+    a_sqlany_connection *conn = api.sqlany_new_connection();
+    if( !api.sqlany_connect( conn, conn_str.c_str() ) ) {
+	fail( conn, "connect" );
+    }
+    a_sqlany_stmt *stmt = api.sqlany_prepare( conn, c.sql );
+    if( stmt == NULL ) {
+	fail( conn, "prepare" );
+    }
+
+    driverStats stats;
+    benchResult result;
+    memset( &result, 0, sizeof( result ) );
+
+    // warm up, then measure
+    double warmup = options.seconds / 4 < 0.5 ? options.seconds / 4 : 0.5;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while( options.iterations == 0 && elapsedSince( start ) < warmup ) {
+	if( !c.step( conn, stmt, c, stats ) ) {
+	    fail( conn, c.name );
+	}
+    }
+
+    uint64_t rows_before = stats.get( STAT_ROWS_FETCHED ) + stats.get( STAT_ROWS_BOUND );
+    uint64_t bytes_before = 0;
+    for( int i = STAT_BYTES_FETCHED_STRING; i <= STAT_BYTES_FETCHED_DOUBLE; i++ ) {
+	bytes_before += stats.get( (statCounter)i );
+    }
+    bytes_before += stats.get( STAT_BYTES_BOUND );
+
+    start = std::chrono::steady_clock::now();
+    while( true ) {
+	if( options.iterations > 0 ? result.iterations >= options.iterations :
+	    elapsedSince( start ) >= options.seconds ) {
+	    break;
+	}
+	if( !c.step( conn, stmt, c, stats ) ) {
+	    fail( conn, c.name );
+	}
+	result.iterations++;
+    }
+    result.seconds = elapsedSince( start );
+
+    result.rows = stats.get( STAT_ROWS_FETCHED ) + stats.get( STAT_ROWS_BOUND ) -
+		  rows_before;
+    for( int i = STAT_BYTES_FETCHED_STRING; i <= STAT_BYTES_FETCHED_DOUBLE; i++ ) {
+	result.bytes += stats.get( (statCounter)i );
+    }
+    result.bytes += stats.get( STAT_BYTES_BOUND );
+    result.bytes -= bytes_before;
+
+    api.sqlany_free_stmt( stmt );
+    api.sqlany_disconnect( conn );
+    api.sqlany_free_connection( conn );
+    return result;
+}
+
+static bool parseArgs( int argc, char **argv, benchOptions &options )
+/*******************************************************************/
+{
+    options.seconds = 2;
+    options.iterations = 0;
+    options.filter = NULL;
+    options.lib = getenv( "SQLANY_MOCK_DLL" );
+    options.trace = NULL;
+    for( int i = 1; i < argc; i++ ) {
+	const char *arg = argv[i];
+	if( strncmp( arg, "--time=", 7 ) == 0 ) {
+	    options.seconds = atof( arg + 7 );
+	} else if( strncmp( arg, "--iterations=", 13 ) == 0 ) {
+	    options.iterations = strtoul( arg + 13, NULL, 10 );
+	} else if( strncmp( arg, "--filter=", 9 ) == 0 ) {
+	    options.filter = arg + 9;
+	} else if( strncmp( arg, "--lib=", 6 ) == 0 ) {
+	    options.lib = arg + 6;
+	} else if( strncmp( arg, "--trace=", 8 ) == 0 ) {
+	    options.trace = arg + 8;
+	} else {
+	    fprintf( stderr, "core_bench: unknown argument: %s\n", arg );
+	    return false;
+	}
+    }
+    return true;
+}
+
+int main( int argc, char **argv )
+/*******************************/
+{
+    benchOptions options;
+    if( !parseArgs( argc, argv, options ) ) {
+	return 2;
+    }
+
+    // With no library named, sqlany_initialize_interface uses SQLANY_API_DLL
+    if( !sqlany_initialize_interface( &api, options.lib ) ) {
+	fprintf( stderr, "core_bench: could not load the mock dbcapi library. "
+		 "Use --lib, or set SQLANY_MOCK_DLL.\n" );
+	return 1;
+    }
+    sacapi_u32 max_api_ver;
+    if( !api.sqlany_init( "core_bench", SQLANY_API_VERSION_4, &max_api_ver ) ) {
+	fail( NULL, "sqlany_init" );
+    }
+
+    if( options.trace != NULL && !traceStart( options.trace ) ) {
+	fprintf( stderr, "core_bench: could not create %s\n", options.trace );
+	return 1;
+    }
+
+    printf( "{\n  \"library\": \"%s\",\n  \"results\": [",
+	    options.lib != NULL ? options.lib : "" );
+    const char *sep = "";
+    for( size_t i = 0; i < sizeof( cases ) / sizeof( cases[0] ); i++ ) {
+	const benchCase &c = cases[i];
+	if( options.filter != NULL && strstr( c.name, options.filter ) == NULL ) {
+	    continue;
+	}
+	benchResult r = runCase( c, options );
+	double seconds = r.seconds > 0 ? r.seconds : 1;
+	printf( "%s\n    { \"name\": \"%s\", \"iterations\": %lu, \"seconds\": %.3f, "
+		"\"opsPerSec\": %.1f, \"nsPerOp\": %.1f, \"rowsPerSec\": %.1f, "
+		"\"bytesPerSec\": %.1f }",
+		sep, c.name, r.iterations, r.seconds, r.iterations / seconds,
+		r.iterations > 0 ? r.seconds * 1e9 / r.iterations : 0.0,
+		r.rows / seconds, r.bytes / seconds );
+	fflush( stdout );
+	sep = ",";
+    }
+    printf( "\n  ]\n}\n" );
+    traceStop();
+
+    api.sqlany_fini();
+    sqlany_finalize_interface( &api );
+    return 0;
+}
@@ -0,0 +1,87 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+// Helpers to run the driver against the mock dbcapi library built from
+// mock/mock_dbcapi.cpp by the dbcapi_mock target of binding.gyp.
+'use strict';
+
+var fs = require( 'fs' );
+var path = require( 'path' );
+
+var build_dir = path.join( __dirname, '..', 'build', 'Release' );
+var candidates = [
+    'libdbcapi_mock.so',
+    path.join( 'lib.target', 'libdbcapi_mock.so' ),
+    path.join( 'obj.target', 'libdbcapi_mock.so' ),
+    'libdbcapi_mock.dylib',
+    'libdbcapi_mock.dll',
+    'dbcapi_mock.dll'
+];
+
+// Returns the path of the built mock library, or null if it was not built
+function findLibrary()
+{
+    if( process.env.SQLANY_MOCK_DLL ) {
+	return process.env.SQLANY_MOCK_DLL;
+    }
+    for( var i = 0; i < candidates.length; i++ ) {
+	var file = path.join( build_dir, candidates[i] );
+	if( fs.existsSync( file ) ) {
+	    return file;
+	}
+    }
+    return null;
+}
+
+// Makes the driver load the mock library in place of dbcapi. Must be
+// called before the first connection is opened.
+function install()
+{
+    var lib = findLibrary();
+    if( lib === null ) {
+	throw new Error( "The mock dbcapi library was not found in " + build_dir +
+			 ". Build it with node-gyp rebuild -- -Dsqlany_bench=1," +
+			 " or set SQLANY_MOCK_DLL." );
+    }
+    process.env.SQLANY_API_DLL = lib;
+    return lib;
+}
+
+var shape_keys = {
+    rows: 'MockRows',
+    cols: 'MockCols',
+    types: 'MockTypes',
+    width: 'MockWidth',
+    connectLatency: 'MockConnectLatency',
+    executeLatency: 'MockExecuteLatency',
+    fetchLatency: 'MockFetchLatency',
+    prefetch: 'MockPrefetch',
+    jitter: 'MockJitter'
+};
+
+// Builds a connection string that sets the shape of the mock result sets
+// and the latency of the mock server:
+// { rows, cols, types: [ 'int', 'string', ... ], width,
+//   connectLatency, executeLatency, fetchLatency, prefetch, jitter }
+function connectionString( shape )
+{
+    var parts = [ 'UID=mock', 'PWD=mock' ];
+    shape = shape || {};
+    Object.keys( shape_keys ).forEach( function( key ) {
+	var value = shape[key];
+	if( value === undefined ) {
+	    return;
+	}
+	if( Array.isArray( value ) ) {
+	    value = value.join( ',' );
+	}
+	parts.push( shape_keys[key] + '=' + value );
+    } );
+    return parts.join( ';' );
+}
+
+module.exports = {
+    findLibrary: findLibrary,
+    install: install,
+    connectionString: connectionString
+};
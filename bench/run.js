@@ -0,0 +1,247 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+// End-to-end driver benchmarks against the mock dbcapi library. No database
+// server is needed. The results are written as JSON so that runs of
+// different releases can be compared.
+//
+//   node bench/run.js [--time=seconds] [--filter=text] [--out=file]
+//
+// --time is how long each case is measured for (default 2), --filter runs
+// only the cases whose name contains the text, and --out also writes the
+// report to a file.
+'use strict';
+
+var fs = require( 'fs' );
+var os = require( 'os' );
+var mock = require( './mock' );
+
+var library = mock.install();
+var sqlanywhere = require( '../lib/index' );
+var pkg = require( '../package.json' );
+
+var cases = [
+    { name: 'fetch.mixed_1000x4', run: fetchCase,
+      shape: { rows: 1000, cols: 4, width: 16,
+	       types: [ 'int', 'string', 'double', 'bigint' ] } },
+    { name: 'fetch.strings_1000x20', run: fetchCase,
+      shape: { rows: 1000, cols: 20, width: 64, types: [ 'string' ] } },
+    { name: 'fetch.binary_200x2', run: fetchCase,
+      shape: { rows: 200, cols: 2, width: 4096, types: [ 'int', 'binary' ] } },
+    { name: 'bind.row', run: bindCase, rows: 1 },
+    { name: 'bind.wide_100', run: bindCase, rows: 100 },
+    { name: 'prepare', run: prepareCase },
+    { name: 'callback_latency', run: latencyCase,
+      shape: { rows: 1, cols: 1, types: [ 'int' ] } }
+];
+
+function parseArgs( argv )
+{
+    var options = { time: 2, filter: null, out: null };
+    argv.forEach( function( arg ) {
+	var match = arg.match( /^--(time|filter|out)=(.*)$/ );
+	if( match === null ) {
+	    throw new Error( "Unknown argument: " + arg );
+	}
+	options[match[1]] = match[1] === 'time' ? Number( match[2] ) : match[2];
+    } );
+    return options;
+}
+
+function now()
+{
+    var t = process.hrtime();
+    return t[0] * 1e3 + t[1] / 1e6;
+}
+
+function percentile( sorted, p )
+{
+    if( sorted.length === 0 ) {
+	return 0;
+    }
+    var index = Math.min( sorted.length - 1, Math.floor( p * sorted.length ) );
+    return sorted[index];
+}
+
+// Calls step( cb ) back to back for the given number of seconds and
+// reports the iterations done and the latency of each call in ms.
+function repeat( step, seconds, done )
+{
+    var start = now();
+    var end = start + seconds * 1000;
+    var latencies = [];
+
+    function next( err ) {
+	if( err ) {
+	    return done( err );
+	}
+	var t = now();
+	if( t >= end ) {
+	    latencies.sort( function( a, b ) { return a - b; } );
+	    return done( null, {
+		iterations: latencies.length,
+		seconds: ( t - start ) / 1000,
+		latency: {
+		    p50: percentile( latencies, 0.5 ),
+		    p99: percentile( latencies, 0.99 ),
+		    max: latencies.length > 0 ? latencies[latencies.length - 1] : 0
+		}
+	    } );
+	}
+	step( function( err ) {
+	    latencies.push( now() - t );
+	    // leave the stack between iterations, as an application would
+	    setImmediate( next, err );
+	} );
+    }
+    next( null );
+}
+
+// Runs step for a short warm-up, then measures it
+function measure( step, options, done )
+{
+    repeat( step, Math.min( 0.5, options.time / 4 ), function( err ) {
+	if( err ) {
+	    return done( err );
+	}
+	repeat( step, options.time, done );
+    } );
+}
+
+function statsDelta( before, after )
+{
+    var delta = {};
+    Object.keys( after ).forEach( function( key ) {
+	delta[key] = after[key] - before[key];
+    } );
+    return delta;
+}
+
+function fetchCase( conn, c, options, done )
+{
+    var before = conn.stats();
+    measure( function( cb ) {
+	conn.exec( "SELECT * FROM bench", cb );
+    }, options, function( err, result ) {
+	if( err ) {
+	    return done( err );
+	}
+	var delta = statsDelta( before, conn.stats() );
+	var bytes = delta.bytesFetchedString + delta.bytesFetchedBinary +
+		    delta.bytesFetchedInt + delta.bytesFetchedDouble;
+	result.rowsPerSec = delta.rowsFetched / result.seconds;
+	result.bytesPerSec = bytes / result.seconds;
+	done( null, result );
+    } );
+}
+
+function bindCase( conn, c, options, done )
+{
+    var text = new Array( 33 ).join( 'x' );
+    var params = [];
+    for( var i = 0; i < c.rows; i++ ) {
+	params.push( [ i, text, i + 0.5 ] );
+    }
+    if( c.rows === 1 ) {
+	params = params[0];
+    }
+    conn.prepare( "INSERT INTO bench VALUES ( ?, ?, ? )", function( err, stmt ) {
+	if( err ) {
+	    return done( err );
+	}
+	var before = conn.stats();
+	measure( function( cb ) {
+	    stmt.exec( params, cb );
+	}, options, function( err, result ) {
+	    if( err ) {
+		return done( err );
+	    }
+	    var delta = statsDelta( before, conn.stats() );
+	    result.rowsPerSec = delta.rowsBound / result.seconds;
+	    result.bytesPerSec = delta.bytesBound / result.seconds;
+	    stmt.drop( function( err ) {
+		done( err, result );
+	    } );
+	} );
+    } );
+}
+
+function prepareCase( conn, c, options, done )
+{
+    measure( function( cb ) {
+	conn.prepare( "SELECT * FROM bench WHERE id = ?", function( err, stmt ) {
+	    if( err ) {
+		return cb( err );
+	    }
+	    stmt.drop( cb );
+	} );
+    }, options, done );
+}
+
+function latencyCase( conn, c, options, done )
+{
+    measure( function( cb ) {
+	conn.exec( "SELECT 1", cb );
+    }, options, done );
+}
+
+function runCase( c, options, done )
+{
+    var conn = sqlanywhere.createConnection();
+    conn.connect( mock.connectionString( c.shape ), function( err ) {
+	if( err ) {
+	    return done( err );
+	}
+	c.run( conn, c, options, function( err, result ) {
+	    conn.disconnect( function() {
+		if( err ) {
+		    return done( err );
+		}
+		result.opsPerSec = result.iterations / result.seconds;
+		result.name = c.name;
+		done( null, result );
+	    } );
+	} );
+    } );
+}
+
+function main()
+{
+    var options = parseArgs( process.argv.slice( 2 ) );
+    var selected = cases.filter( function( c ) {
+	return options.filter === null || c.name.indexOf( options.filter ) >= 0;
+    } );
+    var report = {
+	driver: pkg.version,
+	node: process.version,
+	platform: process.platform + '-' + process.arch,
+	cpu: os.cpus().length > 0 ? os.cpus()[0].model : null,
+	date: new Date().toISOString(),
+	library: library,
+	seconds: options.time,
+	results: []
+    };
+
+    var i = 0;
+    function next( err, result ) {
+	if( err ) {
+	    console.error( err );
+	    process.exit( 1 );
+	}
+	if( result ) {
+	    report.results.push( result );
+	}
+	if( i >= selected.length ) {
+	    var json = JSON.stringify( report, null, 2 );
+	    if( options.out ) {
+		fs.writeFileSync( options.out, json + '\n' );
+	    }
+	    console.log( json );
+	    return;
+	}
+	runCase( selected[i++], options, next );
+    }
+    next( null, null );
+}
+
+main();
@@ -1,11 +1,20 @@
 {
+  "variables": {
+    # Build the benchmarks and the mock, capture and replay dbcapi libraries
+    # with node-gyp rebuild -- -Dsqlany_bench=1
+    "sqlany_bench%": 0,
+    # Build the tests in test/ with node-gyp rebuild -- -Dsqlany_test=1
+    "sqlany_test%": 0
+  },
   "targets": [
     {
       "target_name": "sqlanywhere",
       "defines": [ '_SACAPI_VERSION=5', 'DRIVER_NAME=sqlanywhere' ],
+      "dependencies": [ "sqlany_core" ],
       "sources": [ "src/sqlanywhere.cpp",
 		   "src/utils.cpp",
-		   "src/sacapidll.cpp", ],
+		   "src/statements.cpp",
+		   "src/slowlog.cpp", ],
 
       "include_dirs": [
         "src/h",
@@ -21,6 +30,95 @@
 	  }
 	}
       }	
+    },
+    {
+      # Fetch and bind code that does not depend on V8 (src/h/sqlany_core.h)
+      "target_name": "sqlany_core",
+      "type": "static_library",
+      "defines": [ '_SACAPI_VERSION=5' ],
+      "sources": [ "src/core.cpp",
+		   "src/trace.cpp",
+		   "src/stats.cpp",
+		   "src/sacapidll.cpp" ],
+      "include_dirs": [ "src/h" ],
+      "direct_dependent_settings": {
+	"include_dirs": [ "src/h" ]
+      },
+      "conditions": [
+	[ 'OS!="win"', { "cflags": [ "-fPIC" ] } ]
+      ],
+      'configurations': {
+	'Release': {
+	  'msvs_settings': {
+            'VCCLCompilerTool': {
+              'ExceptionHandling': 1
+            }
+	  }
+	}
+      }
     }
+  ],
+  "conditions": [
+    [ 'sqlany_bench==1', {
+      "targets": [
+        {
+          # Microbenchmarks of sqlany_core against the mock dbcapi library
+          "target_name": "core_bench",
+          "type": "executable",
+          "dependencies": [ "sqlany_core" ],
+          "defines": [ '_SACAPI_VERSION=5' ],
+          "sources": [ "bench/core_bench.cpp" ],
+          "conditions": [
+	    [ 'OS!="win"', { "libraries": [ "-ldl" ] } ]
+          ]
+        },
+        {
+          # Stand-in dbcapi library for the benchmarks in bench/
+          "target_name": "dbcapi_mock",
+          "type": "shared_library",
+          "product_prefix": "lib",
+          "defines": [ '_SACAPI_VERSION=5' ],
+          "sources": [ "mock/mock_dbcapi.cpp" ],
+          "include_dirs": [ "src/h" ]
+        },
+        {
+          # Records the dbcapi calls of a real application (see mock/recording.h)
+          "target_name": "dbcapi_capture",
+          "type": "shared_library",
+          "product_prefix": "lib",
+          "defines": [ '_SACAPI_VERSION=5' ],
+          "sources": [ "mock/capture_dbcapi.cpp",
+		       "src/sacapidll.cpp" ],
+          "include_dirs": [ "src/h", "mock" ],
+          "conditions": [
+	    [ 'OS!="win"', { "libraries": [ "-ldl" ] } ]
+          ]
+        },
+        {
+          # Serves a recording made by dbcapi_capture back to the driver
+          "target_name": "dbcapi_replay",
+          "type": "shared_library",
+          "product_prefix": "lib",
+          "defines": [ '_SACAPI_VERSION=5' ],
+          "sources": [ "mock/replay_dbcapi.cpp" ],
+          "include_dirs": [ "src/h", "mock" ]
+        }
+      ]
+    } ],
+    [ 'sqlany_test==1', {
+      "targets": [
+        {
+          # Statement fingerprints and latency histograms
+          "target_name": "statements_test",
+          "type": "executable",
+          "sources": [ "test/statements_test.cpp",
+		       "src/statements.cpp" ],
+          "include_dirs": [ "src/h" ],
+          "conditions": [
+	    [ 'OS!="win"', { "libraries": [ "-luv" ] } ]
+          ]
+        }
+      ]
+    } ]
   ]
 }
@@ -31,4 +31,23 @@ try {
 			 "', and Version: '" + process.version +"'" ); 
     }
 }
+
+// Publish query events on diagnostics_channel where the runtime has it
+var diagnostics_channel = null;
+try {
+    diagnostics_channel = require( "diagnostics_channel" );
+} catch( err ) {
+}
+if( diagnostics_channel !== null && db.setDiagnosticsChannels ) {
+    db.setDiagnosticsChannels(
+	diagnostics_channel.channel( "sqlanywhere:query:start" ),
+	diagnostics_channel.channel( "sqlanywhere:query:end" ),
+	diagnostics_channel.channel( "sqlanywhere:query:error" ) );
+}
+
+var Pool = require( "./pool" );
+db.createPool = function( options ) {
+    return new Pool( db, options );
+};
+
 module.exports = db;
@@ -0,0 +1,766 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+// A pool of connections. Connections are opened in the background as the
+// pool grows, and each one runs the warm-up statements and prepares the
+// statements listed in the options before it is handed out, so that the
+// first request on a new connection does not pay for any of that.
+//
+// With read-only mirror servers listed in the replicas option, the pool
+// keeps a group of connections for each server. Queries run through
+// pool.exec go to the replica with the fewest outstanding requests, and
+// everything else goes to the primary.
+//
+// dbcapi does not autocommit. pool.exec commits each statement that is not
+// a query, and every connection is rolled back when it is released, so the
+// next user never inherits an open transaction or its locks.
+//
+// Under overload, requests are shed rather than left to pile up: maxQueue
+// bounds the requests waiting for a connection, and a request with a
+// timeout fails once its deadline passes, whether it is waiting here for a
+// connection or natively for the connection's lock.
+'use strict';
+
+var defaults = {
+    min: 0,
+    max: 10,
+    warmUp: [],
+    prepare: [],
+    connectionOptions: null,
+    replicas: [],
+    maxQueue: 0,
+    timeout: 0
+};
+
+// After a connection fails to open, the group waits this long before
+// reopening connections to get back to min, doubling the wait after each
+// further failure up to the maximum
+var RETRY_DELAY_MS = 100;
+var MAX_RETRY_DELAY_MS = 30000;
+
+// Calls fn with a node style callback. Returns a promise for the result
+// when the caller passed no callback.
+function withCallback( callback, fn )
+{
+    if( typeof callback === 'function' ) {
+	fn( callback );
+	return undefined;
+    }
+    return new Promise( function( resolve, reject ) {
+	fn( function( err, result ) {
+	    if( err ) {
+		reject( err );
+	    } else {
+		resolve( result );
+	    }
+	} );
+    } );
+}
+
+// Returns true if the statement only reads, so that it can run on a
+// read-only mirror. Anything that is not plainly a query is a write.
+function isQuery( sql )
+{
+    var text = sql.replace( /'(?:[^']|'')*'/g, "''" )
+		  .replace( /\/\*[\s\S]*?\*\//g, ' ' )
+		  .replace( /(--|\/\/)[^\n]*/g, ' ' )
+		  .replace( /^[\s(]+/, '' );
+    if( !/^(SELECT|WITH)\b/i.test( text ) ) {
+	return false;
+    }
+    return !/\b(INTO|FOR\s+UPDATE|INSERT|UPDATE|DELETE|MERGE)\b/i.test( text );
+}
+
+// The connections to one server
+function Group( driver, connection, options )
+{
+    this._driver = driver;
+    this._connection = connection;
+    this._options = options;
+    this._idle = [];		// ready connections, most recently used last
+    this._busy = [];		// connections handed out
+    this._waiting = [];		// acquire calls not yet served
+    this._opening = 0;		// connections being opened and warmed up
+    this._closed = false;
+    this._rejected = 0;		// acquire calls turned away by maxQueue
+    this._expired = 0;		// acquire calls that timed out waiting
+    this._failures = 0;		// opens failed in a row
+    this._retry = undefined;	// timer to reopen connections after a failure
+
+    this._maintainMin();
+}
+
+// Opens a connection, runs the warm-up statements and fills its statement
+// cache, then hands it to the first waiter or makes it idle
+Group.prototype._open = function()
+{
+    var group = this;
+    var options = this._options;
+    var conn = this._driver.createConnection();
+    if( options.connectionOptions !== null ) {
+	conn.setOptions( options.connectionOptions );
+    }
+    this._opening++;
+
+    function failed( err )
+    {
+	group._opening--;
+	if( conn.connected() ) {
+	    conn.disconnect( function() {} );
+	}
+	var waiter = group._nextWaiter();
+	if( waiter !== undefined ) {
+	    waiter( err );
+	}
+	group._failures++;
+	group._grow();
+	group._maintainMin();
+    }
+
+    conn.connect( this._connection, function( err ) {
+	if( err ) {
+	    return failed( err );
+	}
+	var warm_up = options.warmUp.map( function( entry ) {
+	    return typeof entry === 'string' ? { sql: entry } : entry;
+	} );
+	// Committed, so that the first borrower does not inherit the
+	// warm-up's transaction
+	var step = warm_up.length > 0 ?
+	    function( next ) { conn.execBatch( warm_up, { transaction: true }, next ); } :
+	    function( next ) { next( null ); };
+	step( function( err ) {
+	    if( err ) {
+		return failed( err );
+	    }
+	    conn.cacheStatements( options.prepare, function( err ) {
+		if( err ) {
+		    return failed( err );
+		}
+		group._opening--;
+		group._failures = 0;
+		if( group._closed ) {
+		    conn.disconnect( function() {} );
+		    return;
+		}
+		group._release( conn );
+	    } );
+	} );
+    } );
+};
+
+// Opens connections for waiters that no connection being opened will serve
+Group.prototype._grow = function()
+{
+    while( !this._closed && this._waiting.length > this._opening &&
+	   this.size() < this._options.max ) {
+	this._open();
+    }
+};
+
+// Opens connections until the group has min again. After failed opens it
+// waits first, so that a server that is down is not retried in a loop.
+Group.prototype._maintainMin = function()
+{
+    var group = this;
+
+    function fill()
+    {
+	while( !group._closed && group.size() < group._options.min ) {
+	    group._open();
+	}
+    }
+
+    if( this._closed || this._retry !== undefined ||
+	this.size() >= this._options.min ) {
+	return;
+    }
+    if( this._failures === 0 ) {
+	return fill();
+    }
+    var delay = Math.min( RETRY_DELAY_MS * Math.pow( 2, this._failures - 1 ),
+			  MAX_RETRY_DELAY_MS );
+    this._retry = setTimeout( function() {
+	group._retry = undefined;
+	fill();
+    }, delay );
+    // Reconnecting alone does not keep the process running
+    this._retry.unref();
+};
+
+// Returns the callback of the longest waiting acquire call
+Group.prototype._nextWaiter = function()
+{
+    var waiter = this._waiting.shift();
+    if( waiter === undefined ) {
+	return undefined;
+    }
+    clearTimeout( waiter.timer );
+    return waiter.done;
+};
+
+Group.prototype._release = function( conn )
+{
+    var waiter = this._nextWaiter();
+    if( waiter !== undefined ) {
+	this._busy.push( conn );
+	waiter( null, conn );
+    } else {
+	this._idle.push( conn );
+    }
+};
+
+Group.prototype.size = function()
+{
+    return this._idle.length + this._busy.length + this._opening;
+};
+
+// The deadlineMs the connections were configured with
+Group.prototype.deadlineMs = function()
+{
+    var options = this._options.connectionOptions;
+    return options !== null && options.deadlineMs > 0 ? options.deadlineMs : 0;
+};
+
+// Requests running on the group's connections or waiting for one
+Group.prototype.outstanding = function()
+{
+    return this._busy.length + this._waiting.length;
+};
+
+Group.prototype.owns = function( conn )
+{
+    return this._busy.indexOf( conn ) >= 0;
+};
+
+// Hands a connection to done, or an error if none is free before the
+// deadline, a Date.now() time
+Group.prototype.acquire = function( done, deadline )
+{
+    if( this._closed ) {
+	return done( new Error( "Pool is closed" ) );
+    }
+    var conn = this._idle.pop();
+    if( conn !== undefined ) {
+	this._busy.push( conn );
+	return done( null, conn );
+    }
+    if( this._options.maxQueue > 0 && this._waiting.length >= this._options.maxQueue ) {
+	this._rejected++;
+	return done( new Error( "Too many requests waiting for a connection" ) );
+    }
+
+    var group = this;
+    var waiter = { done: done, timer: undefined };
+    if( deadline !== undefined ) {
+	waiter.timer = setTimeout( function() {
+	    group._waiting.splice( group._waiting.indexOf( waiter ), 1 );
+	    group._expired++;
+	    done( new Error( "Timed out waiting for a connection" ) );
+	}, Math.max( deadline - Date.now(), 0 ) );
+    }
+    this._waiting.push( waiter );
+    this._grow();
+};
+
+// Rolls back whatever the holder left uncommitted and restores the group's
+// deadlineMs before the connection is used again. It stays busy until then.
+Group.prototype.release = function( conn )
+{
+    var group = this;
+
+    function drop()
+    {
+	group._busy.splice( group._busy.indexOf( conn ), 1 );
+	if( conn.connected() ) {
+	    conn.disconnect( function() {} );
+	}
+	group._grow();
+	group._maintainMin();
+    }
+
+    if( this._closed || !conn.connected() ) {
+	return drop();
+    }
+    // pool.exec hands its request's deadline to the connection
+    conn.setOptions( { deadlineMs: this.deadlineMs() } );
+    conn.rollback( function( err ) {
+	if( err || group._closed ) {
+	    return drop();
+	}
+	group._busy.splice( group._busy.indexOf( conn ), 1 );
+	group._release( conn );
+    } );
+};
+
+Group.prototype.stats = function()
+{
+    return {
+	size: this.size(),
+	idle: this._idle.length,
+	busy: this._busy.length,
+	opening: this._opening,
+	waiting: this._waiting.length,
+	rejected: this._rejected,
+	expired: this._expired
+    };
+};
+
+Group.prototype.close = function( done )
+{
+    this._closed = true;
+    clearTimeout( this._retry );
+    this._retry = undefined;
+    var waiter;
+    while( ( waiter = this._nextWaiter() ) !== undefined ) {
+	waiter( new Error( "Pool is closed" ) );
+    }
+    var idle = this._idle;
+    this._idle = [];
+    var pending = idle.length;
+    var failed = null;
+    if( pending === 0 ) {
+	return done( null );
+    }
+    idle.forEach( function( conn ) {
+	conn.disconnect( function( err ) {
+	    failed = failed || err;
+	    if( --pending === 0 ) {
+		done( failed );
+	    }
+	} );
+    } );
+};
+
+function Pool( driver, options )
+{
+    if( options === null || typeof options !== 'object' ||
+	options.connection === undefined ) {
+	throw new Error( "createPool requires connection parameters" );
+    }
+    var settings = {};
+    for( var key in defaults ) {
+	settings[key] = options[key] !== undefined ? options[key] : defaults[key];
+    }
+    if( settings.max < 1 || settings.min > settings.max ) {
+	throw new Error( "Invalid pool size" );
+    }
+
+    this._primary = new Group( driver, options.connection, settings );
+    this._replicas = settings.replicas.map( function( connection ) {
+	return new Group( driver, connection, settings );
+    } );
+    this._next_replica = 0;
+    this._timeout = settings.timeout;
+}
+
+// Returns the replica with the fewest outstanding requests, taking turns
+// among those tied, or the primary if there are no replicas
+Pool.prototype._readGroup = function()
+{
+    var count = this._replicas.length;
+    if( count === 0 ) {
+	return this._primary;
+    }
+    var best = null;
+    for( var i = 0; i < count; i++ ) {
+	var group = this._replicas[( this._next_replica + i ) % count];
+	if( best === null || group.outstanding() < best.outstanding() ) {
+	    best = group;
+	}
+    }
+    this._next_replica = ( this._next_replica + 1 ) % count;
+    return best;
+};
+
+Pool.prototype._owner = function( conn )
+{
+    if( this._primary.owns( conn ) ) {
+	return this._primary;
+    }
+    for( var i = 0; i < this._replicas.length; i++ ) {
+	if( this._replicas[i].owns( conn ) ) {
+	    return this._replicas[i];
+	}
+    }
+    return null;
+};
+
+// Number of connections in the pool, including those being opened
+Pool.prototype.size = function()
+{
+    return this._replicas.reduce( function( size, group ) {
+	return size + group.size();
+    }, this._primary.size() );
+};
+
+// Hands out a ready connection to the primary, or to a replica with the
+// readOnly option. With the timeout option, fails if none is free in time.
+// The connection must be given back with release(), which rolls back
+// anything not committed.
+Pool.prototype.acquire = function( options, callback )
+{
+    if( typeof options === 'function' ) {
+	callback = options;
+	options = undefined;
+    }
+    options = options !== undefined ? options : {};
+    var group = options.readOnly ? this._readGroup() : this._primary;
+    var timeout = options.timeout !== undefined ? options.timeout : this._timeout;
+    return withCallback( callback, function( done ) {
+	group.acquire( done, timeout > 0 ? Date.now() + timeout : undefined );
+    } );
+};
+
+Pool.prototype.release = function( conn )
+{
+    var group = this._owner( conn );
+    if( group === null ) {
+	throw new Error( "Connection does not belong to the pool" );
+    }
+    group.release( conn );
+};
+
+// Runs one statement on a pooled connection and commits it, unless it is a
+// query. Queries go to a replica unless the primary option is set.
+Pool.prototype.exec = function( sql, params, options, callback )
+{
+    var args = Array.prototype.slice.call( arguments, 1 );
+    callback = typeof args[args.length - 1] === 'function' ? args.pop() : undefined;
+    params = Array.isArray( args[0] ) ? args.shift() : undefined;
+    options = args[0] !== undefined ? args[0] : {};
+
+    var group = !options.primary && isQuery( sql ) ?
+		this._readGroup() : this._primary;
+    var timeout = options.timeout !== undefined ? options.timeout : this._timeout;
+    var deadline = timeout > 0 ? Date.now() + timeout : undefined;
+    return withCallback( callback, function( done ) {
+	group.acquire( function( err, conn ) {
+	    if( err ) {
+		return done( err );
+	    }
+	    var finish = function( err, result ) {
+		group.release( conn );
+		done( err, result );
+	    };
+	    // A failed statement is rolled back by release()
+	    var executed = function( err, result ) {
+		if( err || isQuery( sql ) ) {
+		    return finish( err, result );
+		}
+		conn.commit( function( err ) {
+		    finish( err, err ? undefined : result );
+		} );
+	    };
+	    // What is left of the deadline covers the wait for a worker thread
+	    // and for the connection's lock
+	    conn.setOptions( {
+		deadlineMs: deadline !== undefined ?
+			    Math.max( deadline - Date.now(), 1 ) : group.deadlineMs()
+	    } );
+	    if( params === undefined ) {
+		conn.exec( sql, executed );
+	    } else {
+		conn.exec( sql, params, executed );
+	    }
+	}, deadline );
+    } );
+};
+
+// Runs the statements on pooled connections, at most options.concurrency
+// at a time, and passes each result to onResult as it arrives. done is
+// called after the last result, or with the first error, after which no
+// more statements are started.
+Pool.prototype._runParallel = function( statements, options, onResult, done )
+{
+    var pool = this;
+    var limit = options.concurrency > 0 ? options.concurrency : this._primary._options.max;
+    var next = 0;
+    var running = 0;
+    var failed = null;
+
+    function dispatch()
+    {
+	if( failed === null && next === statements.length && running === 0 ) {
+	    return done( null );
+	}
+	while( failed === null && next < statements.length && running < limit ) {
+	    start( next++ );
+	}
+    }
+
+    function start( index )
+    {
+	var entry = statements[index];
+	var sql = typeof entry === 'string' ? entry : entry.sql;
+	var args = typeof entry === 'string' || entry.params === undefined ?
+		   [ sql, options ] : [ sql, entry.params, options ];
+	running++;
+	pool.exec.apply( pool, args.concat( function( err, result ) {
+	    running--;
+	    if( failed !== null ) {
+		return;
+	    }
+	    if( err ) {
+		failed = err;
+		return done( err );
+	    }
+	    onResult( index, result );
+	    dispatch();
+	} ) );
+    }
+
+    dispatch();
+};
+
+// Runs independent statements at the same time, each on its own pooled
+// connection, and returns their results in the order given. At most
+// options.concurrency run at once; the default is the pool's max. On the
+// first error no more statements are started and the error is returned.
+Pool.prototype.execParallel = function( statements, options, callback )
+{
+    if( typeof options === 'function' ) {
+	callback = options;
+	options = undefined;
+    }
+    options = options !== undefined ? options : {};
+    var pool = this;
+    return withCallback( callback, function( done ) {
+	var results = new Array( statements.length );
+	pool._runParallel( statements, options, function( index, result ) {
+	    results[index] = result;
+	}, function( err ) {
+	    done( err, err ? undefined : results );
+	} );
+    } );
+};
+
+// Orders partition keys as the server does, with NULL first
+function compareKeys( a, b )
+{
+    if( a === b ) {
+	return 0;
+    }
+    if( a === null || a === undefined ) {
+	return -1;
+    }
+    if( b === null || b === undefined ) {
+	return 1;
+    }
+    return a < b ? -1 : ( a > b ? 1 : 0 );
+}
+
+// Partition and sort columns are put into the generated SQL, so they must
+// be plain column names of the query's result
+function isColumnName( name )
+{
+    return typeof name === 'string' && /^[A-Za-z_][A-Za-z0-9_]*$/.test( name );
+}
+
+// Brackets quote an identifier whatever the quoted_identifier option is
+function quoteColumn( name )
+{
+    return '[' + name + ']';
+}
+
+// Returns the property of the rows that holds the column, which the server
+// may spell in a different case
+function rowKey( lists, column )
+{
+    for( var i = 0; i < lists.length; i++ ) {
+	if( lists[i].length > 0 ) {
+	    var keys = Object.keys( lists[i][0] );
+	    for( var j = 0; j < keys.length; j++ ) {
+		if( keys[j].toLowerCase() === column.toLowerCase() ) {
+		    return keys[j];
+		}
+	    }
+	}
+    }
+    return column;
+}
+
+// Merges row arrays that are each sorted by key into one sorted array
+function mergeSorted( lists, column )
+{
+    var key = rowKey( lists, column );
+    var heads = lists.map( function() { return 0; } );
+    var merged = [];
+    while( true ) {
+	var best = -1;
+	for( var i = 0; i < lists.length; i++ ) {
+	    if( heads[i] < lists[i].length &&
+		( best < 0 || compareKeys( lists[i][heads[i]][key],
+					   lists[best][heads[best]][key] ) < 0 ) ) {
+		best = i;
+	    }
+	}
+	if( best < 0 ) {
+	    return merged;
+	}
+	merged.push( lists[best][heads[best]++] );
+    }
+}
+
+// Splits [lo, hi] into count ranges and returns the count - 1 boundaries
+// between them
+function rangeBounds( lo, hi, count )
+{
+    var integral = lo % 1 === 0 && hi % 1 === 0;
+    var bounds = [];
+    for( var i = 1; i < count; i++ ) {
+	var bound = lo + ( hi - lo ) * i / count;
+	if( integral ) {
+	    bound = Math.floor( bound );
+	}
+	if( bound > lo && ( bounds.length === 0 || bound > bounds[bounds.length - 1] ) ) {
+	    bounds.push( bound );
+	}
+    }
+    return bounds;
+}
+
+// One statement per key range. The first range also takes the NULL keys,
+// so that together the partitions return every row of the query.
+function partitionStatements( sql, params, column, bounds, sort_key )
+{
+    var base = "SELECT * FROM ( " + sql + " ) AS sqlany_scan";
+    var order = sort_key !== undefined ? " ORDER BY " + quoteColumn( sort_key ) : "";
+    column = quoteColumn( column );
+    if( bounds.length === 0 ) {
+	return [ { sql: base + order, params: params } ];
+    }
+    var statements = [];
+    for( var i = 0; i <= bounds.length; i++ ) {
+	var where;
+	var values;
+	if( i === 0 ) {
+	    where = column + " < ? OR " + column + " IS NULL";
+	    values = [ bounds[0] ];
+	} else if( i === bounds.length ) {
+	    where = column + " >= ?";
+	    values = [ bounds[i - 1] ];
+	} else {
+	    where = column + " >= ? AND " + column + " < ?";
+	    values = [ bounds[i - 1], bounds[i] ];
+	}
+	statements.push( { sql: base + " WHERE " + where + order,
+			   params: params.concat( values ) } );
+    }
+    return statements;
+}
+
+// Splits a query into key ranges of options.partitionColumn and runs the
+// ranges in parallel on pooled connections. The ranges are given by the
+// boundaries in options.ranges, or found by splitting the key's MIN to MAX
+// into options.partitions equal parts. Rows come back in no particular
+// order, or merged in order of options.sortKey. With options.onRows, each
+// partition's rows are passed to it as they arrive instead.
+Pool.prototype.scanPartitioned = function( sql, options, callback )
+{
+    var pool = this;
+    var column = options.partitionColumn;
+    var params = options.params !== undefined ? options.params : [];
+    var run_options = {
+	concurrency: options.concurrency,
+	primary: options.primary,
+	timeout: options.timeout
+    };
+
+    function scan( bounds, done )
+    {
+	var statements = partitionStatements( sql, params, column, bounds,
+					      options.sortKey );
+	var results = new Array( statements.length );
+	pool._runParallel( statements, run_options, function( index, rows ) {
+	    if( options.onRows !== undefined ) {
+		options.onRows( rows, index );
+	    } else {
+		results[index] = rows;
+	    }
+	}, function( err ) {
+	    if( err || options.onRows !== undefined ) {
+		return done( err );
+	    }
+	    if( options.sortKey !== undefined ) {
+		return done( null, mergeSorted( results, options.sortKey ) );
+	    }
+	    done( null, Array.prototype.concat.apply( [], results ) );
+	} );
+    }
+
+    return withCallback( callback, function( done ) {
+	if( !isColumnName( column ) ) {
+	    return done( new Error( "scanPartitioned requires a partitionColumn " +
+				    "that is a plain column name" ) );
+	}
+	if( options.sortKey !== undefined && !isColumnName( options.sortKey ) ) {
+	    return done( new Error( "sortKey must be a plain column name" ) );
+	}
+	if( Array.isArray( options.ranges ) ) {
+	    return scan( options.ranges, done );
+	}
+	var count = options.partitions > 0 ? options.partitions : 1;
+	if( count === 1 ) {
+	    return scan( [], done );
+	}
+	var range_sql = "SELECT MIN( " + quoteColumn( column ) + " ) AS lo, MAX( " +
+			quoteColumn( column ) + " ) AS hi FROM ( " + sql +
+			" ) AS sqlany_scan";
+	pool.exec( range_sql, params, run_options, function( err, rows ) {
+	    if( err ) {
+		return done( err );
+	    }
+	    var lo = rows[0].lo;
+	    var hi = rows[0].hi;
+	    if( lo === null || hi === null ) {
+		return scan( [], done );
+	    }
+	    if( typeof lo !== 'number' || typeof hi !== 'number' ) {
+		return done( new Error( "partitions requires a numeric " +
+					"partitionColumn; give ranges instead" ) );
+	    }
+	    scan( rangeBounds( lo, hi, count ), done );
+	} );
+    } );
+};
+
+Pool.prototype.stats = function()
+{
+    var stats = this._primary.stats();
+    if( this._replicas.length > 0 ) {
+	stats.primary = this._primary.stats();
+	stats.replicas = this._replicas.map( function( group ) {
+	    var replica = group.stats();
+	    for( var key in replica ) {
+		stats[key] += replica[key];
+	    }
+	    return replica;
+	} );
+    }
+    return stats;
+};
+
+// Disconnects the idle connections. Connections handed out are closed when
+// they are released, and those being opened when they are ready.
+Pool.prototype.close = function( callback )
+{
+    var groups = [ this._primary ].concat( this._replicas );
+    return withCallback( callback, function( done ) {
+	var pending = groups.length;
+	var failed = null;
+	groups.forEach( function( group ) {
+	    group.close( function( err ) {
+		failed = failed || err;
+		if( --pending === 0 ) {
+		    done( failed );
+		}
+	    } );
+	} );
+    } );
+};
+
+module.exports = Pool;
+// For the tests in test/
+Pool._rangeBounds = rangeBounds;
+Pool._mergeSorted = mergeSorted;
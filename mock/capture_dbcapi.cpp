@@ -0,0 +1,640 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+//
+// A dbcapi library that sits between the driver and the real dbcapi library
+// and records the session to a file that the replay library can serve back
+// later. Load it with SQLANY_API_DLL and set:
+//
+//   SQLANY_CAPTURE_FILE	the recording to write (required)
+//   SQLANY_CAPTURE_DLL		the real dbcapi library (default: the usual
+//				library name on the library path)
+//
+// Prepares, binds (types and sizes only), executes, result set columns and
+// fetched rows are recorded with the time each real call took; see
+// recording.h for the format. Calls the driver does not make are passed
+// through without being recorded.
+//
+// ***************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <mutex>
+#include <chrono>
+
+#include "sacapidll.h"
+#include "recording.h"
+
+#if defined( _WIN32 )
+    #define CAPTURE_EXPORT __declspec( dllexport )
+    #define DEFAULT_REAL_LIBRARY "dbcapi.dll"
+#else
+    #define CAPTURE_EXPORT __attribute__(( visibility( "default" ) ))
+    #if defined( __APPLE__ )
+	#define DEFAULT_REAL_LIBRARY "libdbcapi_r.dylib"
+    #else
+	#define DEFAULT_REAL_LIBRARY "libdbcapi_r.so"
+    #endif
+#endif
+
+struct stmtInfo {
+    uint32_t				id;
+    a_sqlany_connection			*conn;
+    sacapi_u32				batch_size;
+    std::vector<a_sqlany_data_value>	params;
+};
+
+static SQLAnywhereInterface			real;
+static FILE					*captureFile = NULL;
+static std::mutex				captureLock;
+static std::map<a_sqlany_connection *, uint32_t>	connIds;
+static std::map<a_sqlany_stmt *, stmtInfo>	stmtInfos;
+static uint32_t					nextId = 1;
+static bool					captured = false;
+
+typedef std::chrono::steady_clock captureClock;
+
+static uint32_t elapsedSince( captureClock::time_point start )
+/************************************************************/
+{
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+	captureClock::now() - start ).count();
+}
+
+static void writeRecord( recordKind kind, uint32_t id, uint32_t elapsed_us,
+			 const recordWriter &payload )
+/*************************************************************************/
+{
+    std::lock_guard<std::mutex> lock( captureLock );
+    if( captureFile == NULL ) {
+	return;
+    }
+    uint8_t k = (uint8_t)kind;
+    uint32_t len = (uint32_t)payload.data.size();
+    fwrite( &k, sizeof( k ), 1, captureFile );
+    fwrite( &id, sizeof( id ), 1, captureFile );
+    fwrite( &elapsed_us, sizeof( elapsed_us ), 1, captureFile );
+    fwrite( &len, sizeof( len ), 1, captureFile );
+    if( len > 0 ) {
+	fwrite( &payload.data[0], 1, len, captureFile );
+    }
+}
+
+static void closeCapture( void )
+/******************************/
+{
+    std::lock_guard<std::mutex> lock( captureLock );
+    if( captureFile != NULL ) {
+	fclose( captureFile );
+	captureFile = NULL;
+    }
+}
+
+// Loads the real library and opens the recording. Returns false if either
+// can not be done, or if the real library turns out to be this one.
+static bool startCapture( void )
+/******************************/
+{
+    if( real.initialized ) {
+	return true;
+    }
+    const char *file = getenv( "SQLANY_CAPTURE_FILE" );
+    if( file == NULL ) {
+	return false;
+    }
+    const char *path = getenv( "SQLANY_CAPTURE_DLL" );
+    if( !sqlany_initialize_interface( &real,
+				      path != NULL ? path : DEFAULT_REAL_LIBRARY ) ) {
+	return false;
+    }
+    if( real.sqlany_init == (sqlany_init_func)sqlany_init ) {
+	// SQLANY_API_DLL points here, and the real library was not found
+	sqlany_finalize_interface( &real );
+	return false;
+    }
+
+    std::lock_guard<std::mutex> lock( captureLock );
+    // the driver finalizes the interface when its last connection closes,
+    // so later sessions of the same process are added to the recording
+    captureFile = fopen( file, captured ? "ab" : "wb" );
+    if( captureFile == NULL ) {
+	sqlany_finalize_interface( &real );
+	return false;
+    }
+    if( !captured ) {
+	fwrite( RECORDING_MAGIC, 1, RECORDING_MAGIC_LEN, captureFile );
+	atexit( closeCapture );
+	captured = true;
+    }
+    return true;
+}
+
+static uint32_t connId( a_sqlany_connection *conn )
+/*************************************************/
+{
+    std::lock_guard<std::mutex> lock( captureLock );
+    std::map<a_sqlany_connection *, uint32_t>::iterator it = connIds.find( conn );
+    if( it != connIds.end() ) {
+	return it->second;
+    }
+    uint32_t id = nextId++;
+    connIds[conn] = id;
+    return id;
+}
+
+static bool findStmt( a_sqlany_stmt *stmt, stmtInfo &info )
+/*********************************************************/
+{
+    std::lock_guard<std::mutex> lock( captureLock );
+    std::map<a_sqlany_stmt *, stmtInfo>::iterator it = stmtInfos.find( stmt );
+    if( it == stmtInfos.end() ) {
+	return false;
+    }
+    info = it->second;
+    return true;
+}
+
+static sacapi_i32 lastError( a_sqlany_connection *conn, std::string *msg )
+/************************************************************************/
+{
+    char buffer[SACAPI_ERROR_SIZE];
+    buffer[0] = '\0';
+    sacapi_i32 sqlcode = real.sqlany_error( conn, buffer, sizeof( buffer ) );
+    if( msg != NULL ) {
+	*msg = buffer;
+    }
+    return sqlcode;
+}
+
+static void recordColumns( a_sqlany_stmt *stmt, uint32_t id )
+/***********************************************************/
+{
+    sacapi_i32 num_cols = real.sqlany_num_cols( stmt );
+    if( num_cols <= 0 ) {
+	return;
+    }
+    recordWriter payload;
+    payload.put32( (uint32_t)num_cols );
+    for( sacapi_i32 i = 0; i < num_cols; i++ ) {
+	a_sqlany_column_info info;
+	memset( &info, 0, sizeof( info ) );
+	real.sqlany_get_column_info( stmt, (sacapi_u32)i, &info );
+	std::string name( info.name != NULL ? info.name : "" );
+	payload.put32( (uint32_t)info.type );
+	payload.put32( (uint32_t)info.native_type );
+	payload.put32( (uint32_t)info.max_size );
+	payload.put16( (uint16_t)name.length() );
+	payload.putString( name );
+    }
+    writeRecord( REC_COLUMNS, id, 0, payload );
+}
+
+static void recordRow( a_sqlany_stmt *stmt, uint32_t id, uint32_t elapsed_us )
+/****************************************************************************/
+{
+    sacapi_i32 num_cols = real.sqlany_num_cols( stmt );
+    recordWriter payload;
+    for( sacapi_i32 i = 0; i < num_cols; i++ ) {
+	a_sqlany_data_value value;
+	memset( &value, 0, sizeof( value ) );
+	if( !real.sqlany_get_column( stmt, (sacapi_u32)i, &value ) ||
+	    value.is_null == NULL || *value.is_null ) {
+	    payload.put8( 0 );
+	    payload.put32( 0 );
+	    continue;
+	}
+	size_t len = fixedSize( value.type );
+	if( len == 0 ) {
+	    len = value.length != NULL ? *value.length : 0;
+	}
+	payload.put8( (uint8_t)value.type );
+	payload.put32( (uint32_t)len );
+	payload.putBytes( value.buffer, len );
+    }
+    writeRecord( REC_ROW, id, elapsed_us, payload );
+}
+
+static void recordBinds( stmtInfo &info )
+/***************************************/
+{
+    for( size_t i = 0; i < info.params.size(); i++ ) {
+	a_sqlany_data_value &value = info.params[i];
+	uint64_t bytes = 0;
+	for( sacapi_u32 r = 0; r < info.batch_size; r++ ) {
+	    if( value.is_null != NULL && value.is_null[r] ) {
+		continue;
+	    }
+	    size_t len = fixedSize( value.type );
+	    if( len == 0 && value.length != NULL ) {
+		len = value.length[r];
+	    }
+	    bytes += len;
+	}
+	recordWriter payload;
+	payload.put32( (uint32_t)i );
+	payload.put32( (uint32_t)value.type );
+	payload.put32( info.batch_size );
+	payload.put64( bytes );
+	writeRecord( REC_BIND, info.id, 0, payload );
+    }
+}
+
+static void recordStatus( recordKind kind, uint32_t id, uint32_t elapsed_us,
+			  sacapi_bool ok )
+/**************************************************************************/
+{
+    recordWriter payload;
+    payload.put8( ok ? 1 : 0 );
+    writeRecord( kind, id, elapsed_us, payload );
+}
+
+extern "C" {
+
+CAPTURE_EXPORT sacapi_bool sqlany_init( const char * app_name,
+					sacapi_u32 api_version,
+					sacapi_u32 * version_available )
+/**********************************************************************/
+{
+    if( !startCapture() ) {
+	if( version_available != NULL ) {
+	    *version_available = 0;
+	}
+	return false;
+    }
+    return real.sqlany_init( app_name, api_version, version_available );
+}
+
+CAPTURE_EXPORT void sqlany_fini()
+/*******************************/
+{
+    if( real.initialized ) {
+	real.sqlany_fini();
+	sqlany_finalize_interface( &real );
+    }
+    closeCapture();
+}
+
+CAPTURE_EXPORT a_sqlany_connection * sqlany_new_connection( void )
+/****************************************************************/
+{
+    return real.sqlany_new_connection();
+}
+
+CAPTURE_EXPORT void sqlany_free_connection( a_sqlany_connection *sqlany_conn )
+/****************************************************************************/
+{
+    {
+	std::lock_guard<std::mutex> lock( captureLock );
+	connIds.erase( sqlany_conn );
+    }
+    real.sqlany_free_connection( sqlany_conn );
+}
+
+CAPTURE_EXPORT a_sqlany_connection * sqlany_make_connection( void * arg )
+/***********************************************************************/
+{
+    return real.sqlany_make_connection( arg );
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_connect( a_sqlany_connection * sqlany_conn,
+					   const char * str )
+/****************************************************************************/
+{
+    captureClock::time_point start = captureClock::now();
+    sacapi_bool ok = real.sqlany_connect( sqlany_conn, str );
+    // the connection string is not recorded, since it holds the password
+    recordStatus( REC_CONNECT, connId( sqlany_conn ), elapsedSince( start ), ok );
+    return ok;
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_disconnect( a_sqlany_connection * sqlany_conn )
+/*******************************************************************************/
+{
+    return real.sqlany_disconnect( sqlany_conn );
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_execute_immediate( a_sqlany_connection * sqlany_conn,
+						     const char * sql )
+/*************************************************************************************/
+{
+    return real.sqlany_execute_immediate( sqlany_conn, sql );
+}
+
+CAPTURE_EXPORT a_sqlany_stmt * sqlany_prepare( a_sqlany_connection * sqlany_conn,
+					       const char * sql_str )
+/****************************************************************************/
+{
+    captureClock::time_point start = captureClock::now();
+    a_sqlany_stmt *stmt = real.sqlany_prepare( sqlany_conn, sql_str );
+    uint32_t elapsed = elapsedSince( start );
+    if( stmt == NULL ) {
+	return NULL;
+    }
+
+    uint32_t conn_id = connId( sqlany_conn );
+    stmtInfo info;
+    info.conn = sqlany_conn;
+    info.batch_size = 1;
+    {
+	std::lock_guard<std::mutex> lock( captureLock );
+	info.id = nextId++;
+	stmtInfos[stmt] = info;
+    }
+    recordWriter payload;
+    payload.put32( conn_id );
+    payload.putString( sql_str );
+    writeRecord( REC_PREPARE, info.id, elapsed, payload );
+    return stmt;
+}
+
+CAPTURE_EXPORT void sqlany_free_stmt( a_sqlany_stmt * sqlany_stmt )
+/*****************************************************************/
+{
+    stmtInfo info;
+    if( findStmt( sqlany_stmt, info ) ) {
+	writeRecord( REC_FREE, info.id, 0, recordWriter() );
+	std::lock_guard<std::mutex> lock( captureLock );
+	stmtInfos.erase( sqlany_stmt );
+    }
+    real.sqlany_free_stmt( sqlany_stmt );
+}
+
+CAPTURE_EXPORT sacapi_i32 sqlany_num_params( a_sqlany_stmt * sqlany_stmt )
+/************************************************************************/
+{
+    return real.sqlany_num_params( sqlany_stmt );
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_describe_bind_param( a_sqlany_stmt * sqlany_stmt,
+						       sacapi_u32 index,
+						       a_sqlany_bind_param * param )
+/**********************************************************************************/
+{
+    return real.sqlany_describe_bind_param( sqlany_stmt, index, param );
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_bind_param( a_sqlany_stmt * sqlany_stmt,
+					      sacapi_u32 index,
+					      a_sqlany_bind_param * param )
+/*****************************************************************************/
+{
+    sacapi_bool ok = real.sqlany_bind_param( sqlany_stmt, index, param );
+    if( ok ) {
+	// recorded at execute time, once the batch size is known
+	std::lock_guard<std::mutex> lock( captureLock );
+	std::map<a_sqlany_stmt *, stmtInfo>::iterator it = stmtInfos.find( sqlany_stmt );
+	if( it != stmtInfos.end() ) {
+	    if( it->second.params.size() <= index ) {
+		it->second.params.resize( index + 1 );
+	    }
+	    it->second.params[index] = param->value;
+	}
+    }
+    return ok;
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_send_param_data( a_sqlany_stmt * sqlany_stmt,
+						   sacapi_u32 index,
+						   char * buffer, size_t size )
+/*****************************************************************************/
+{
+    return real.sqlany_send_param_data( sqlany_stmt, index, buffer, size );
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_reset( a_sqlany_stmt * sqlany_stmt )
+/********************************************************************/
+{
+    {
+	// the driver sets the batch size again after binding wide rows
+	std::lock_guard<std::mutex> lock( captureLock );
+	std::map<a_sqlany_stmt *, stmtInfo>::iterator it = stmtInfos.find( sqlany_stmt );
+	if( it != stmtInfos.end() ) {
+	    it->second.batch_size = 1;
+	    it->second.params.clear();
+	}
+    }
+    return real.sqlany_reset( sqlany_stmt );
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_get_bind_param_info( a_sqlany_stmt * sqlany_stmt,
+						       sacapi_u32 index,
+						       a_sqlany_bind_param_info * info )
+/**************************************************************************************/
+{
+    return real.sqlany_get_bind_param_info( sqlany_stmt, index, info );
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_execute( a_sqlany_stmt * sqlany_stmt )
+/**********************************************************************/
+{
+    stmtInfo bound;
+    if( findStmt( sqlany_stmt, bound ) ) {
+	recordBinds( bound );
+    }
+    captureClock::time_point start = captureClock::now();
+    sacapi_bool ok = real.sqlany_execute( sqlany_stmt );
+    uint32_t elapsed = elapsedSince( start );
+
+    stmtInfo info;
+    if( !findStmt( sqlany_stmt, info ) ) {
+	return ok;
+    }
+    std::string msg;
+    sacapi_i32 sqlcode = ok ? 0 : lastError( info.conn, &msg );
+    recordWriter payload;
+    payload.put8( ok ? 1 : 0 );
+    payload.put32( (uint32_t)( ok ? real.sqlany_affected_rows( sqlany_stmt ) : -1 ) );
+    payload.put32( (uint32_t)sqlcode );
+    payload.putString( msg );
+    writeRecord( REC_EXECUTE, info.id, elapsed, payload );
+    if( ok ) {
+	recordColumns( sqlany_stmt, info.id );
+    }
+    return ok;
+}
+
+CAPTURE_EXPORT a_sqlany_stmt * sqlany_execute_direct( a_sqlany_connection * sqlany_conn,
+						      const char * sql_str )
+/****************************************************************************************/
+{
+    return real.sqlany_execute_direct( sqlany_conn, sql_str );
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_fetch_absolute( a_sqlany_stmt * sqlany_stmt,
+						  sacapi_i32 row_num )
+/*******************************************************************************/
+{
+    return real.sqlany_fetch_absolute( sqlany_stmt, row_num );
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_fetch_next( a_sqlany_stmt * sqlany_stmt )
+/*************************************************************************/
+{
+    captureClock::time_point start = captureClock::now();
+    sacapi_bool ok = real.sqlany_fetch_next( sqlany_stmt );
+    uint32_t elapsed = elapsedSince( start );
+
+    stmtInfo info;
+    if( !findStmt( sqlany_stmt, info ) ) {
+	return ok;
+    }
+    if( ok ) {
+	recordRow( sqlany_stmt, info.id, elapsed );
+    } else {
+	recordWriter payload;
+	payload.put32( (uint32_t)lastError( info.conn, NULL ) );
+	writeRecord( REC_END, info.id, elapsed, payload );
+    }
+    return ok;
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_get_next_result( a_sqlany_stmt * sqlany_stmt )
+/******************************************************************************/
+{
+    captureClock::time_point start = captureClock::now();
+    sacapi_bool ok = real.sqlany_get_next_result( sqlany_stmt );
+    uint32_t elapsed = elapsedSince( start );
+
+    stmtInfo info;
+    if( !findStmt( sqlany_stmt, info ) ) {
+	return ok;
+    }
+    recordWriter payload;
+    payload.put8( ok ? 1 : 0 );
+    payload.put32( (uint32_t)( ok ? 0 : lastError( info.conn, NULL ) ) );
+    writeRecord( REC_NEXT_RESULT, info.id, elapsed, payload );
+    if( ok ) {
+	recordColumns( sqlany_stmt, info.id );
+    }
+    return ok;
+}
+
+CAPTURE_EXPORT sacapi_i32 sqlany_affected_rows( a_sqlany_stmt * sqlany_stmt )
+/***************************************************************************/
+{
+    return real.sqlany_affected_rows( sqlany_stmt );
+}
+
+CAPTURE_EXPORT sacapi_i32 sqlany_num_cols( a_sqlany_stmt * sqlany_stmt )
+/**********************************************************************/
+{
+    return real.sqlany_num_cols( sqlany_stmt );
+}
+
+CAPTURE_EXPORT sacapi_i32 sqlany_num_rows( a_sqlany_stmt * sqlany_stmt )
+/**********************************************************************/
+{
+    return real.sqlany_num_rows( sqlany_stmt );
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_get_column( a_sqlany_stmt * sqlany_stmt,
+					      sacapi_u32 col_index,
+					      a_sqlany_data_value * buffer )
+/*****************************************************************************/
+{
+    return real.sqlany_get_column( sqlany_stmt, col_index, buffer );
+}
+
+CAPTURE_EXPORT sacapi_i32 sqlany_get_data( a_sqlany_stmt * sqlany_stmt,
+					   sacapi_u32 col_index, size_t offset,
+					   void * buffer, size_t size )
+/**************************************************************************/
+{
+    return real.sqlany_get_data( sqlany_stmt, col_index, offset, buffer, size );
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_get_data_info( a_sqlany_stmt * sqlany_stmt,
+						 sacapi_u32 col_index,
+						 a_sqlany_data_info * buffer )
+/********************************************************************************/
+{
+    return real.sqlany_get_data_info( sqlany_stmt, col_index, buffer );
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_get_column_info( a_sqlany_stmt * sqlany_stmt,
+						   sacapi_u32 col_index,
+						   a_sqlany_column_info * buffer )
+/**********************************************************************************/
+{
+    return real.sqlany_get_column_info( sqlany_stmt, col_index, buffer );
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_commit( a_sqlany_connection * sqlany_conn )
+/***************************************************************************/
+{
+    captureClock::time_point start = captureClock::now();
+    sacapi_bool ok = real.sqlany_commit( sqlany_conn );
+    recordStatus( REC_COMMIT, connId( sqlany_conn ), elapsedSince( start ), ok );
+    return ok;
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_rollback( a_sqlany_connection * sqlany_conn )
+/*****************************************************************************/
+{
+    captureClock::time_point start = captureClock::now();
+    sacapi_bool ok = real.sqlany_rollback( sqlany_conn );
+    recordStatus( REC_ROLLBACK, connId( sqlany_conn ), elapsedSince( start ), ok );
+    return ok;
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_client_version( char * buffer, size_t len )
+/***************************************************************************/
+{
+    return real.sqlany_client_version( buffer, len );
+}
+
+CAPTURE_EXPORT sacapi_i32 sqlany_error( a_sqlany_connection * sqlany_conn,
+					char * buffer, size_t size )
+/************************************************************************/
+{
+    if( !real.initialized ) {
+	if( buffer != NULL && size > 0 ) {
+	    snprintf( buffer, size, "Capture needs SQLANY_CAPTURE_FILE and the real dbcapi library" );
+	}
+	return -2004;
+    }
+    return real.sqlany_error( sqlany_conn, buffer, size );
+}
+
+CAPTURE_EXPORT size_t sqlany_sqlstate( a_sqlany_connection * sqlany_conn,
+				       char * buffer, size_t size )
+/***********************************************************************/
+{
+    return real.sqlany_sqlstate( sqlany_conn, buffer, size );
+}
+
+CAPTURE_EXPORT void sqlany_clear_error( a_sqlany_connection * sqlany_conn )
+/*************************************************************************/
+{
+    real.sqlany_clear_error( sqlany_conn );
+}
+
+CAPTURE_EXPORT void sqlany_cancel( a_sqlany_connection * sqlany_conn )
+/********************************************************************/
+{
+    if( real.sqlany_cancel != NULL ) {
+	real.sqlany_cancel( sqlany_conn );
+    }
+}
+
+CAPTURE_EXPORT sacapi_bool sqlany_set_batch_size( a_sqlany_stmt * sqlany_stmt,
+						  sacapi_u32 num_rows )
+/********************************************************************************/
+{
+    if( real.sqlany_set_batch_size == NULL ) {
+	return false;
+    }
+    sacapi_bool ok = real.sqlany_set_batch_size( sqlany_stmt, num_rows );
+    if( ok ) {
+	std::lock_guard<std::mutex> lock( captureLock );
+	std::map<a_sqlany_stmt *, stmtInfo>::iterator it = stmtInfos.find( sqlany_stmt );
+	if( it != stmtInfos.end() ) {
+	    it->second.batch_size = num_rows;
+	}
+    }
+    return ok;
+}
+
+}
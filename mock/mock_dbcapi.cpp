@@ -0,0 +1,953 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+//
+// A stand-in for the dbcapi client library, used to benchmark the driver
+// without a database server. Point SQLANY_API_DLL at the built library and
+// the driver loads it in place of libdbcapi.
+//
+// Every query returns a synthetic result set whose shape is taken from the
+// connection string; all other keys of the connection string are ignored:
+//
+//   MockRows=n		rows in each result set (default 100)
+//   MockCols=n		columns in each result set (default 3)
+//   MockTypes=list	comma separated column types, repeated over the
+//			columns: int, bigint, double, string, binary, null
+//			(default int,string,double)
+//   MockWidth=n	bytes in each string or binary value (default 32)
+//
+// Latency, in milliseconds, can be added to the calls that would go to the
+// server, to see how the driver behaves over a network:
+//
+//   MockConnectLatency=ms	added to each sqlany_connect
+//   MockExecuteLatency=ms	added to each sqlany_execute
+//   MockFetchLatency=ms	added to every MockPrefetch'th sqlany_fetch_next
+//   MockPrefetch=n		rows per fetch round trip (default 1)
+//   MockJitter=ms		up to this much more is added to each delay,
+//				chosen at random
+//
+// A statement is a query when its text starts with SELECT, WITH or CALL.
+// Other statements return no result set and report one affected row for
+// each row of bound parameters. Bound values are read at execute time, so
+// binding costs what it would with a real client. A statement whose text
+// contains MOCK_ERROR fails to execute.
+//
+// ***************************************************************************
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+#include "sacapi.h"
+
+#if defined( _WIN32 )
+    #define MOCK_EXPORT __declspec( dllexport )
+    #define strcasecmp _stricmp
+#else
+    #define MOCK_EXPORT __attribute__(( visibility( "default" ) ))
+#endif
+
+#define MOCK_SQLE_NOTFOUND		100
+#define MOCK_SQLE_PROCEDURE_COMPLETE	105
+#define MOCK_SQLE_SYNTAX_ERROR		-131
+#define MOCK_SQLE_NOT_CONNECTED		-101
+
+enum mockColumnType {
+    MOCK_INT,
+    MOCK_BIGINT,
+    MOCK_DOUBLE,
+    MOCK_STRING,
+    MOCK_BINARY,
+    MOCK_NULL
+};
+
+struct mockConfig {
+    unsigned			rows;
+    unsigned			cols;
+    unsigned			width;
+    std::vector<mockColumnType>	types;
+    double			connect_latency;
+    double			execute_latency;
+    double			fetch_latency;
+    unsigned			prefetch;
+    double			jitter;
+
+    mockConfig() {
+	rows = 100;
+	cols = 3;
+	width = 32;
+	connect_latency = 0;
+	execute_latency = 0;
+	fetch_latency = 0;
+	prefetch = 1;
+	jitter = 0;
+	types.push_back( MOCK_INT );
+	types.push_back( MOCK_STRING );
+	types.push_back( MOCK_DOUBLE );
+    }
+
+    mockColumnType type( unsigned col ) const {
+	return types[col % types.size()];
+    }
+};
+
+struct a_sqlany_connection {
+    mockConfig		config;
+    bool		connected;
+    sacapi_i32		sqlcode;
+    std::string		error;
+    unsigned		random;
+};
+
+struct mockColumn {
+    std::string		name;
+    mockColumnType	type;
+    int			int32_value;
+    long long		int_value;
+    double		double_value;
+    std::vector<char>	bytes;
+    size_t		length;
+    sacapi_bool		is_null;
+};
+
+struct a_sqlany_stmt {
+    a_sqlany_connection			*conn;
+    std::string				sql;
+    bool				is_query;
+    unsigned				num_params;
+    std::vector<a_sqlany_data_value>	params;
+    sacapi_u32				batch_size;
+
+    // current result set
+    bool				executed;
+    unsigned				row;
+    std::vector<mockColumn>		columns;
+    sacapi_i32				affected_rows;
+};
+
+static a_sqlany_interface_context *mockContext =
+    (a_sqlany_interface_context *)&mockContext;
+
+static void setError( a_sqlany_connection *conn, sacapi_i32 sqlcode,
+		      const char *msg )
+/*******************************************************************/
+{
+    if( conn == NULL ) {
+	return;
+    }
+    conn->sqlcode = sqlcode;
+    conn->error = msg;
+}
+
+// Sleeps for ms milliseconds plus the connection's jitter, as if waiting
+// on a round trip to the server
+static void delay( a_sqlany_connection *conn, double ms )
+/*******************************************************/
+{
+    if( ms <= 0 ) {
+	return;
+    }
+    if( conn->config.jitter > 0 ) {
+	// xorshift; each connection is only used by one thread at a time
+	unsigned x = conn->random;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	conn->random = x;
+	ms += conn->config.jitter * ( x % 10001 ) / 10000.0;
+    }
+    std::this_thread::sleep_for(
+	std::chrono::microseconds( (long long)( ms * 1000 ) ) );
+}
+
+static bool startsWithWord( const std::string &sql, const char *word )
+/********************************************************************/
+{
+    size_t i = 0;
+    while( i < sql.length() && isspace( (unsigned char)sql[i] ) ) {
+	i++;
+    }
+    size_t len = strlen( word );
+    if( sql.length() - i < len ) {
+	return false;
+    }
+    for( size_t j = 0; j < len; j++ ) {
+	if( toupper( (unsigned char)sql[i + j] ) != word[j] ) {
+	    return false;
+	}
+    }
+    return i + len == sql.length() || !isalnum( (unsigned char)sql[i + len] );
+}
+
+static bool containsWord( const std::string &sql, const char *word )
+/******************************************************************/
+{
+    std::string upper( sql );
+    for( size_t i = 0; i < upper.length(); i++ ) {
+	upper[i] = (char)toupper( (unsigned char)upper[i] );
+    }
+    return upper.find( word ) != std::string::npos;
+}
+
+// Counts the ? placeholders that are outside quotes
+static unsigned countParams( const std::string &sql )
+/***************************************************/
+{
+    unsigned count = 0;
+    char quote = 0;
+    for( size_t i = 0; i < sql.length(); i++ ) {
+	char c = sql[i];
+	if( quote != 0 ) {
+	    if( c == quote ) {
+		quote = 0;
+	    }
+	} else if( c == '\'' || c == '"' ) {
+	    quote = c;
+	} else if( c == '?' ) {
+	    count++;
+	}
+    }
+    return count;
+}
+
+static bool parseType( const std::string &name, mockColumnType &type )
+/********************************************************************/
+{
+    static const struct {
+	const char	*name;
+	mockColumnType	type;
+    } names[] = {
+	{ "int", MOCK_INT }, { "bigint", MOCK_BIGINT },
+	{ "double", MOCK_DOUBLE }, { "string", MOCK_STRING },
+	{ "binary", MOCK_BINARY }, { "null", MOCK_NULL }
+    };
+    for( size_t i = 0; i < sizeof( names ) / sizeof( names[0] ); i++ ) {
+	if( strcasecmp( name.c_str(), names[i].name ) == 0 ) {
+	    type = names[i].type;
+	    return true;
+	}
+    }
+    return false;
+}
+
+static bool parseConnectString( const char *str, mockConfig &config )
+/*******************************************************************/
+{
+    std::string s( str != NULL ? str : "" );
+    size_t pos = 0;
+    while( pos < s.length() ) {
+	size_t end = s.find( ';', pos );
+	if( end == std::string::npos ) {
+	    end = s.length();
+	}
+	std::string item = s.substr( pos, end - pos );
+	pos = end + 1;
+
+	size_t eq = item.find( '=' );
+	if( eq == std::string::npos ) {
+	    continue;
+	}
+	std::string key = item.substr( 0, eq );
+	std::string value = item.substr( eq + 1 );
+	while( key.length() > 0 && isspace( (unsigned char)key[0] ) ) {
+	    key.erase( 0, 1 );
+	}
+
+	if( strcasecmp( key.c_str(), "MockRows" ) == 0 ) {
+	    config.rows = (unsigned)strtoul( value.c_str(), NULL, 10 );
+	} else if( strcasecmp( key.c_str(), "MockCols" ) == 0 ) {
+	    config.cols = (unsigned)strtoul( value.c_str(), NULL, 10 );
+	} else if( strcasecmp( key.c_str(), "MockWidth" ) == 0 ) {
+	    config.width = (unsigned)strtoul( value.c_str(), NULL, 10 );
+	} else if( strcasecmp( key.c_str(), "MockConnectLatency" ) == 0 ) {
+	    config.connect_latency = strtod( value.c_str(), NULL );
+	} else if( strcasecmp( key.c_str(), "MockExecuteLatency" ) == 0 ) {
+	    config.execute_latency = strtod( value.c_str(), NULL );
+	} else if( strcasecmp( key.c_str(), "MockFetchLatency" ) == 0 ) {
+	    config.fetch_latency = strtod( value.c_str(), NULL );
+	} else if( strcasecmp( key.c_str(), "MockPrefetch" ) == 0 ) {
+	    config.prefetch = (unsigned)strtoul( value.c_str(), NULL, 10 );
+	    if( config.prefetch == 0 ) {
+		config.prefetch = 1;
+	    }
+	} else if( strcasecmp( key.c_str(), "MockJitter" ) == 0 ) {
+	    config.jitter = strtod( value.c_str(), NULL );
+	} else if( strcasecmp( key.c_str(), "MockTypes" ) == 0 ) {
+	    std::vector<mockColumnType> types;
+	    size_t tpos = 0;
+	    while( tpos <= value.length() ) {
+		size_t comma = value.find( ',', tpos );
+		if( comma == std::string::npos ) {
+		    comma = value.length();
+		}
+		mockColumnType type;
+		if( !parseType( value.substr( tpos, comma - tpos ), type ) ) {
+		    return false;
+		}
+		types.push_back( type );
+		tpos = comma + 1;
+	    }
+	    config.types = types;
+	}
+    }
+    return config.types.size() > 0;
+}
+
+static void describeColumns( a_sqlany_stmt *stmt )
+/************************************************/
+{
+    const mockConfig &config = stmt->conn->config;
+    stmt->columns.resize( config.cols );
+    for( unsigned i = 0; i < config.cols; i++ ) {
+	mockColumn &column = stmt->columns[i];
+	char name[32];
+	snprintf( name, sizeof( name ), "col%u", i + 1 );
+	column.name = name;
+	column.type = config.type( i );
+	column.is_null = column.type == MOCK_NULL;
+	column.length = 0;
+	if( column.type == MOCK_STRING || column.type == MOCK_BINARY ) {
+	    column.bytes.resize( config.width > 0 ? config.width : 1 );
+	}
+    }
+}
+
+// Fills the column buffers with the values of the current row
+static void generateRow( a_sqlany_stmt *stmt )
+/********************************************/
+{
+    unsigned row = stmt->row;
+    unsigned width = stmt->conn->config.width;
+    for( size_t i = 0; i < stmt->columns.size(); i++ ) {
+	mockColumn &column = stmt->columns[i];
+	switch( column.type ) {
+	    case MOCK_INT:
+		column.int32_value = (int)( row * stmt->columns.size() + i );
+		break;
+	    case MOCK_BIGINT:
+		column.int_value = (long long)row * 1000003LL + (long long)i;
+		break;
+	    case MOCK_DOUBLE:
+		column.double_value = row + i / 10.0;
+		break;
+	    case MOCK_STRING:
+		for( unsigned j = 0; j < width; j++ ) {
+		    column.bytes[j] = (char)( 'a' + ( row + i + j ) % 26 );
+		}
+		column.length = width;
+		break;
+	    case MOCK_BINARY:
+		for( unsigned j = 0; j < width; j++ ) {
+		    column.bytes[j] = (char)( row + i + j );
+		}
+		column.length = width;
+		break;
+	    case MOCK_NULL:
+		break;
+	}
+    }
+}
+
+// Reads every bound value, as a client library would to send it
+static unsigned long consumeParams( a_sqlany_stmt *stmt )
+/*******************************************************/
+{
+    unsigned long sum = 0;
+    sacapi_u32 rows = stmt->batch_size > 0 ? stmt->batch_size : 1;
+    for( size_t i = 0; i < stmt->params.size(); i++ ) {
+	a_sqlany_data_value &value = stmt->params[i];
+	if( value.buffer == NULL ) {
+	    continue;
+	}
+	for( sacapi_u32 r = 0; r < rows; r++ ) {
+	    if( value.is_null != NULL && value.is_null[r] ) {
+		continue;
+	    }
+	    size_t len;
+	    const char *data;
+	    if( value.type == A_STRING || value.type == A_BINARY ) {
+		len = value.length != NULL ? value.length[r] : 0;
+		data = value.is_address ? ((char **)value.buffer)[r] :
+					  value.buffer;
+	    } else {
+		len = value.type == A_DOUBLE ? sizeof( double ) : sizeof( int );
+		data = value.buffer + r * len;
+	    }
+	    if( data == NULL ) {
+		continue;
+	    }
+	    for( size_t j = 0; j < len; j++ ) {
+		sum += (unsigned char)data[j];
+	    }
+	}
+    }
+    return sum;
+}
+
+extern "C" {
+
+MOCK_EXPORT sacapi_bool sqlany_init( const char * app_name,
+				     sacapi_u32 api_version,
+				     sacapi_u32 * version_available )
+/*******************************************************************/
+{
+    if( version_available != NULL ) {
+	*version_available = SQLANY_API_VERSION_5;
+    }
+    return api_version <= SQLANY_API_VERSION_5;
+}
+
+MOCK_EXPORT void sqlany_fini()
+/****************************/
+{
+}
+
+MOCK_EXPORT a_sqlany_connection * sqlany_new_connection( void )
+/*************************************************************/
+{
+    a_sqlany_connection *conn = new a_sqlany_connection;
+    conn->connected = false;
+    conn->sqlcode = 0;
+    conn->random = (unsigned)( (size_t)conn >> 4 ) | 1;
+    return conn;
+}
+
+MOCK_EXPORT void sqlany_free_connection( a_sqlany_connection *sqlany_conn )
+/*************************************************************************/
+{
+    delete sqlany_conn;
+}
+
+MOCK_EXPORT a_sqlany_connection * sqlany_make_connection( void * arg )
+/********************************************************************/
+{
+    a_sqlany_connection *conn = sqlany_new_connection();
+    conn->connected = true;
+    return conn;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_connect( a_sqlany_connection * sqlany_conn,
+					const char * str )
+/*************************************************************************/
+{
+    if( !parseConnectString( str, sqlany_conn->config ) ) {
+	setError( sqlany_conn, -95, "Parse error: Invalid MockTypes" );
+	return false;
+    }
+    delay( sqlany_conn, sqlany_conn->config.connect_latency );
+    sqlany_conn->connected = true;
+    setError( sqlany_conn, 0, "" );
+    return true;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_disconnect( a_sqlany_connection * sqlany_conn )
+/****************************************************************************/
+{
+    sqlany_conn->connected = false;
+    return true;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_execute_immediate( a_sqlany_connection * sqlany_conn,
+						  const char * sql )
+/**********************************************************************************/
+{
+    if( containsWord( sql, "MOCK_ERROR" ) ) {
+	setError( sqlany_conn, MOCK_SQLE_SYNTAX_ERROR, "Syntax error near 'MOCK_ERROR'" );
+	return false;
+    }
+    setError( sqlany_conn, 0, "" );
+    return true;
+}
+
+MOCK_EXPORT a_sqlany_stmt * sqlany_prepare( a_sqlany_connection * sqlany_conn,
+					    const char * sql_str )
+/*************************************************************************/
+{
+    if( !sqlany_conn->connected ) {
+	setError( sqlany_conn, MOCK_SQLE_NOT_CONNECTED, "Not connected to a database" );
+	return NULL;
+    }
+    a_sqlany_stmt *stmt = new a_sqlany_stmt;
+    stmt->conn = sqlany_conn;
+    stmt->sql = sql_str;
+    stmt->is_query = startsWithWord( stmt->sql, "SELECT" ) ||
+		     startsWithWord( stmt->sql, "WITH" ) ||
+		     startsWithWord( stmt->sql, "CALL" );
+    stmt->num_params = countParams( stmt->sql );
+    // resize() zeroes the new entries, and a statement may have no params
+    stmt->params.resize( stmt->num_params );
+    stmt->batch_size = 1;
+    stmt->executed = false;
+    stmt->row = 0;
+    stmt->affected_rows = -1;
+    setError( sqlany_conn, 0, "" );
+    return stmt;
+}
+
+MOCK_EXPORT void sqlany_free_stmt( a_sqlany_stmt * sqlany_stmt )
+/**************************************************************/
+{
+    delete sqlany_stmt;
+}
+
+MOCK_EXPORT sacapi_i32 sqlany_num_params( a_sqlany_stmt * sqlany_stmt )
+/*********************************************************************/
+{
+    return (sacapi_i32)sqlany_stmt->num_params;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_describe_bind_param( a_sqlany_stmt * sqlany_stmt,
+						    sacapi_u32 index,
+						    a_sqlany_bind_param * param )
+/*******************************************************************************/
+{
+    static char name[] = "?";
+    if( index >= sqlany_stmt->num_params ) {
+	setError( sqlany_stmt->conn, -188, "Not enough values for host variables" );
+	return false;
+    }
+    memset( param, 0, sizeof( *param ) );
+    param->direction = DD_INPUT;
+    param->value.type = A_STRING;
+    param->name = name;
+    return true;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_bind_param( a_sqlany_stmt * sqlany_stmt,
+					   sacapi_u32 index,
+					   a_sqlany_bind_param * param )
+/**************************************************************************/
+{
+    if( index >= sqlany_stmt->num_params ) {
+	setError( sqlany_stmt->conn, -188, "Not enough values for host variables" );
+	return false;
+    }
+    sqlany_stmt->params[index] = param->value;
+    return true;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_send_param_data( a_sqlany_stmt * sqlany_stmt,
+						sacapi_u32 index,
+						char * buffer, size_t size )
+/**************************************************************************/
+{
+    return index < sqlany_stmt->num_params;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_reset( a_sqlany_stmt * sqlany_stmt )
+/*****************************************************************/
+{
+    sqlany_stmt->executed = false;
+    sqlany_stmt->row = 0;
+    sqlany_stmt->columns.clear();
+    sqlany_stmt->affected_rows = -1;
+    return true;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_get_bind_param_info( a_sqlany_stmt * sqlany_stmt,
+						    sacapi_u32 index,
+						    a_sqlany_bind_param_info * info )
+/*******************************************************************************/
+{
+    static char name[] = "?";
+    if( index >= sqlany_stmt->num_params ) {
+	return false;
+    }
+    memset( info, 0, sizeof( *info ) );
+    info->name = name;
+    info->direction = DD_INPUT;
+    info->input_value = sqlany_stmt->params[index];
+    return true;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_execute( a_sqlany_stmt * sqlany_stmt )
+/*******************************************************************/
+{
+    a_sqlany_connection *conn = sqlany_stmt->conn;
+    if( !conn->connected ) {
+	setError( conn, MOCK_SQLE_NOT_CONNECTED, "Not connected to a database" );
+	return false;
+    }
+    if( containsWord( sqlany_stmt->sql, "MOCK_ERROR" ) ) {
+	setError( conn, MOCK_SQLE_SYNTAX_ERROR, "Syntax error near 'MOCK_ERROR'" );
+	return false;
+    }
+
+    volatile unsigned long sum = consumeParams( sqlany_stmt );
+    (void)sum;
+    delay( conn, conn->config.execute_latency );
+
+    sqlany_stmt->executed = true;
+    sqlany_stmt->row = 0;
+    if( sqlany_stmt->is_query ) {
+	describeColumns( sqlany_stmt );
+	sqlany_stmt->affected_rows = -1;
+    } else {
+	sqlany_stmt->columns.clear();
+	sqlany_stmt->affected_rows = (sacapi_i32)sqlany_stmt->batch_size;
+    }
+    setError( conn, 0, "" );
+    return true;
+}
+
+MOCK_EXPORT a_sqlany_stmt * sqlany_execute_direct( a_sqlany_connection * sqlany_conn,
+						   const char * sql_str )
+/*************************************************************************************/
+{
+    a_sqlany_stmt *stmt = sqlany_prepare( sqlany_conn, sql_str );
+    if( stmt != NULL && !sqlany_execute( stmt ) ) {
+	sqlany_free_stmt( stmt );
+	return NULL;
+    }
+    return stmt;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_fetch_next( a_sqlany_stmt * sqlany_stmt )
+/**********************************************************************/
+{
+    if( !sqlany_stmt->executed || sqlany_stmt->columns.size() == 0 ||
+	sqlany_stmt->row >= sqlany_stmt->conn->config.rows ) {
+	setError( sqlany_stmt->conn, MOCK_SQLE_NOTFOUND, "Row not found" );
+	return false;
+    }
+    if( sqlany_stmt->row % sqlany_stmt->conn->config.prefetch == 0 ) {
+	delay( sqlany_stmt->conn, sqlany_stmt->conn->config.fetch_latency );
+    }
+    generateRow( sqlany_stmt );
+    sqlany_stmt->row++;
+    return true;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_fetch_absolute( a_sqlany_stmt * sqlany_stmt,
+					       sacapi_i32 row_num )
+/****************************************************************************/
+{
+    if( row_num < 1 ) {
+	setError( sqlany_stmt->conn, MOCK_SQLE_NOTFOUND, "Row not found" );
+	return false;
+    }
+    sqlany_stmt->row = (unsigned)( row_num - 1 );
+    return sqlany_fetch_next( sqlany_stmt );
+}
+
+MOCK_EXPORT sacapi_bool sqlany_get_next_result( a_sqlany_stmt * sqlany_stmt )
+/***************************************************************************/
+{
+    setError( sqlany_stmt->conn, MOCK_SQLE_PROCEDURE_COMPLETE,
+	      "Procedure has completed" );
+    return false;
+}
+
+MOCK_EXPORT sacapi_i32 sqlany_affected_rows( a_sqlany_stmt * sqlany_stmt )
+/************************************************************************/
+{
+    return sqlany_stmt->affected_rows;
+}
+
+MOCK_EXPORT sacapi_i32 sqlany_num_cols( a_sqlany_stmt * sqlany_stmt )
+/*******************************************************************/
+{
+    if( !sqlany_stmt->executed && sqlany_stmt->is_query ) {
+	return (sacapi_i32)sqlany_stmt->conn->config.cols;
+    }
+    return (sacapi_i32)sqlany_stmt->columns.size();
+}
+
+MOCK_EXPORT sacapi_i32 sqlany_num_rows( a_sqlany_stmt * sqlany_stmt )
+/*******************************************************************/
+{
+    return sqlany_stmt->columns.size() > 0 ?
+	   (sacapi_i32)sqlany_stmt->conn->config.rows : 0;
+}
+
+static a_sqlany_data_type dataType( mockColumnType type )
+/*******************************************************/
+{
+    switch( type ) {
+	case MOCK_INT:		return A_VAL32;
+	case MOCK_BIGINT:	return A_VAL64;
+	case MOCK_DOUBLE:	return A_DOUBLE;
+	case MOCK_BINARY:	return A_BINARY;
+	default:		return A_STRING;
+    }
+}
+
+MOCK_EXPORT sacapi_bool sqlany_get_column( a_sqlany_stmt * sqlany_stmt,
+					   sacapi_u32 col_index,
+					   a_sqlany_data_value * buffer )
+/**************************************************************************/
+{
+    if( col_index >= sqlany_stmt->columns.size() || sqlany_stmt->row == 0 ) {
+	setError( sqlany_stmt->conn, -143, "Column not found" );
+	return false;
+    }
+    mockColumn &column = sqlany_stmt->columns[col_index];
+    memset( buffer, 0, sizeof( *buffer ) );
+    buffer->type = dataType( column.type );
+    buffer->is_null = &column.is_null;
+    switch( column.type ) {
+	case MOCK_INT:
+	    buffer->buffer = (char *)&column.int32_value;
+	    column.length = sizeof( int );
+	    break;
+	case MOCK_BIGINT:
+	    buffer->buffer = (char *)&column.int_value;
+	    column.length = sizeof( long long );
+	    break;
+	case MOCK_DOUBLE:
+	    buffer->buffer = (char *)&column.double_value;
+	    column.length = sizeof( double );
+	    break;
+	case MOCK_STRING:
+	case MOCK_BINARY:
+	case MOCK_NULL:
+	    buffer->buffer = column.bytes.size() > 0 ? &column.bytes[0] : NULL;
+	    break;
+    }
+    buffer->buffer_size = column.length;
+    buffer->length = &column.length;
+    return true;
+}
+
+MOCK_EXPORT sacapi_i32 sqlany_get_data( a_sqlany_stmt * sqlany_stmt,
+					sacapi_u32 col_index, size_t offset,
+					void * buffer, size_t size )
+/***********************************************************************/
+{
+    a_sqlany_data_value value;
+    if( !sqlany_get_column( sqlany_stmt, col_index, &value ) ) {
+	return -1;
+    }
+    size_t length = *value.length;
+    if( *value.is_null || offset >= length ) {
+	return 0;
+    }
+    size_t count = length - offset < size ? length - offset : size;
+    memcpy( buffer, value.buffer + offset, count );
+    return (sacapi_i32)count;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_get_data_info( a_sqlany_stmt * sqlany_stmt,
+					      sacapi_u32 col_index,
+					      a_sqlany_data_info * buffer )
+/*****************************************************************************/
+{
+    a_sqlany_data_value value;
+    if( !sqlany_get_column( sqlany_stmt, col_index, &value ) ) {
+	return false;
+    }
+    buffer->type = value.type;
+    buffer->is_null = *value.is_null;
+    buffer->data_size = *value.length;
+    return true;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_get_column_info( a_sqlany_stmt * sqlany_stmt,
+						sacapi_u32 col_index,
+						a_sqlany_column_info * buffer )
+/*******************************************************************************/
+{
+    if( col_index >= sqlany_stmt->columns.size() ) {
+	setError( sqlany_stmt->conn, -143, "Column not found" );
+	return false;
+    }
+    static const a_sqlany_native_type native_types[] = {
+	DT_INT, DT_BIGINT, DT_DOUBLE, DT_VARCHAR, DT_BINARY, DT_VARCHAR
+    };
+    mockColumn &column = sqlany_stmt->columns[col_index];
+    memset( buffer, 0, sizeof( *buffer ) );
+    buffer->name = (char *)column.name.c_str();
+    buffer->type = dataType( column.type );
+    buffer->native_type = native_types[column.type];
+    buffer->max_size = column.bytes.size() > 0 ? column.bytes.size() : 8;
+    buffer->nullable = column.type == MOCK_NULL;
+    return true;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_commit( a_sqlany_connection * sqlany_conn )
+/************************************************************************/
+{
+    return sqlany_conn->connected;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_rollback( a_sqlany_connection * sqlany_conn )
+/**************************************************************************/
+{
+    return sqlany_conn->connected;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_client_version( char * buffer, size_t len )
+/************************************************************************/
+{
+    snprintf( buffer, len, "17.0.0.0 (mock)" );
+    return true;
+}
+
+MOCK_EXPORT sacapi_i32 sqlany_error( a_sqlany_connection * sqlany_conn,
+				     char * buffer, size_t size )
+/*********************************************************************/
+{
+    if( sqlany_conn == NULL ) {
+	if( buffer != NULL && size > 0 ) {
+	    buffer[0] = '\0';
+	}
+	return 0;
+    }
+    if( buffer != NULL && size > 0 ) {
+	snprintf( buffer, size, "%s", sqlany_conn->error.c_str() );
+    }
+    return sqlany_conn->sqlcode;
+}
+
+MOCK_EXPORT size_t sqlany_sqlstate( a_sqlany_connection * sqlany_conn,
+				    char * buffer, size_t size )
+/********************************************************************/
+{
+    const char *state = sqlany_conn == NULL || sqlany_conn->sqlcode >= 0 ?
+			"00000" : "HY000";
+    if( buffer != NULL && size > 0 ) {
+	snprintf( buffer, size, "%s", state );
+    }
+    return strlen( state ) + 1;
+}
+
+MOCK_EXPORT void sqlany_clear_error( a_sqlany_connection * sqlany_conn )
+/**********************************************************************/
+{
+    setError( sqlany_conn, 0, "" );
+}
+
+MOCK_EXPORT a_sqlany_interface_context *sqlany_init_ex( const char * app_name,
+							sacapi_u32 api_version,
+							sacapi_u32 * version_available )
+/***************************************************************************************/
+{
+    return sqlany_init( app_name, api_version, version_available ) ?
+	   mockContext : NULL;
+}
+
+MOCK_EXPORT void sqlany_fini_ex( a_sqlany_interface_context *context )
+/********************************************************************/
+{
+}
+
+MOCK_EXPORT a_sqlany_connection *sqlany_new_connection_ex( a_sqlany_interface_context *context )
+/**********************************************************************************************/
+{
+    return sqlany_new_connection();
+}
+
+MOCK_EXPORT a_sqlany_connection *sqlany_make_connection_ex( a_sqlany_interface_context *context,
+							    void *arg )
+/************************************************************************************************/
+{
+    return sqlany_make_connection( arg );
+}
+
+MOCK_EXPORT sacapi_bool sqlany_client_version_ex( a_sqlany_interface_context *context,
+						  char *buffer, size_t len )
+/**********************************************************************************/
+{
+    return sqlany_client_version( buffer, len );
+}
+
+MOCK_EXPORT void sqlany_cancel( a_sqlany_connection * sqlany_conn )
+/*****************************************************************/
+{
+}
+
+MOCK_EXPORT sacapi_bool sqlany_register_callback( a_sqlany_connection * sqlany_conn,
+						  a_sqlany_callback_type index,
+						  SQLANY_CALLBACK_PARM callback )
+/**********************************************************************************/
+{
+    return true;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_set_batch_size( a_sqlany_stmt * sqlany_stmt,
+					       sacapi_u32 num_rows )
+/*****************************************************************************/
+{
+    sqlany_stmt->batch_size = num_rows;
+    return true;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_set_param_bind_type( a_sqlany_stmt * sqlany_stmt,
+						    size_t row_size )
+/**********************************************************************************/
+{
+    return true;
+}
+
+MOCK_EXPORT sacapi_u32 sqlany_get_batch_size( a_sqlany_stmt * sqlany_stmt )
+/*************************************************************************/
+{
+    return sqlany_stmt->batch_size;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_set_rowset_size( a_sqlany_stmt * sqlany_stmt,
+						sacapi_u32 num_rows )
+/******************************************************************************/
+{
+    return num_rows == 1;
+}
+
+MOCK_EXPORT sacapi_u32 sqlany_get_rowset_size( a_sqlany_stmt * sqlany_stmt )
+/**************************************************************************/
+{
+    return 1;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_set_column_bind_type( a_sqlany_stmt * sqlany_stmt,
+						     sacapi_u32 row_size )
+/***********************************************************************************/
+{
+    return false;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_bind_column( a_sqlany_stmt * sqlany_stmt,
+					    sacapi_u32 index,
+					    a_sqlany_data_value * value )
+/**************************************************************************/
+{
+    return false;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_clear_column_bindings( a_sqlany_stmt * sqlany_stmt )
+/*********************************************************************************/
+{
+    return true;
+}
+
+MOCK_EXPORT sacapi_i32 sqlany_fetched_rows( a_sqlany_stmt * sqlany_stmt )
+/***********************************************************************/
+{
+    return sqlany_stmt->row > 0 ? 1 : 0;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_set_rowset_pos( a_sqlany_stmt * sqlany_stmt,
+					       sacapi_u32 row_num )
+/*****************************************************************************/
+{
+    return row_num <= 1;
+}
+
+MOCK_EXPORT sacapi_bool sqlany_reset_param_data( a_sqlany_stmt * sqlany_stmt,
+						 sacapi_u32 index )
+/*******************************************************************************/
+{
+    return index < sqlany_stmt->num_params;
+}
+
+MOCK_EXPORT size_t sqlany_error_length( a_sqlany_connection * sqlany_conn )
+/*************************************************************************/
+{
+    return sqlany_conn == NULL ? 1 : sqlany_conn->error.length() + 1;
+}
+
+}
@@ -0,0 +1,170 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+//
+// The file format written by the capture dbcapi library and read by the
+// replay dbcapi library.
+//
+// A recording starts with the 8 bytes of RECORDING_MAGIC, followed by
+// records of the form
+//
+//   u8 kind, u32 id, u32 elapsed_us, u32 length, length bytes of payload
+//
+// where id is the statement (or, for connection records, the connection)
+// the record is about and elapsed_us is the time the real call took.
+// Integers are written in the byte order of the machine that made the
+// recording. Readers skip records of kinds they do not know.
+//
+// Payloads:
+//   REC_CONNECT	u8 ok
+//   REC_PREPARE	u32 connection, SQL text
+//   REC_BIND		u32 index, u32 type, u32 rows, u64 bytes
+//   REC_EXECUTE	u8 ok, i32 affected rows, i32 sqlcode, error text
+//   REC_COLUMNS	u32 count, then per column: u32 type, u32 native type,
+//			u32 max size, u16 name length, name
+//   REC_ROW		per column: u8 type (0 when NULL), u32 length, data
+//   REC_END		i32 sqlcode returned when the last row was passed
+//   REC_NEXT_RESULT	u8 ok, i32 sqlcode
+//   REC_FREE		none
+//   REC_COMMIT		u8 ok
+//   REC_ROLLBACK	u8 ok
+//
+// Bound values are not recorded, only their types and sizes.
+//
+// ***************************************************************************
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "sacapi.h"
+
+#define RECORDING_MAGIC		"SQLAREC\1"
+#define RECORDING_MAGIC_LEN	8
+
+enum recordKind {
+    REC_CONNECT = 1,
+    REC_PREPARE,
+    REC_BIND,
+    REC_EXECUTE,
+    REC_COLUMNS,
+    REC_ROW,
+    REC_END,
+    REC_NEXT_RESULT,
+    REC_FREE,
+    REC_COMMIT,
+    REC_ROLLBACK
+};
+
+// Returns the size of a value of a fixed size type, or 0 for strings and
+// binary values
+inline size_t fixedSize( a_sqlany_data_type type )
+{
+    switch( type ) {
+	case A_VAL64:
+	case A_UVAL64:
+	case A_DOUBLE:
+	    return 8;
+	case A_VAL32:
+	case A_UVAL32:
+	    return 4;
+	case A_VAL16:
+	case A_UVAL16:
+	    return 2;
+	case A_VAL8:
+	case A_UVAL8:
+	    return 1;
+#if _SACAPI_VERSION+0 >= SQLANY_API_VERSION_5
+	case A_FLOAT:
+	    return 4;
+#endif
+	default:
+	    return 0;
+    }
+}
+
+// Builds the payload of one record
+class recordWriter {
+  public:
+    void put8( uint8_t v ) {
+	data.push_back( (char)v );
+    }
+    void put16( uint16_t v ) {
+	putBytes( &v, sizeof( v ) );
+    }
+    void put32( uint32_t v ) {
+	putBytes( &v, sizeof( v ) );
+    }
+    void put64( uint64_t v ) {
+	putBytes( &v, sizeof( v ) );
+    }
+    void putBytes( const void *p, size_t len ) {
+	data.insert( data.end(), (const char *)p, (const char *)p + len );
+    }
+    void putString( const std::string &s ) {
+	putBytes( s.data(), s.length() );
+    }
+
+    std::vector<char>	data;
+};
+
+// Reads values from the payload of one record. A read past the end
+// returns zeros and clears ok.
+class recordReader {
+  public:
+    recordReader( const char *p, size_t len ) : pos( p ), end( p + len ) {
+	ok = true;
+    }
+    uint8_t get8() {
+	uint8_t v = 0;
+	getBytes( &v, sizeof( v ) );
+	return v;
+    }
+    uint16_t get16() {
+	uint16_t v = 0;
+	getBytes( &v, sizeof( v ) );
+	return v;
+    }
+    uint32_t get32() {
+	uint32_t v = 0;
+	getBytes( &v, sizeof( v ) );
+	return v;
+    }
+    uint64_t get64() {
+	uint64_t v = 0;
+	getBytes( &v, sizeof( v ) );
+	return v;
+    }
+    void getBytes( void *p, size_t len ) {
+	if( (size_t)( end - pos ) < len ) {
+	    ok = false;
+	    pos = end;
+	    return;
+	}
+	memcpy( p, pos, len );
+	pos += len;
+    }
+    std::string getString( size_t len ) {
+	if( (size_t)( end - pos ) < len ) {
+	    ok = false;
+	    pos = end;
+	    return std::string();
+	}
+	std::string s( pos, len );
+	pos += len;
+	return s;
+    }
+    std::string rest() {
+	return getString( (size_t)( end - pos ) );
+    }
+
+    bool	ok;
+
+  private:
+    const char	*pos;
+    const char	*end;
+};
+
+#endif
@@ -0,0 +1,724 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+//
+// A dbcapi library that serves back a session recorded by the capture
+// library, so that the driver can be benchmarked against a real workload
+// without its database. Load it with SQLANY_API_DLL and set:
+//
+//   SQLANY_REPLAY_FILE		the recording to serve (required)
+//   SQLANY_REPLAY_TIMING	when 1, each execute and fetch takes as long
+//				as it did when it was recorded
+//
+// Executions are matched to the recording by their SQL text. Each time a
+// statement is executed it gets the next recorded execution of the same
+// text - its result sets, rows and errors - starting over from the first
+// once they are used up. A statement that was never recorded fails to
+// execute. Any connection string connects.
+//
+// ***************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <thread>
+
+#include "sacapi.h"
+#include "recording.h"
+
+#if defined( _WIN32 )
+    #define REPLAY_EXPORT __declspec( dllexport )
+#else
+    #define REPLAY_EXPORT __attribute__(( visibility( "default" ) ))
+#endif
+
+#define REPLAY_SQLE_NOTFOUND		100
+#define REPLAY_SQLE_PROCEDURE_COMPLETE	105
+#define REPLAY_SQLE_NOT_RECORDED	-131
+
+struct replayColumn {
+    std::string		name;
+    a_sqlany_data_type	type;
+    a_sqlany_native_type native_type;
+    size_t		max_size;
+};
+
+struct replayValue {
+    a_sqlany_data_type	type;	// A_INVALID_TYPE when NULL
+    std::string		data;
+};
+
+struct replayRow {
+    uint32_t			elapsed_us;
+    std::vector<replayValue>	values;
+};
+
+struct replayResult {
+    std::vector<replayColumn>	columns;
+    std::vector<replayRow>	rows;
+    sacapi_i32			end_sqlcode;
+    uint32_t			end_elapsed_us;
+};
+
+struct replayExecution {
+    uint32_t			elapsed_us;
+    bool			ok;
+    sacapi_i32			affected_rows;
+    sacapi_i32			sqlcode;
+    std::string			error;
+    std::vector<replayResult>	results;
+    // outcome of the get_next_result call after the last result set
+    sacapi_i32			next_sqlcode;
+};
+
+struct replaySql {
+    std::vector<replayExecution>	executions;
+    size_t				next;
+};
+
+struct a_sqlany_connection {
+    bool		connected;
+    sacapi_i32		sqlcode;
+    std::string		error;
+};
+
+struct a_sqlany_stmt {
+    a_sqlany_connection	*conn;
+    replaySql		*sql;
+    unsigned		num_params;
+    replayExecution	*execution;
+    size_t		result;
+    size_t		row;
+    // the value handed out by sqlany_get_column
+    size_t		length;
+    sacapi_bool		is_null;
+};
+
+static std::map<std::string, replaySql>	recording;
+static bool				loaded = false;
+static bool				timing = false;
+static std::mutex			replayLock;
+static a_sqlany_interface_context	*replayContext =
+    (a_sqlany_interface_context *)&replayContext;
+
+static void setError( a_sqlany_connection *conn, sacapi_i32 sqlcode,
+		      const char *msg )
+/*******************************************************************/
+{
+    if( conn != NULL ) {
+	conn->sqlcode = sqlcode;
+	conn->error = msg;
+    }
+}
+
+static void replayDelay( uint32_t elapsed_us )
+/********************************************/
+{
+    if( timing && elapsed_us > 0 ) {
+	std::this_thread::sleep_for( std::chrono::microseconds( elapsed_us ) );
+    }
+}
+
+static bool readFile( const char *name, std::vector<char> &data )
+/***************************************************************/
+{
+    FILE *f = fopen( name, "rb" );
+    if( f == NULL ) {
+	return false;
+    }
+    char buffer[65536];
+    size_t n;
+    while( ( n = fread( buffer, 1, sizeof( buffer ), f ) ) > 0 ) {
+	data.insert( data.end(), buffer, buffer + n );
+    }
+    fclose( f );
+    return true;
+}
+
+// Reads the recording into a list of executions for each SQL text
+static bool loadRecording( const char *name )
+/*******************************************/
+{
+    std::vector<char> data;
+    if( !readFile( name, data ) || data.size() < RECORDING_MAGIC_LEN ||
+	memcmp( &data[0], RECORDING_MAGIC, RECORDING_MAGIC_LEN ) != 0 ) {
+	return false;
+    }
+
+    // statement id -> its SQL text and the execution being read
+    std::map<uint32_t, std::string>		stmt_sql;
+    std::map<uint32_t, replayExecution *>	stmt_exec;
+
+    size_t pos = RECORDING_MAGIC_LEN;
+    const size_t header = 1 + 3 * sizeof( uint32_t );
+    while( data.size() - pos >= header ) {
+	recordReader head( &data[pos], header );
+	recordKind kind = (recordKind)head.get8();
+	uint32_t id = head.get32();
+	uint32_t elapsed = head.get32();
+	uint32_t len = head.get32();
+	pos += header;
+	if( data.size() - pos < len ) {
+	    break;
+	}
+	recordReader rec( len > 0 ? &data[pos] : NULL, len );
+	pos += len;
+
+	replayExecution *exec = stmt_exec.count( id ) ? stmt_exec[id] : NULL;
+	switch( kind ) {
+	    case REC_PREPARE:
+		rec.get32();
+		stmt_sql[id] = rec.rest();
+		stmt_exec.erase( id );
+		break;
+
+	    case REC_EXECUTE:
+	    {
+		if( !stmt_sql.count( id ) ) {
+		    break;
+		}
+		replaySql &sql = recording[stmt_sql[id]];
+		sql.next = 0;
+		sql.executions.push_back( replayExecution() );
+		exec = &sql.executions.back();
+		exec->elapsed_us = elapsed;
+		exec->ok = rec.get8() != 0;
+		exec->affected_rows = (sacapi_i32)rec.get32();
+		exec->sqlcode = (sacapi_i32)rec.get32();
+		exec->error = rec.rest();
+		exec->next_sqlcode = REPLAY_SQLE_PROCEDURE_COMPLETE;
+		// pointers into the vector are only kept until the next push
+		stmt_exec.clear();
+		stmt_exec[id] = exec;
+		break;
+	    }
+
+	    case REC_COLUMNS:
+	    {
+		if( exec == NULL ) {
+		    break;
+		}
+		exec->results.push_back( replayResult() );
+		replayResult &result = exec->results.back();
+		result.end_sqlcode = REPLAY_SQLE_NOTFOUND;
+		result.end_elapsed_us = 0;
+		uint32_t count = rec.get32();
+		for( uint32_t i = 0; i < count && rec.ok; i++ ) {
+		    replayColumn column;
+		    column.type = (a_sqlany_data_type)rec.get32();
+		    column.native_type = (a_sqlany_native_type)rec.get32();
+		    column.max_size = rec.get32();
+		    column.name = rec.getString( rec.get16() );
+		    result.columns.push_back( column );
+		}
+		break;
+	    }
+
+	    case REC_ROW:
+	    {
+		if( exec == NULL || exec->results.size() == 0 ) {
+		    break;
+		}
+		replayResult &result = exec->results.back();
+		replayRow row;
+		row.elapsed_us = elapsed;
+		for( size_t i = 0; i < result.columns.size() && rec.ok; i++ ) {
+		    replayValue value;
+		    value.type = (a_sqlany_data_type)rec.get8();
+		    value.data = rec.getString( rec.get32() );
+		    row.values.push_back( value );
+		}
+		result.rows.push_back( row );
+		break;
+	    }
+
+	    case REC_END:
+		if( exec != NULL && exec->results.size() > 0 ) {
+		    exec->results.back().end_sqlcode = (sacapi_i32)rec.get32();
+		    exec->results.back().end_elapsed_us = elapsed;
+		}
+		break;
+
+	    case REC_NEXT_RESULT:
+		if( exec != NULL && rec.get8() == 0 ) {
+		    exec->next_sqlcode = (sacapi_i32)rec.get32();
+		}
+		break;
+
+	    case REC_FREE:
+		stmt_sql.erase( id );
+		stmt_exec.erase( id );
+		break;
+
+	    default:
+		break;
+	}
+    }
+    return true;
+}
+
+static replayResult *currentResult( a_sqlany_stmt *stmt )
+/*******************************************************/
+{
+    if( stmt->execution == NULL ||
+	stmt->result >= stmt->execution->results.size() ) {
+	return NULL;
+    }
+    return &stmt->execution->results[stmt->result];
+}
+
+static unsigned countParams( const std::string &sql )
+/***************************************************/
+{
+    unsigned count = 0;
+    char quote = 0;
+    for( size_t i = 0; i < sql.length(); i++ ) {
+	char c = sql[i];
+	if( quote != 0 ) {
+	    if( c == quote ) {
+		quote = 0;
+	    }
+	} else if( c == '\'' || c == '"' ) {
+	    quote = c;
+	} else if( c == '?' ) {
+	    count++;
+	}
+    }
+    return count;
+}
+
+extern "C" {
+
+REPLAY_EXPORT sacapi_bool sqlany_init( const char * app_name,
+				       sacapi_u32 api_version,
+				       sacapi_u32 * version_available )
+/*********************************************************************/
+{
+    std::lock_guard<std::mutex> lock( replayLock );
+    if( version_available != NULL ) {
+	*version_available = SQLANY_API_VERSION_5;
+    }
+    if( !loaded ) {
+	const char *file = getenv( "SQLANY_REPLAY_FILE" );
+	const char *replay_timing = getenv( "SQLANY_REPLAY_TIMING" );
+	if( file == NULL || !loadRecording( file ) ) {
+	    recording.clear();
+	    return false;
+	}
+	timing = replay_timing != NULL && strcmp( replay_timing, "1" ) == 0;
+	loaded = true;
+    }
+    return api_version <= SQLANY_API_VERSION_5;
+}
+
+REPLAY_EXPORT void sqlany_fini()
+/******************************/
+{
+}
+
+REPLAY_EXPORT a_sqlany_connection * sqlany_new_connection( void )
+/***************************************************************/
+{
+    a_sqlany_connection *conn = new a_sqlany_connection;
+    conn->connected = false;
+    conn->sqlcode = 0;
+    return conn;
+}
+
+REPLAY_EXPORT void sqlany_free_connection( a_sqlany_connection *sqlany_conn )
+/***************************************************************************/
+{
+    delete sqlany_conn;
+}
+
+REPLAY_EXPORT a_sqlany_connection * sqlany_make_connection( void * arg )
+/**********************************************************************/
+{
+    a_sqlany_connection *conn = sqlany_new_connection();
+    conn->connected = true;
+    return conn;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_connect( a_sqlany_connection * sqlany_conn,
+					  const char * str )
+/***************************************************************************/
+{
+    sqlany_conn->connected = true;
+    setError( sqlany_conn, 0, "" );
+    return true;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_disconnect( a_sqlany_connection * sqlany_conn )
+/******************************************************************************/
+{
+    sqlany_conn->connected = false;
+    return true;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_execute_immediate( a_sqlany_connection * sqlany_conn,
+						    const char * sql )
+/************************************************************************************/
+{
+    return true;
+}
+
+REPLAY_EXPORT a_sqlany_stmt * sqlany_prepare( a_sqlany_connection * sqlany_conn,
+					      const char * sql_str )
+/***************************************************************************/
+{
+    a_sqlany_stmt *stmt = new a_sqlany_stmt;
+    stmt->conn = sqlany_conn;
+    {
+	std::lock_guard<std::mutex> lock( replayLock );
+	std::map<std::string, replaySql>::iterator it = recording.find( sql_str );
+	stmt->sql = it != recording.end() ? &it->second : NULL;
+    }
+    stmt->num_params = countParams( sql_str );
+    stmt->execution = NULL;
+    stmt->result = 0;
+    stmt->row = 0;
+    stmt->length = 0;
+    stmt->is_null = false;
+    setError( sqlany_conn, 0, "" );
+    return stmt;
+}
+
+REPLAY_EXPORT void sqlany_free_stmt( a_sqlany_stmt * sqlany_stmt )
+/****************************************************************/
+{
+    delete sqlany_stmt;
+}
+
+REPLAY_EXPORT sacapi_i32 sqlany_num_params( a_sqlany_stmt * sqlany_stmt )
+/***********************************************************************/
+{
+    return (sacapi_i32)sqlany_stmt->num_params;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_describe_bind_param( a_sqlany_stmt * sqlany_stmt,
+						      sacapi_u32 index,
+						      a_sqlany_bind_param * param )
+/*********************************************************************************/
+{
+    static char name[] = "?";
+    memset( param, 0, sizeof( *param ) );
+    param->direction = DD_INPUT;
+    param->value.type = A_STRING;
+    param->name = name;
+    return index < sqlany_stmt->num_params;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_bind_param( a_sqlany_stmt * sqlany_stmt,
+					     sacapi_u32 index,
+					     a_sqlany_bind_param * param )
+/****************************************************************************/
+{
+    return index < sqlany_stmt->num_params;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_send_param_data( a_sqlany_stmt * sqlany_stmt,
+						  sacapi_u32 index,
+						  char * buffer, size_t size )
+/****************************************************************************/
+{
+    return index < sqlany_stmt->num_params;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_reset( a_sqlany_stmt * sqlany_stmt )
+/*******************************************************************/
+{
+    sqlany_stmt->execution = NULL;
+    sqlany_stmt->result = 0;
+    sqlany_stmt->row = 0;
+    return true;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_get_bind_param_info( a_sqlany_stmt * sqlany_stmt,
+						      sacapi_u32 index,
+						      a_sqlany_bind_param_info * info )
+/*************************************************************************************/
+{
+    static char name[] = "?";
+    memset( info, 0, sizeof( *info ) );
+    info->name = name;
+    info->direction = DD_INPUT;
+    return index < sqlany_stmt->num_params;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_execute( a_sqlany_stmt * sqlany_stmt )
+/*********************************************************************/
+{
+    sqlany_reset( sqlany_stmt );
+    if( sqlany_stmt->sql == NULL || sqlany_stmt->sql->executions.size() == 0 ) {
+	setError( sqlany_stmt->conn, REPLAY_SQLE_NOT_RECORDED,
+		  "Statement is not in the recording" );
+	return false;
+    }
+    {
+	std::lock_guard<std::mutex> lock( replayLock );
+	replaySql &sql = *sqlany_stmt->sql;
+	sqlany_stmt->execution = &sql.executions[sql.next];
+	sql.next = ( sql.next + 1 ) % sql.executions.size();
+    }
+    replayExecution *exec = sqlany_stmt->execution;
+    replayDelay( exec->elapsed_us );
+    if( !exec->ok ) {
+	setError( sqlany_stmt->conn, exec->sqlcode, exec->error.c_str() );
+	sqlany_stmt->execution = NULL;
+	return false;
+    }
+    setError( sqlany_stmt->conn, 0, "" );
+    return true;
+}
+
+REPLAY_EXPORT a_sqlany_stmt * sqlany_execute_direct( a_sqlany_connection * sqlany_conn,
+						     const char * sql_str )
+/***************************************************************************************/
+{
+    a_sqlany_stmt *stmt = sqlany_prepare( sqlany_conn, sql_str );
+    if( !sqlany_execute( stmt ) ) {
+	sqlany_free_stmt( stmt );
+	return NULL;
+    }
+    return stmt;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_fetch_next( a_sqlany_stmt * sqlany_stmt )
+/************************************************************************/
+{
+    replayResult *result = currentResult( sqlany_stmt );
+    if( result == NULL ) {
+	setError( sqlany_stmt->conn, REPLAY_SQLE_NOTFOUND, "Row not found" );
+	return false;
+    }
+    if( sqlany_stmt->row >= result->rows.size() ) {
+	if( sqlany_stmt->row == result->rows.size() ) {
+	    replayDelay( result->end_elapsed_us );
+	    sqlany_stmt->row++;
+	}
+	setError( sqlany_stmt->conn, result->end_sqlcode,
+		  result->end_sqlcode == REPLAY_SQLE_NOTFOUND ? "Row not found" :
+		  "Error fetching the row" );
+	return false;
+    }
+    replayDelay( result->rows[sqlany_stmt->row].elapsed_us );
+    sqlany_stmt->row++;
+    return true;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_fetch_absolute( a_sqlany_stmt * sqlany_stmt,
+						 sacapi_i32 row_num )
+/******************************************************************************/
+{
+    if( row_num < 1 ) {
+	setError( sqlany_stmt->conn, REPLAY_SQLE_NOTFOUND, "Row not found" );
+	return false;
+    }
+    sqlany_stmt->row = (size_t)( row_num - 1 );
+    return sqlany_fetch_next( sqlany_stmt );
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_get_next_result( a_sqlany_stmt * sqlany_stmt )
+/*****************************************************************************/
+{
+    replayExecution *exec = sqlany_stmt->execution;
+    if( exec == NULL || sqlany_stmt->result + 1 >= exec->results.size() ) {
+	setError( sqlany_stmt->conn,
+		  exec != NULL ? exec->next_sqlcode : REPLAY_SQLE_PROCEDURE_COMPLETE,
+		  "Procedure has completed" );
+	return false;
+    }
+    sqlany_stmt->result++;
+    sqlany_stmt->row = 0;
+    return true;
+}
+
+REPLAY_EXPORT sacapi_i32 sqlany_affected_rows( a_sqlany_stmt * sqlany_stmt )
+/**************************************************************************/
+{
+    return sqlany_stmt->execution != NULL ?
+	   sqlany_stmt->execution->affected_rows : -1;
+}
+
+REPLAY_EXPORT sacapi_i32 sqlany_num_cols( a_sqlany_stmt * sqlany_stmt )
+/*********************************************************************/
+{
+    replayResult *result = currentResult( sqlany_stmt );
+    return result != NULL ? (sacapi_i32)result->columns.size() : 0;
+}
+
+REPLAY_EXPORT sacapi_i32 sqlany_num_rows( a_sqlany_stmt * sqlany_stmt )
+/*********************************************************************/
+{
+    replayResult *result = currentResult( sqlany_stmt );
+    return result != NULL ? (sacapi_i32)result->rows.size() : 0;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_get_column( a_sqlany_stmt * sqlany_stmt,
+					     sacapi_u32 col_index,
+					     a_sqlany_data_value * buffer )
+/****************************************************************************/
+{
+    replayResult *result = currentResult( sqlany_stmt );
+    if( result == NULL || sqlany_stmt->row == 0 ||
+	sqlany_stmt->row > result->rows.size() ||
+	col_index >= result->columns.size() ) {
+	setError( sqlany_stmt->conn, -143, "Column not found" );
+	return false;
+    }
+    replayValue &value = result->rows[sqlany_stmt->row - 1].values[col_index];
+    memset( buffer, 0, sizeof( *buffer ) );
+    sqlany_stmt->is_null = value.type == A_INVALID_TYPE;
+    sqlany_stmt->length = value.data.length();
+    buffer->type = sqlany_stmt->is_null ? result->columns[col_index].type :
+					 value.type;
+    buffer->buffer = (char *)value.data.data();
+    buffer->buffer_size = value.data.length();
+    buffer->length = &sqlany_stmt->length;
+    buffer->is_null = &sqlany_stmt->is_null;
+    return true;
+}
+
+REPLAY_EXPORT sacapi_i32 sqlany_get_data( a_sqlany_stmt * sqlany_stmt,
+					  sacapi_u32 col_index, size_t offset,
+					  void * buffer, size_t size )
+/*************************************************************************/
+{
+    a_sqlany_data_value value;
+    if( !sqlany_get_column( sqlany_stmt, col_index, &value ) ) {
+	return -1;
+    }
+    size_t length = *value.length;
+    if( *value.is_null || offset >= length ) {
+	return 0;
+    }
+    size_t count = length - offset < size ? length - offset : size;
+    memcpy( buffer, value.buffer + offset, count );
+    return (sacapi_i32)count;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_get_data_info( a_sqlany_stmt * sqlany_stmt,
+						sacapi_u32 col_index,
+						a_sqlany_data_info * buffer )
+/*******************************************************************************/
+{
+    a_sqlany_data_value value;
+    if( !sqlany_get_column( sqlany_stmt, col_index, &value ) ) {
+	return false;
+    }
+    buffer->type = value.type;
+    buffer->is_null = *value.is_null;
+    buffer->data_size = *value.length;
+    return true;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_get_column_info( a_sqlany_stmt * sqlany_stmt,
+						  sacapi_u32 col_index,
+						  a_sqlany_column_info * buffer )
+/*********************************************************************************/
+{
+    replayResult *result = currentResult( sqlany_stmt );
+    if( result == NULL || col_index >= result->columns.size() ) {
+	setError( sqlany_stmt->conn, -143, "Column not found" );
+	return false;
+    }
+    replayColumn &column = result->columns[col_index];
+    memset( buffer, 0, sizeof( *buffer ) );
+    buffer->name = (char *)column.name.c_str();
+    buffer->type = column.type;
+    buffer->native_type = column.native_type;
+    buffer->max_size = column.max_size;
+    buffer->nullable = true;
+    return true;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_commit( a_sqlany_connection * sqlany_conn )
+/**************************************************************************/
+{
+    return true;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_rollback( a_sqlany_connection * sqlany_conn )
+/****************************************************************************/
+{
+    return true;
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_client_version( char * buffer, size_t len )
+/**************************************************************************/
+{
+    snprintf( buffer, len, "17.0.0.0 (replay)" );
+    return true;
+}
+
+REPLAY_EXPORT sacapi_i32 sqlany_error( a_sqlany_connection * sqlany_conn,
+				       char * buffer, size_t size )
+/***********************************************************************/
+{
+    if( sqlany_conn == NULL ) {
+	if( buffer != NULL && size > 0 ) {
+	    snprintf( buffer, size, "%s", loaded ? "" :
+		      "SQLANY_REPLAY_FILE is not set or is not a recording" );
+	}
+	return 0;
+    }
+    if( buffer != NULL && size > 0 ) {
+	snprintf( buffer, size, "%s", sqlany_conn->error.c_str() );
+    }
+    return sqlany_conn->sqlcode;
+}
+
+REPLAY_EXPORT size_t sqlany_sqlstate( a_sqlany_connection * sqlany_conn,
+				      char * buffer, size_t size )
+/**********************************************************************/
+{
+    const char *state = sqlany_conn == NULL || sqlany_conn->sqlcode >= 0 ?
+			"00000" : "HY000";
+    if( buffer != NULL && size > 0 ) {
+	snprintf( buffer, size, "%s", state );
+    }
+    return strlen( state ) + 1;
+}
+
+REPLAY_EXPORT void sqlany_clear_error( a_sqlany_connection * sqlany_conn )
+/************************************************************************/
+{
+    setError( sqlany_conn, 0, "" );
+}
+
+REPLAY_EXPORT a_sqlany_interface_context *sqlany_init_ex( const char * app_name,
+							  sacapi_u32 api_version,
+							  sacapi_u32 * version_available )
+/*****************************************************************************************/
+{
+    return sqlany_init( app_name, api_version, version_available ) ?
+	   replayContext : NULL;
+}
+
+REPLAY_EXPORT void sqlany_fini_ex( a_sqlany_interface_context *context )
+/**********************************************************************/
+{
+}
+
+REPLAY_EXPORT a_sqlany_connection *sqlany_new_connection_ex( a_sqlany_interface_context *context )
+/************************************************************************************************/
+{
+    return sqlany_new_connection();
+}
+
+REPLAY_EXPORT void sqlany_cancel( a_sqlany_connection * sqlany_conn )
+/*******************************************************************/
+{
+}
+
+REPLAY_EXPORT sacapi_bool sqlany_set_batch_size( a_sqlany_stmt * sqlany_stmt,
+						 sacapi_u32 num_rows )
+/*******************************************************************************/
+{
+    return true;
+}
+
+}
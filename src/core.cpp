@@ -0,0 +1,390 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+#include "sqlany_core.h"
+#include "trace.h"
+
+SQLAnywhereInterface api;
+
+void bindInt( ExecuteData *ex, std::vector<a_sqlany_bind_param> &params,
+	      int val )
+/*******************************************************************/
+{
+    a_sqlany_bind_param param;
+    memset( &param, 0, sizeof( param ) );
+
+    int *param_int = new int;
+    *param_int = val;
+    ex->addInt( param_int );
+    param.value.buffer = (char *)( param_int );
+    param.value.type   = A_VAL32;
+    params.push_back( param );
+}
+
+void bindDouble( ExecuteData *ex, std::vector<a_sqlany_bind_param> &params,
+		 double val )
+/*************************************************************************/
+{
+    a_sqlany_bind_param param;
+    memset( &param, 0, sizeof( param ) );
+
+    double *param_double = new double;
+    *param_double = val;
+    ex->addNum( param_double );
+    param.value.buffer = (char *)( param_double );
+    param.value.type   = A_DOUBLE;
+    params.push_back( param );
+}
+
+void bindBytes( ExecuteData *ex, std::vector<a_sqlany_bind_param> &params,
+		a_sqlany_data_type type, const char *data, size_t len )
+/*************************************************************************/
+{
+    a_sqlany_bind_param param;
+    memset( &param, 0, sizeof( param ) );
+
+    bool terminate = type == A_STRING;
+    size_t *param_len = new size_t;
+    *param_len = len;
+    char *param_char = new char[len + ( terminate ? 1 : 0 )];
+    memcpy( param_char, data, len );
+    if( terminate ) {
+	param_char[len] = '\0';
+    }
+    ex->addString( param_char, param_len );
+
+    param.value.type = type;
+    param.value.buffer = param_char;
+    param.value.length = param_len;
+    param.value.buffer_size = terminate ? len + 1 : sizeof( param_char );
+    params.push_back( param );
+}
+
+void bindNull( ExecuteData *ex, std::vector<a_sqlany_bind_param> &params )
+/************************************************************************/
+{
+    a_sqlany_bind_param param;
+    memset( &param, 0, sizeof( param ) );
+
+    sacapi_bool *is_null = new sacapi_bool;
+    is_null[0] = true;
+    ex->addNull( is_null );
+    param.value.type = A_STRING;
+    param.value.is_null = is_null;
+    params.push_back( param );
+}
+
+wideColumn addWideColumn( ExecuteData *ex,
+			  std::vector<a_sqlany_bind_param> &params,
+			  a_sqlany_data_type type, unsigned num_rows )
+/********************************************************************/
+{
+    a_sqlany_bind_param param;
+    memset( &param, 0, sizeof( param ) );
+
+    wideColumn col;
+    col.nums = new double[num_rows];
+    col.strings = new char *[num_rows];
+    col.lens = new size_t[num_rows];
+    col.nulls = new sacapi_bool[num_rows];
+    memset( col.strings, 0, num_rows * sizeof( char * ) );
+    ex->addWide( col, num_rows );
+
+    param.value.type	= type;
+    param.value.is_null	= col.nulls;
+    param.value.is_address = false;
+    switch( type ) {
+	case A_DOUBLE:
+	    param.value.buffer	= (char *)col.nums;
+	    break;
+	case A_STRING:
+	case A_BINARY:
+	    param.value.buffer	= (char *)col.strings;
+	    param.value.length	= col.lens;
+	    param.value.is_address = true;
+	    break;
+	default:
+	    break;
+    }
+    params.push_back( param );
+    return col;
+}
+
+void setWideDouble( wideColumn &col, unsigned row, double val )
+/*************************************************************/
+{
+    col.nulls[row] = false;
+    col.nums[row] = val;
+}
+
+void setWideBytes( wideColumn &col, unsigned row, const char *data,
+		   size_t len, bool terminate )
+/*****************************************************************/
+{
+    col.nulls[row] = false;
+    col.lens[row] = len;
+    char *param_char = new char[len + ( terminate ? 1 : 0 )];
+    col.strings[row] = param_char;
+    memcpy( param_char, data, len );
+    if( terminate ) {
+	param_char[len] = '\0';
+    }
+}
+
+void setWideNull( wideColumn &col, unsigned row )
+/***********************************************/
+{
+    col.nulls[row] = true;
+}
+
+uint64_t boundBytes( const std::vector<a_sqlany_bind_param> &params,
+		     unsigned num_rows )
+/******************************************************************/
+{
+    uint64_t bytes = 0;
+    for( size_t i = 0; i < params.size(); i++ ) {
+	const a_sqlany_data_value &value = params[i].value;
+	for( unsigned r = 0; r < num_rows; r++ ) {
+	    if( value.is_null != NULL && value.is_null[r] ) {
+		continue;
+	    }
+	    switch( value.type ) {
+		case A_STRING:
+		case A_BINARY:
+		    if( value.length != NULL ) {
+			bytes += value.length[r];
+		    }
+		    break;
+		case A_DOUBLE:
+		    bytes += sizeof( double );
+		    break;
+		case A_VAL32:
+		    bytes += sizeof( int );
+		    break;
+		default:
+		    break;
+	    }
+	}
+    }
+    return bytes;
+}
+
+bool bindParameters( a_sqlany_stmt *				sqlany_stmt,
+		     const std::vector<a_sqlany_bind_param> &	params,
+		     unsigned					num_rows )
+/*****************************************************************************/
+{
+    for( unsigned int i = 0; i < params.size(); i++ ) {
+	a_sqlany_bind_param 	param;
+	
+	if( !api.sqlany_describe_bind_param( sqlany_stmt, i, &param ) ) {
+	    return false;
+	}
+
+        memcpy( &param.value, &params[i].value, sizeof( param.value ) );
+
+	if( !api.sqlany_bind_param( sqlany_stmt, i, &param ) ) {
+	    return false;
+	}
+    }
+
+    if( num_rows > 1 ) {
+	api.sqlany_set_batch_size( sqlany_stmt, num_rows );
+    }
+    return true;
+}
+
+bool fetchResultSet( a_sqlany_stmt *			sqlany_stmt,
+		     int &				rows_affected,
+		     std::vector<char *> &		colNames,
+		     ExecuteData *			execData,
+		     std::vector<a_sqlany_data_type> &	col_types,
+		     driverStats *			stats,
+		     resultLimits *			limits )
+/*****************************************************************/
+{
+    
+    a_sqlany_data_value		value;
+    int				num_cols = 0;
+    fetchCounter		counter( stats );
+    
+    rows_affected = api.sqlany_affected_rows( sqlany_stmt );
+    num_cols = api.sqlany_num_cols( sqlany_stmt );
+    
+    
+    if( rows_affected > 0 && num_cols < 1 ) {
+        return true;
+    }
+    
+    rows_affected = -1;
+    if( num_cols > 0 ) {
+	
+	for( int i = 0; i < num_cols; i++ ) {
+	    a_sqlany_column_info info;
+	    api.sqlany_get_column_info( sqlany_stmt, i, &info );
+	    size_t size = strlen( info.name ) + 1;
+	    char *name = new char[ size ];
+	    memcpy( name, info.name, size );
+	    colNames.push_back( name );
+	}
+	
+	int count_string = 0, count_num = 0, count_int = 0;
+	while( true ) {
+
+	    counter.fetch_calls++;
+	    sacapi_bool fetched;
+	    {
+		traceSpan span( "sqlany_fetch_next" );
+		fetched = api.sqlany_fetch_next( sqlany_stmt );
+	    }
+	    if( !fetched ) {
+		return false;
+	    }
+	    counter.rows++;
+	    if( limits != NULL && limits->max_rows > 0 &&
+		counter.rows > limits->max_rows ) {
+		limits->exceeded = true;
+		return false;
+	    }
+
+	    for( int i = 0; i < num_cols; i++ ) {
+
+		if( !api.sqlany_get_column( sqlany_stmt, i, &value ) ) {
+		    return false;
+		}
+	
+		if( *(value.is_null) ) {
+		    col_types.push_back( A_INVALID_TYPE );
+		    continue;
+		}
+		
+		switch( value.type ) {
+		    case A_BINARY:
+		    {
+			size_t *size = new size_t;
+			*size = *(value.length);
+			char *val = new char[ *size ];
+			memcpy( val, value.buffer, *size );
+			execData->addString( val, size );
+			count_string++;
+			counter.bytes_binary += *size;
+			break;
+		    }
+		    
+		    case A_STRING:
+		    {
+			size_t *size = new size_t;
+			*size = (size_t)( (int)*(value.length) );
+			char *val = new char[ *size ];
+			memcpy( val, (char *)value.buffer, *size );
+			execData->addString( val, size );
+			count_string++;
+			counter.bytes_string += *size;
+			break;
+		    }
+			
+		    case A_VAL64:
+		    {
+			double *val = new double;
+			*val = (double)*(long long *)value.buffer;
+			execData->addNum( val );
+			count_num++;
+			counter.bytes_double += sizeof( double );
+			break;
+		    }
+			
+		    case A_UVAL64:
+		    {
+			double *val = new double;
+			*val = (double)*(unsigned long long *)value.buffer;
+			execData->addNum( val );
+			count_num++;
+			counter.bytes_double += sizeof( double );
+			break;
+		    }
+			
+		    case A_VAL32:
+		    {
+			int *val = new int;
+			*val = *(int*)value.buffer;
+			execData->addInt( val );
+			count_int++;
+			counter.bytes_int += sizeof( int );
+			break;
+		    }
+
+		    case A_UVAL32:
+		    {
+			double *val = new double;
+			*val = (double)*(unsigned int*)value.buffer;
+			execData->addNum( val );
+			count_num++;
+			counter.bytes_double += sizeof( double );
+			break;
+		    }
+			
+		    case A_VAL16:
+		    {
+			int *val = new int;
+			*val = (int)*(short*)value.buffer;
+			execData->addInt( val );
+			count_int++;
+			counter.bytes_int += sizeof( int );
+			break;
+		    }
+
+		    case A_UVAL16:
+		    {
+			int *val = new int;
+			*val = (int)*(unsigned short*)value.buffer;
+			execData->addInt( val );
+			count_int++;
+			counter.bytes_int += sizeof( int );
+			break;
+		    }
+			
+		    case A_VAL8:
+		    {
+			int *val = new int;
+			*val = (int)*(char *)value.buffer;
+			execData->addInt( val );
+			count_int++;
+			counter.bytes_int += sizeof( int );
+			break;
+		    }
+			
+		    case A_UVAL8:
+		    {
+			int *val = new int;
+			*val = (int)*(unsigned char *)value.buffer;
+			execData->addInt( val );
+			count_int++;
+			counter.bytes_int += sizeof( int );
+			break;
+		    }
+			
+		    case A_DOUBLE:
+		    {
+			double *val = new double;
+			*val = (double)*(double *)value.buffer;
+			execData->addNum( val );
+			count_num++;
+			counter.bytes_double += sizeof( double );
+			break;
+		    }
+			
+                    default:
+			return false;
+		}
+		col_types.push_back( value.type );
+	    }
+	    if( limits != NULL && limits->max_bytes > 0 &&
+		counter.bytes() > limits->max_bytes ) {
+		limits->exceeded = true;
+		return false;
+	    }
+	}
+    }
+    
+    return true;
+}
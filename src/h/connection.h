@@ -336,6 +336,103 @@ class Connection : public ObjectWrap
      *
      */
     static NODE_API_FUNC( exec );
+
+    /** Executes a list of SQL statements in a single request.
+     *
+     * This method takes in an array of objects of the form
+     * { sql: String, params: Array }, where params is optional, and an
+     * optional hash of options. The statements are prepared and executed
+     * one after another without returning to the main thread in between.
+     * Execution stops at the first error.
+     *
+     * The following option is supported:
+     *
+     * <ul>
+     * <li><b>transaction</b> - When true, the statements are committed
+     * after the last one succeeds, and rolled back if any of them fails.
+     * The default is false.</li>
+     * </ul>
+     *
+     * This method can be either synchronous or asynchronous depending on
+     * whether or not a callback function is specified.
+     * The callback function is of the form:
+     *
+     * <p><pre>
+     * function( err, results )
+     * {
+     *
+     * };
+     * </pre></p>
+     *
+     * The results array holds one entry per statement, in the same form
+     * that the exec method returns.
+     *
+     * The following synchronous example shows how to use the execBatch method.
+     *
+     * <p><pre>
+     * var sqlanywhere = require( 'sqlanywhere' );
+     * var client = sqlanywhere.createConnection();
+     * client.connect( "ServerName=demo17;UID=DBA;PWD=sql" );
+     * results = client.execBatch( [
+     *     { sql: "UPDATE Products SET Quantity = Quantity - ? WHERE ID = ?",
+     *       params: [ 1, 300 ] },
+     *     { sql: "SELECT Quantity FROM Products WHERE ID = ?", params: [ 300 ] }
+     *     ], { transaction: true } );
+     * console.log( results[1] );
+     * client.disconnect()
+     * </pre></p>
+     *
+     * @fn Array Connection::execBatch( Array statements, Object options, Function callback )
+     *
+     * @param statements The statements to be executed. ( type: Array )
+     * @param options Optional hash of options. ( type: Object )
+     * @param callback The optional callback function. ( type: Function )
+     *
+     * @return If no callback is specified, the array of results is returned.
+     *
+     */
+    static NODE_API_FUNC( execBatch );
+
+    /** Executes the specified SQL statement and fetches all of its result sets.
+     *
+     * This method executes the statement and then fetches every result set
+     * it returns, such as those of a procedure call, in a single request.
+     *
+     * This method can be either synchronous or asynchronous depending on
+     * whether or not a callback function is specified.
+     * The callback function is of the form:
+     *
+     * <p><pre>
+     * function( err, results )
+     * {
+     *
+     * };
+     * </pre></p>
+     *
+     * The results array holds one entry per result set, in the same form
+     * that the exec method returns.
+     *
+     * The following synchronous example shows how to use the execAll method.
+     *
+     * <p><pre>
+     * var sqlanywhere = require( 'sqlanywhere' );
+     * var client = sqlanywhere.createConnection();
+     * client.connect( "ServerName=demo17;UID=DBA;PWD=sql" );
+     * results = client.execAll( "CALL ShowCustomerProducts( ? )", [ 101 ] );
+     * console.log( results.length );
+     * client.disconnect()
+     * </pre></p>
+     *
+     * @fn Array Connection::execAll( String sql, Array params, Function callback )
+     *
+     * @param sql The SQL statement to be executed. ( type: String )
+     * @param params Optional array of bind parameters. ( type: Array )
+     * @param callback The optional callback function. ( type: Function )
+     *
+     * @return If no callback is specified, the array of results is returned.
+     *
+     */
+    static NODE_API_FUNC( execAll );
 	
     /** Prepares the specified SQL statement.
      *
@@ -379,6 +476,51 @@ class Connection : public ObjectWrap
     static void prepareAfter( uv_work_t *req );
     /// @internal
     static void prepareWork( uv_work_t *req );
+
+    /** Prepares statements ahead of their first use.
+     *
+     * Each statement in the array is prepared and kept in the connection's
+     * statement cache. A later exec or prepare with exactly the same SQL
+     * text takes the prepared statement from the cache instead of preparing
+     * it again, and gives it back when it is done, so that the next one can
+     * reuse it too. Statements that are already cached are skipped. The
+     * cache is emptied when the connection is closed.
+     *
+     * The stats counter cacheHits counts the prepares answered from the
+     * cache.
+     *
+     * This method can be either synchronous or asynchronous depending on
+     * whether or not a callback function is specified.
+     * The callback function is of the form:
+     *
+     * <p><pre>
+     * function( err ) {
+     *
+     * };
+     * </pre></p>
+     *
+     * <p><pre>
+     * var sqlanywhere = require( 'sqlanywhere' );
+     * var client = sqlanywhere.createConnection();
+     * client.connect( "ServerName=demo17;UID=DBA;PWD=sql" )
+     * client.cacheStatements( [ "SELECT * FROM Customers WHERE ID = ?" ] );
+     * result = client.exec( "SELECT * FROM Customers WHERE ID = ?", [101] );
+     * console.log( client.stats().cacheHits );
+     * client.disconnect();
+     * </pre></p>
+     *
+     * @fn Connection::cacheStatements( Array sql, Function callback )
+     *
+     * @param sql An array of SQL statements. ( type: Array )
+     * @param callback The optional callback function. ( type: Function )
+     *
+     */
+    static NODE_API_FUNC( cacheStatements );
+
+    /// @internal
+    static void cacheStatementsWork( uv_work_t *req );
+    /// @internal
+    static void cacheStatementsAfter( uv_work_t *req );
     
     /** Performs a commit on the connection.
      *
@@ -494,6 +636,173 @@ class Connection : public ObjectWrap
      */
     static NODE_API_FUNC( connected );
 
+    /** Sets options that control the behaviour of the connection.
+     *
+     * This synchronous method takes a hash of options. Options that are
+     * not specified keep their current value. The following options are
+     * supported:
+     *
+     * <ul>
+     * <li><b>promises</b> - When true, methods of the connection and of
+     * the statements prepared on it return a Promise when no callback
+     * function is specified, instead of executing synchronously.
+     * The default is false.</li>
+     * <li><b>timing</b> - When true, each exec call on the connection or
+     * on its statements records how long it spent in each phase of its
+     * execution. The timings are returned by getTimings. The default is
+     * false.</li>
+     * <li><b>statementStats</b> - When true, the prepare, execute and
+     * fetch times of each exec call on the connection or on its
+     * statements are added to the latency histograms of its statement
+     * fingerprint. The module's topStatements function reports them.
+     * The default is false.</li>
+     * <li><b>slowQueryMs</b> - When greater than zero, exec calls on the
+     * connection or on its statements that take longer than this many
+     * milliseconds to execute and fetch are reported to slowQueryLog.
+     * The default is 0.</li>
+     * <li><b>slowQueryLog</b> - Where slow queries are reported: either a
+     * function, which is called with a record of the query, or the name of
+     * a file, to which each record is appended as a line of JSON from a
+     * worker thread. A record holds the SQL text, summaries of the bound
+     * values of the first row, the phase timings and the row counts.</li>
+     * <li><b>maxRows</b> - When greater than zero, an exec call whose
+     * result set has more rows than this fails with an error instead of
+     * returning it. The cursor is closed as soon as the limit is passed,
+     * so the rest of the result is never fetched. The default is 0.</li>
+     * <li><b>maxResultBytes</b> - Like maxRows, but limits the bytes of
+     * column data fetched for one result set. The default is 0.</li>
+     * <li><b>deadlineMs</b> - When greater than zero, each exec call on
+     * the connection or on its statements must reach the server within
+     * this many milliseconds of being made. A call still waiting for the
+     * connection or for a worker thread when its deadline passes fails
+     * with an error instead of executing, and is counted in the
+     * requestsExpired counter. The default is 0.</li>
+     * </ul>
+     *
+     * The following example shows how to use promises.
+     *
+     * <p><pre>
+     * var sqlanywhere = require( 'sqlanywhere' );
+     * var client = sqlanywhere.createConnection();
+     * client.setOptions( { promises: true } );
+     * client.connect( "ServerName=demo17;UID=DBA;PWD=sql" )
+     *     .then( function() {
+     *         return client.exec( "SELECT * FROM Customers" );
+     *     } )
+     *     .then( function( result ) {
+     *         console.log( result );
+     *         return client.disconnect();
+     *     } );
+     * </pre></p>
+     *
+     * @fn Connection::setOptions( Object options )
+     *
+     * @param options A hash of options. ( type: Object )
+     *
+     */
+    static NODE_API_FUNC( setOptions );
+
+    /** Returns the phase timings recorded for the connection.
+     *
+     * This synchronous method returns an object with the number of timed
+     * executions ( count ), the phase durations of the last one ( last )
+     * and the sum of the phase durations of all of them ( total ).
+     * Durations are in milliseconds, for the phases queueWait, lockWait,
+     * prepare, bind, execute, fetch, deliver, materialize and callback.
+     * Timings are only recorded while the timing option is set, and are
+     * cleared when it is set.
+     *
+     * <p><pre>
+     * var sqlanywhere = require( 'sqlanywhere' );
+     * var client = sqlanywhere.createConnection();
+     * client.connect( "ServerName=demo17;UID=DBA;PWD=sql" )
+     * client.setOptions( { timing: true } );
+     * client.exec( "SELECT * FROM Customers" );
+     * console.log( client.getTimings().last.execute );
+     * client.disconnect();
+     * </pre></p>
+     *
+     * @fn Object Connection::getTimings()
+     *
+     * @return An object holding the recorded timings.
+     *
+     */
+    static NODE_API_FUNC( getTimings );
+
+    /** Returns the cumulative counters of the connection.
+     *
+     * This synchronous method returns an object holding counters that are
+     * kept for the life of the connection object:
+     *
+     * <ul>
+     * <li><b>executes</b> - statements executed</li>
+     * <li><b>prepares</b> - statements prepared</li>
+     * <li><b>cacheHits</b> - prepares answered from the statement cache</li>
+     * <li><b>fetchCalls</b> - fetch calls made to the server library</li>
+     * <li><b>rowsFetched</b> - rows fetched</li>
+     * <li><b>bytesFetchedString</b>, <b>bytesFetchedBinary</b>,
+     * <b>bytesFetchedInt</b>, <b>bytesFetchedDouble</b> - bytes fetched,
+     * by column type</li>
+     * <li><b>rowsBound</b> - parameter rows bound</li>
+     * <li><b>bytesBound</b> - bytes of parameter data bound</li>
+     * <li><b>peakResultBytes</b> - size of the largest result set
+     * fetched</li>
+     * </ul>
+     *
+     * The module's stats function returns the same counters summed over
+     * all connections.
+     *
+     * <p><pre>
+     * var sqlanywhere = require( 'sqlanywhere' );
+     * var client = sqlanywhere.createConnection();
+     * client.connect( "ServerName=demo17;UID=DBA;PWD=sql" )
+     * client.exec( "SELECT * FROM Customers" );
+     * console.log( client.stats().rowsFetched );
+     * console.log( sqlanywhere.stats().rowsFetched );
+     * client.disconnect();
+     * </pre></p>
+     *
+     * @fn Object Connection::stats()
+     *
+     * @return An object holding the counters.
+     *
+     */
+    static NODE_API_FUNC( getStats );
+
+    /** Returns contention counters for the connection's lock.
+     *
+     * Each request on a connection holds the connection's lock while it
+     * runs, so requests on the same connection run one at a time. This
+     * synchronous method returns an object with:
+     *
+     * <ul>
+     * <li><b>acquisitions</b> - times the lock was taken</li>
+     * <li><b>contended</b> - times a request had to wait for it</li>
+     * <li><b>waitMs</b>, <b>maxWaitMs</b> - total and longest wait</li>
+     * <li><b>holdMs</b>, <b>maxHoldMs</b> - total and longest time it was
+     * held</li>
+     * </ul>
+     *
+     * The module's lockStats function returns the same counters for the
+     * driver's global locks, and for all connection locks together.
+     *
+     * <p><pre>
+     * var sqlanywhere = require( 'sqlanywhere' );
+     * var client = sqlanywhere.createConnection();
+     * client.connect( "ServerName=demo17;UID=DBA;PWD=sql" )
+     * client.exec( "SELECT * FROM Customers" );
+     * console.log( client.lockStats().maxWaitMs );
+     * console.log( sqlanywhere.lockStats().api_mutex.waitMs );
+     * client.disconnect();
+     * </pre></p>
+     *
+     * @fn Object Connection::lockStats()
+     *
+     * @return An object holding the counters.
+     *
+     */
+    static NODE_API_FUNC( getLockStats );
+
   public:
     /// @internal
     a_sqlany_connection	*conn;
@@ -502,14 +811,46 @@ class Connection : public ObjectWrap
     /// @internal
     bool 		sqlca_connection;
     /// @internal
+    bool		promise_mode;
+    /// @internal
+    bool		timing_mode;
+    /// @internal
+    bool		statement_stats_mode;
+    /// @internal
+    double		slow_query_ms;
+    /// @internal
+    Persistent<Function> slow_query_sink;
+    /// @internal
+    std::string		slow_query_file;
+    /// @internal
+    resultLimits	result_limits;
+    /// @internal
+    double		deadline_ms;
+    /// @internal
+    queryTimings	timings;
+    /// @internal
+    driverStats		stats;
+    /// @internal
     uv_mutex_t 		conn_mutex;
     /// @internal
+    unsigned		trace_id;
+    /// @internal
+    lockStats		conn_lock;
+    /// @internal
     Persistent<String>	_arg;
     /// @internal
     std::vector<void*>	statements;
+    /// @internal
+    std::map<std::string, a_sqlany_stmt *> stmt_cache;
 
     /// @internal
     void removeStmt( class StmtObject *stmt );
     /// @internal
     void cleanupStmts( void );
+    /// @internal
+    a_sqlany_stmt *takeCachedStmt( const std::string &sql );
+    /// @internal
+    bool returnCachedStmt( const std::string &sql, a_sqlany_stmt *stmt );
+    /// @internal
+    void clearStmtCache( void );
 };
@@ -10,3 +10,5 @@
 #define JS_ERR_GENERAL_ERROR				-2007
 #define JS_ERR_RESULTSET				-2008
 #define JS_ERR_NO_WIDE_STATEMENTS			-2009
+#define JS_ERR_RESULT_TOO_LARGE				-2010
+#define JS_ERR_DEADLINE_EXCEEDED			-2011
@@ -0,0 +1,59 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+#ifndef SLOWLOG_H
+#define SLOWLOG_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Phases of a slow query, in the order they are reported
+enum slowQueryPhase {
+    SLOW_QUEUE_WAIT,
+    SLOW_LOCK_WAIT,
+    SLOW_PREPARE,
+    SLOW_BIND,
+    SLOW_EXECUTE,
+    SLOW_FETCH,
+    SLOW_NUM_PHASES
+};
+
+// A query that exceeded the connection's slowQueryMs threshold. It is
+// filled in on the worker thread, and either passed to the JavaScript sink
+// or appended to the log file as one JSON object per line.
+struct slowQueryRecord {
+    std::string			sql;
+    // One summary per bound parameter of the first row, e.g. 'abc' or 42
+    std::vector<std::string>	params;
+    unsigned			param_rows;
+    double			total_ms;
+    double			phases_ms[SLOW_NUM_PHASES];
+    int				rows_affected;
+    size_t			rows;
+    std::string			error;
+
+    slowQueryRecord() {
+	param_rows = 0;
+	total_ms = 0;
+	rows_affected = -1;
+	rows = 0;
+	for( int i = 0; i < SLOW_NUM_PHASES; i++ ) {
+	    phases_ms[i] = 0;
+	}
+    }
+
+    static const char *phaseName( slowQueryPhase phase );
+    std::string toJson( void ) const;
+};
+
+// Longest string parameter value kept in a summary
+#define SLOW_PARAM_PREVIEW	32
+
+std::string summarizeString( const char *value, size_t length );
+
+// Queues a line to be appended to the file by a background thread. Lines
+// from all connections are written in the order they were queued.
+void appendSlowQueryLog( const std::string &file, const std::string &line );
+
+#endif
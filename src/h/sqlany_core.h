@@ -0,0 +1,175 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+// The part of the driver that moves data between dbcapi and native buffers:
+// binding parameters and fetching result sets. Nothing here depends on V8,
+// Node or libuv, so it is built as its own library and can be benchmarked
+// against the mock dbcapi library (see bench/core_bench.cpp).
+#ifndef SQLANY_CORE_H
+#define SQLANY_CORE_H
+
+#include <string>
+#include <string.h>
+#include <vector>
+#include "sacapidll.h"
+#include "sacapi.h"
+#include "stats.h"
+
+extern SQLAnywhereInterface api;
+
+#define CLEAN_STRINGS( vector )      		\
+{                                          	\
+    for( size_t i = 0; i < vector.size(); i++ ) { 	\
+	delete[] vector[i];			\
+    }						\
+    vector.clear();				\
+}
+
+#define CLEAN_PTRS( vector )      		\
+{                                          	\
+    for( size_t i = 0; i < vector.size(); i++ ) { 	\
+	delete vector[i];			\
+    }						\
+    vector.clear();				\
+}
+
+// The arrays behind one parameter of a statement executed for many rows
+struct wideColumn {
+    double *		nums;
+    char **		strings;
+    size_t *		lens;
+    sacapi_bool *	nulls;
+};
+
+class ExecuteData {
+  public:
+    ~ExecuteData() {
+	clear();
+    }
+
+    void clear( void ) {
+	CLEAN_STRINGS( string_vals );
+	for( size_t i = 0; i < wide_cols.size(); i++ ) {
+	    for( size_t r = 0; r < wide_rows[i]; r++ ) {
+		delete[] wide_cols[i].strings[r];
+	    }
+	    delete[] wide_cols[i].strings;
+	    delete[] wide_cols[i].nums;
+	    delete[] wide_cols[i].lens;
+	    delete[] wide_cols[i].nulls;
+	}
+	wide_cols.clear();
+	wide_rows.clear();
+	CLEAN_PTRS( int_vals );
+	CLEAN_PTRS( num_vals );
+	CLEAN_PTRS( len_vals );
+	CLEAN_PTRS( null_vals );
+    }
+    void	addString( char *str, size_t *len ) {
+	string_vals.push_back( str );
+	len_vals.push_back( len );
+    }
+    void	addWide( const wideColumn &col, size_t rows ) {
+	wide_cols.push_back( col );
+	wide_rows.push_back( rows );
+    }
+    void	addInt( int *val ) { int_vals.push_back( val ); }
+    void	addNum( double *val ) { num_vals.push_back( val ); }
+    void	addNull( sacapi_bool *val ) { null_vals.push_back( val ); }
+
+    char *	getString( size_t ind ) { return string_vals[ind]; }
+    int		getInt( size_t ind ) { return *(int_vals[ind]); }
+    double	getNum( size_t ind ) { return *(num_vals[ind]); }
+    size_t	getLen( size_t ind ) { return *(len_vals[ind]); }
+    sacapi_bool	getNull( size_t ind ) { return *(null_vals[ind]); }
+
+    size_t	stringSize( void ) const { return string_vals.size(); }
+    size_t	intSize( void ) const { return int_vals.size(); }
+    size_t	numSize( void ) const { return num_vals.size(); }
+    size_t	lenSize( void ) const { return len_vals.size(); }
+    size_t	nullSize( void ) const { return null_vals.size(); }
+
+    // Bytes of column data held, used for reporting
+    size_t	dataBytes( void ) const {
+	size_t bytes = int_vals.size() * sizeof( int ) +
+		       num_vals.size() * sizeof( double );
+	for( size_t i = 0; i < len_vals.size(); i++ ) {
+	    if( len_vals[i] != NULL ) {
+		bytes += *(len_vals[i]);
+	    }
+	}
+	return bytes;
+    }
+
+    bool	stringIsNull( size_t ind ) const { return string_vals[ind] == NULL; }
+    bool	intIsNull( size_t ind ) const { return int_vals[ind] == NULL; }
+    bool	numIsNull( size_t ind ) const { return num_vals[ind] == NULL; }
+    bool	lenIsNull( size_t ind ) const { return string_vals[ind] == NULL; }
+    bool	nullIsNull( size_t ind ) const { return string_vals[ind] == NULL; }
+
+  private:
+    std::vector<char *>		string_vals;
+    std::vector<int *> 		int_vals;
+    std::vector<double *>	num_vals;
+    std::vector<size_t *>	len_vals;
+    std::vector<sacapi_bool *>	null_vals;
+    std::vector<wideColumn>	wide_cols;
+    std::vector<size_t>		wide_rows;
+};
+
+// Builders for the parameters of a statement executed once. Each adds one
+// parameter to params, with a copy of the value owned by ex.
+void bindInt( ExecuteData *ex, std::vector<a_sqlany_bind_param> &params,
+	      int val );
+void bindDouble( ExecuteData *ex, std::vector<a_sqlany_bind_param> &params,
+		 double val );
+// type is A_STRING or A_BINARY; strings are copied with their terminator
+void bindBytes( ExecuteData *ex, std::vector<a_sqlany_bind_param> &params,
+		a_sqlany_data_type type, const char *data, size_t len );
+void bindNull( ExecuteData *ex, std::vector<a_sqlany_bind_param> &params );
+
+// Adds a parameter of the given type (A_DOUBLE, A_STRING, A_BINARY or
+// A_INVALID_TYPE for a column that starts with NULL) with room for
+// num_rows values, owned by ex. Every row must then be set.
+wideColumn addWideColumn( ExecuteData *ex,
+			  std::vector<a_sqlany_bind_param> &params,
+			  a_sqlany_data_type type, unsigned num_rows );
+void setWideDouble( wideColumn &col, unsigned row, double val );
+// terminate adds a NUL after the copy, for strings
+void setWideBytes( wideColumn &col, unsigned row, const char *data,
+		   size_t len, bool terminate );
+void setWideNull( wideColumn &col, unsigned row );
+
+// Returns the bytes of parameter data bound, over all rows
+uint64_t boundBytes( const std::vector<a_sqlany_bind_param> &params,
+		     unsigned num_rows );
+
+// Describes and binds params to the statement, and sets its batch size when
+// num_rows is more than one. Returns false on a dbcapi error.
+bool bindParameters( a_sqlany_stmt *				sqlany_stmt,
+		     const std::vector<a_sqlany_bind_param> &	params,
+		     unsigned					num_rows );
+
+// Caps on the size of one fetched result set; zero means no cap.
+// fetchResultSet sets exceeded and stops fetching when a cap is passed.
+struct resultLimits {
+    uint64_t	max_rows;
+    uint64_t	max_bytes;
+    bool	exceeded;
+
+    resultLimits() {
+	max_rows = 0;
+	max_bytes = 0;
+	exceeded = false;
+    }
+};
+
+bool fetchResultSet( a_sqlany_stmt 			*sqlany_stmt
+		   , int 				&rows_affected
+		   , std::vector<char *> 		&colNames
+		   , ExecuteData			*execData
+		   , std::vector<a_sqlany_data_type> 	&col_types
+		   , driverStats			*stats = NULL
+		   , resultLimits			*limits = NULL );
+
+#endif
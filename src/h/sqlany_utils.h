@@ -4,8 +4,10 @@
 #include <iostream>
 #include <string>
 #include <string.h>
+#include <ctype.h>
 #include <sstream> 
 #include <vector>
+#include <map>
 #include "sacapidll.h"
 #include "sacapi.h"
 
@@ -35,104 +37,77 @@
 
 #include "nodever_cover.h"
 #include "errors.h"
+#include "timing.h"
+#include "sqlany_core.h"
+#include "trace.h"
+#include "statements.h"
+#include "slowlog.h"
 #include "connection.h"
 #include "stmt.h"
 
 using namespace v8;
 
-extern SQLAnywhereInterface api;
 extern unsigned openConnections;
 extern uv_mutex_t api_mutex;
 
-#define CLEAN_STRINGS( vector )      		\
-{                                          	\
-    for( size_t i = 0; i < vector.size(); i++ ) { 	\
-	delete[] vector[i];			\
-    }						\
-    vector.clear();				\
-}
-
-#define CLEAN_PTRS( vector )      		\
-{                                          	\
-    for( size_t i = 0; i < vector.size(); i++ ) { 	\
-	delete vector[i];			\
-    }						\
-    vector.clear();				\
-}
-
 class scoped_lock
 {
     public:
 	scoped_lock( uv_mutex_t &mtx ) : _mtx( mtx )
 	{
+	    _stats = NULL;
 	    uv_mutex_lock( &_mtx );
 	}
+	// Locks a mutex and records the wait for it and how long it was held
+	// in stats. While tracing, the wait is also traced, and if this is a
+	// connection's conn_mutex the thread's spans are tagged with the
+	// connection until it is released.
+	scoped_lock( uv_mutex_t &mtx, lockStats &stats ) : _mtx( mtx )
+	{
+	    _stats = &stats;
+	    uint64_t wait = 0;
+	    bool contended = uv_mutex_trylock( &_mtx ) != 0;
+	    if( contended ) {
+		uint64_t trace_start = traceEnabled() ? traceNow() : 0;
+		uint64_t start = uv_hrtime();
+		uv_mutex_lock( &_mtx );
+		_acquired = uv_hrtime();
+		wait = _acquired - start;
+		if( trace_start != 0 ) {
+		    traceSetConnection( stats.conn );
+		    traceComplete( stats.name, "lock", trace_start, traceNow() );
+		}
+	    } else {
+		_acquired = uv_hrtime();
+	    }
+	    stats.acquired( contended, wait );
+	    if( stats.conn != 0 ) {
+		traceSetConnection( stats.conn );
+	    }
+	}
 	~scoped_lock()
 	{
-	    
+	    if( _stats != NULL ) {
+		if( _stats->conn != 0 ) {
+		    traceSetConnection( 0 );
+		}
+		_stats->released( uv_hrtime() - _acquired );
+	    }
 	    uv_mutex_unlock( &_mtx );
 	}
 
     private:
 	uv_mutex_t &_mtx;
+	lockStats *_stats;
+	uint64_t _acquired;
 
 };
 
-class ExecuteData {
-  public:
-    ~ExecuteData() {
-	clear();
-    }
-
-    void clear( void ) {
-	CLEAN_STRINGS( string_vals );
-	CLEAN_STRINGS( string_arr_vals );
-	CLEAN_PTRS( int_vals );
-	CLEAN_PTRS( num_vals );
-	CLEAN_PTRS( len_vals );
-	CLEAN_PTRS( null_vals );
-    }
-    void	addString( char *str, size_t *len ) {
-	string_vals.push_back( str );
-	len_vals.push_back( len );
-    }
-    void	addStrings( char **str, size_t *len ) {
-	string_arr_vals.push_back( str );
-	len_vals.push_back( len );
-    }
-    void	addInt( int *val ) { int_vals.push_back( val ); }
-    void	addNum( double *val ) { num_vals.push_back( val ); }
-    void	addNull( sacapi_bool *val ) { null_vals.push_back( val ); }
-
-    char *	getString( size_t ind ) { return string_vals[ind]; }
-    char **	getStrings( size_t ind ) { return string_arr_vals[ind]; }
-    int		getInt( size_t ind ) { return *(int_vals[ind]); }
-    double	getNum( size_t ind ) { return *(num_vals[ind]); }
-    size_t	getLen( size_t ind ) { return *(len_vals[ind]); }
-    sacapi_bool	getNull( size_t ind ) { return *(null_vals[ind]); }
-
-    size_t	stringSize( void ) const { return string_vals.size(); }
-    size_t	intSize( void ) const { return int_vals.size(); }
-    size_t	numSize( void ) const { return num_vals.size(); }
-    size_t	lenSize( void ) const { return len_vals.size(); }
-    size_t	nullSize( void ) const { return null_vals.size(); }
-
-    bool	stringIsNull( size_t ind ) const { return string_vals[ind] == NULL; }
-    bool	intIsNull( size_t ind ) const { return int_vals[ind] == NULL; }
-    bool	numIsNull( size_t ind ) const { return num_vals[ind] == NULL; }
-    bool	lenIsNull( size_t ind ) const { return string_vals[ind] == NULL; }
-    bool	nullIsNull( size_t ind ) const { return string_vals[ind] == NULL; }
-
-  private:
-    std::vector<char *>		string_vals;
-    std::vector<char **>	string_arr_vals;
-    std::vector<int *> 		int_vals;
-    std::vector<double *>	num_vals;
-    std::vector<size_t *>	len_vals;
-    std::vector<sacapi_bool *>	null_vals;
-};
-
-bool cleanAPI (); // Finalizes the API and frees up resources
+// Takes a reference on the API for a new connection, initializing it if
+// this is the first. Returns false if dbcapi cannot be loaded.
+bool acquireAPI( unsigned int &max_api_ver );
+// Drops a connection's reference, finalizing the API after the last one
+void releaseAPI();
 int  getError( a_sqlany_connection *conn, char *str, size_t len );
 void getErrorMsg( a_sqlany_connection *conn, std::string &str );
 void getErrorMsg( int code, std::string &str );
@@ -161,8 +136,78 @@ void callBack( std::string *		str,
 	       Persistent<Function> &	callback,
 	       Persistent<Value> &	Result,
 	       bool			callback_required = true );
+
+// Variants used by the *After functions. If the request was made without a
+// callback on a connection in promise mode, the resolver is set and the
+// promise is settled instead of calling the callback.
+void callBack( std::string *			str,
+	       Persistent<Function> &		callback,
+	       Persistent<Promise::Resolver> &	resolver,
+	       Local<Value> &			Result,
+	       bool				callback_required = true );
+void callBack( std::string *			str,
+	       Persistent<Function> &		callback,
+	       Persistent<Promise::Resolver> &	resolver,
+	       Persistent<Value> &		Result,
+	       bool				callback_required = true );
+
+Local<Value> newPromise( Isolate *isolate, Persistent<Promise::Resolver> &resolver );
+void settlePromise( std::string *			str,
+		    Persistent<Promise::Resolver> &	resolver,
+		    Local<Value> &			Result );
+void returnError( const FunctionCallbackInfo<Value> &	args,
+		  std::string &				error_msg,
+		  int					cbfunc_arg,
+		  bool					callback_required,
+		  bool					promise_required );
 #endif
 
+// Read a named property of an options object. They return false, leaving
+// value untouched, if the option is not set.
+bool getOption( Isolate *isolate, Local<Object> options, const char *name,
+		Local<Value> &value );
+bool getBoolOption( Isolate *isolate, Local<Object> options, const char *name,
+		    bool &value );
+bool getNumberOption( Isolate *isolate, Local<Object> options, const char *name,
+		      double &value );
+
+// Accumulate the phases of a finished query into the connection's timings,
+// and build the object returned by Connection::getTimings.
+void addTiming( queryTimings &timings, queryTiming &timing );
+Local<Object> timingsObject( Isolate *isolate, queryTimings &timings );
+// Build an object with the phase durations of a single query
+Local<Object> timingObject( Isolate *isolate, queryTiming &timing );
+
+// An operation published on the diagnostics channels that lib/index.js
+// registers through setDiagnosticsChannels. It is only active if the
+// channels had subscribers when the operation started.
+struct diagEvent {
+    bool		active;
+    const char *	kind;
+    std::string		sql;
+    size_t		num_params;
+    // The number of statements of an execBatch, which has no single SQL text
+    size_t		num_statements;
+    uint64_t		start;
+
+    diagEvent() {
+	active = false;
+	kind = NULL;
+	num_params = 0;
+	num_statements = 0;
+	start = 0;
+    }
+};
+
+NODE_API_FUNC( setDiagnosticsChannels );
+// Publish the start event of an operation if anyone is listening.
+void diagStart( diagEvent &event, const char *kind, const std::string &sql,
+		size_t num_params );
+// Publish the end event of an active operation, preceded by an error event
+// if error_msg is set. Operation specific fields may be passed in details.
+void diagEnd( diagEvent &event, std::string *error_msg, Local<Object> details );
+void diagEnd( diagEvent &event, std::string *error_msg );
+
 bool getBindParameters( std::vector<ExecuteData *>		&execData
                         , Isolate *                 isolate
                         , Local<Value>              arg
@@ -184,19 +229,32 @@ bool getResultSet( Persistent<Value> 			&Result
 		 , std::vector<a_sqlany_data_type> 	&col_types );
 #endif
 
-bool fetchResultSet( a_sqlany_stmt 			*sqlany_stmt
-		   , int 				&rows_affected
-		   , std::vector<char *> 		&colNames
-		   , ExecuteData			*execData
-		   , std::vector<a_sqlany_data_type> 	&col_types );
+// Build the object returned by Connection::stats and the module's stats
+Local<Object> statsObject( Isolate *isolate, driverStats &stats );
+NODE_API_FUNC( getGlobalStats );
+NODE_API_FUNC( getTopStatements );
+// Build the object returned by Connection::lockStats, and the module's
+// lockStats of all the driver's locks
+Local<Object> lockStatsObject( Isolate *isolate, lockStats &stats );
+NODE_API_FUNC( getLockStats );
+// Start and stop writing a trace file (see trace.h)
+NODE_API_FUNC( startTrace );
+NODE_API_FUNC( stopTrace );
+
+// Report native memory held for JavaScript objects to V8. The amount charged
+// is accumulated in `charged` so it can be released in one call.
+void chargeExternalMemory( int64_t &charged, int64_t bytes );
+void releaseExternalMemory( int64_t &charged );
 
 struct noParamBaton {
     Persistent<Function> 	callback;
+    Persistent<Promise::Resolver> resolver;
     bool 			err;
     std::string 		error_msg;
     bool 			callback_required;
     
     Connection *obj;
+    diagEvent			diag;
     
     noParamBaton() {
 	obj = NULL;
@@ -205,9 +263,20 @@ struct noParamBaton {
     
     ~noParamBaton() {
 	obj = NULL;
+	resolver.Reset();
     }
 };
 
+// Queues work on the libuv thread pool. The after_cb is called on the main
+// thread once the work is done, batched with other requests completing at
+// the same time. It runs in the async context of the caller of queueWork,
+// under an async resource of the given type name. If charge_cb is given, it
+// is called on the main thread for each request of the batch before any
+// after_cb runs, to report the native memory of the result to V8.
+void initCompletionQueue( void );
+int  queueWork( uv_work_t *req, uv_work_cb work_cb, uv_after_work_cb after_cb,
+		const char *resource_name, uv_work_cb charge_cb = NULL );
+
 void executeAfter( uv_work_t *req );
 void executeWork( uv_work_t *req );
 
@@ -0,0 +1,89 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+#ifndef STATEMENTS_H
+#define STATEMENTS_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <stdint.h>
+#include "uv.h"
+
+// Returns the SQL text with literals replaced by ?, IN lists collapsed to
+// IN (?), comments removed and white space collapsed, so that executions
+// of the same statement with different values share one fingerprint.
+std::string fingerprintSql( const std::string &sql );
+
+// Log-linear latency histogram in microseconds. Each power of two is split
+// into HIST_SUB_BUCKETS buckets, so recorded values keep about 12% precision.
+#define HIST_SUB_BITS		3
+#define HIST_SUB_BUCKETS	( 1 << HIST_SUB_BITS )
+#define HIST_MAGNITUDES		32
+#define HIST_NUM_BUCKETS	( HIST_MAGNITUDES * HIST_SUB_BUCKETS )
+
+class latencyHistogram {
+  public:
+    latencyHistogram();
+
+    void	record( uint64_t micros );
+    // Returns the value below which the given fraction of samples fall
+    uint64_t	percentile( double fraction ) const;
+    uint64_t	maximum( void ) const { return max; }
+
+  private:
+    uint32_t	buckets[HIST_NUM_BUCKETS];
+    uint64_t	count;
+    uint64_t	max;
+};
+
+enum statementPhase {
+    PHASE_PREPARE,
+    PHASE_EXECUTE,
+    PHASE_FETCH,
+    PHASE_NUM_PHASES
+};
+
+struct statementEntry {
+    std::string		fingerprint;
+    uint64_t		calls;
+    uint64_t		errors;
+    uint64_t		total_ns;
+    latencyHistogram	phases[PHASE_NUM_PHASES];
+
+    statementEntry() {
+	calls = 0;
+	errors = 0;
+	total_ns = 0;
+    }
+};
+
+// Latency of each statement fingerprint, over all connections. Holds at
+// most STATEMENT_STATS_LIMIT fingerprints; the least recently executed one
+// is dropped to make room for a new one.
+#define STATEMENT_STATS_LIMIT	128
+
+class statementRegistry {
+  public:
+    statementRegistry();
+    ~statementRegistry();
+
+    // Records one execution; durations are in nanoseconds
+    void record( const std::string &fingerprint, bool error,
+		 const uint64_t durations[PHASE_NUM_PHASES] );
+    // Copies the entries with the highest total time, highest first
+    void top( size_t limit, std::vector<statementEntry> &entries );
+    void clear( void );
+
+  private:
+    typedef std::list<statementEntry>	entryList;
+
+    uv_mutex_t					mutex;
+    entryList					lru;	// most recent first
+    std::map<std::string, entryList::iterator>	index;
+};
+
+statementRegistry &statementStats( void );
+
+#endif
@@ -0,0 +1,140 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+// Cumulative driver counters. Each connection keeps its own set, and every
+// update is also applied to the module-wide set returned by globalStats().
+// The counters are updated from worker threads without holding a lock.
+enum statCounter {
+    STAT_EXECUTES,		// statements executed
+    STAT_PREPARES,		// statements prepared
+    STAT_CACHE_HITS,		// prepares answered from the statement cache
+    STAT_FETCH_CALLS,		// calls to sqlany_fetch_next
+    STAT_ROWS_FETCHED,
+    STAT_BYTES_FETCHED_STRING,
+    STAT_BYTES_FETCHED_BINARY,
+    STAT_BYTES_FETCHED_INT,
+    STAT_BYTES_FETCHED_DOUBLE,
+    STAT_ROWS_BOUND,
+    STAT_BYTES_BOUND,
+    STAT_PEAK_RESULT_BYTES,	// largest result set held in ExecuteData
+    STAT_REQUESTS_EXPIRED,	// executions dropped because their deadline passed
+    STAT_NUM_COUNTERS
+};
+
+class driverStats {
+  public:
+    driverStats() {
+	for( int i = 0; i < STAT_NUM_COUNTERS; i++ ) {
+	    counters[i].store( 0, std::memory_order_relaxed );
+	}
+    }
+
+    uint64_t get( statCounter which ) const {
+	return counters[which].load( std::memory_order_relaxed );
+    }
+
+    // Adds to the counter here and in the module-wide set
+    void add( statCounter which, uint64_t n );
+    // Raises a peak counter here and in the module-wide set
+    void peak( statCounter which, uint64_t n );
+
+    static const char *name( statCounter which );
+
+  private:
+    void addLocal( statCounter which, uint64_t n ) {
+	counters[which].fetch_add( n, std::memory_order_relaxed );
+    }
+    void peakLocal( statCounter which, uint64_t n );
+
+    std::atomic<uint64_t>	counters[STAT_NUM_COUNTERS];
+};
+
+driverStats &globalStats( void );
+
+// Counts the rows and bytes of one fetch locally, and adds them to the
+// stats once when it goes out of scope.
+class fetchCounter {
+  public:
+    fetchCounter( driverStats *stats ) : _stats( stats ) {
+	fetch_calls = 0;
+	rows = 0;
+	bytes_string = 0;
+	bytes_binary = 0;
+	bytes_int = 0;
+	bytes_double = 0;
+    }
+    ~fetchCounter();
+
+    uint64_t	fetch_calls;
+    uint64_t	rows;
+    uint64_t	bytes_string;
+    uint64_t	bytes_binary;
+    uint64_t	bytes_int;
+    uint64_t	bytes_double;
+
+    uint64_t	bytes( void ) const {
+	return bytes_string + bytes_binary + bytes_int + bytes_double;
+    }
+
+  private:
+    driverStats	*_stats;
+};
+
+// Contention counters for a mutex. Times are in nanoseconds.
+enum lockCounter {
+    LOCK_ACQUISITIONS,
+    LOCK_CONTENDED,		// acquisitions that had to wait
+    LOCK_WAIT_NS,
+    LOCK_MAX_WAIT_NS,
+    LOCK_HOLD_NS,
+    LOCK_MAX_HOLD_NS,
+    LOCK_NUM_COUNTERS
+};
+
+// The counters of one mutex. A connection's conn_mutex has its own set,
+// and every update is also applied to the set of all conn_mutexes.
+class lockStats {
+  public:
+    lockStats( const char *lock_name, lockStats *total = NULL ) {
+	name = lock_name;
+	conn = 0;
+	_total = total;
+	for( int i = 0; i < LOCK_NUM_COUNTERS; i++ ) {
+	    counters[i].store( 0, std::memory_order_relaxed );
+	}
+    }
+
+    uint64_t get( lockCounter which ) const {
+	return counters[which].load( std::memory_order_relaxed );
+    }
+
+    void acquired( bool contended, uint64_t wait_ns );
+    void released( uint64_t hold_ns );
+
+    static const char *counterName( lockCounter which );
+
+    const char *	name;
+    // The connection whose conn_mutex this is, or 0
+    unsigned		conn;
+
+  private:
+    void acquiredLocal( bool contended, uint64_t wait_ns );
+    void releasedLocal( uint64_t hold_ns );
+
+    lockStats *			_total;
+    std::atomic<uint64_t>	counters[LOCK_NUM_COUNTERS];
+};
+
+// The driver's module-wide mutexes, and the sum over all conn_mutexes
+lockStats &apiLockStats( void );
+lockStats &connLockStats( void );
+lockStats &completionLockStats( void );
+
+#endif
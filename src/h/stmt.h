@@ -90,6 +90,52 @@ class StmtObject : public node::ObjectWrap
      *
      */
     static NODE_API_FUNC( exec );
+
+    /** Executes the prepared SQL statement once for each set of parameters.
+     *
+     * This method takes in an array of bind parameter arrays and executes
+     * the statement once per array. All of the executions are performed
+     * one after another in a single request, so there is no round trip
+     * to the main thread between them. Queries are supported as well as
+     * insert, update and delete statements. Execution stops at the first
+     * error.
+     *
+     * This method can be either synchronous or asynchronous depending on
+     * whether or not a callback function is specified.
+     * The callback function is of the form:
+     *
+     * <p><pre>
+     * function( err, results )
+     * {
+     *
+     * };
+     * </pre></p>
+     *
+     * The results array holds one entry per parameter array, in the same
+     * form that the exec method returns.
+     *
+     * The following synchronous example shows how to use the execMany method.
+     *
+     * <p><pre>
+     * var sqlanywhere = require( 'sqlanywhere' );
+     * var client = sqlanywhere.createConnection();
+     * client.connect( "ServerName=demo17;UID=DBA;PWD=sql" )
+     * stmt = client.prepare( "SELECT * FROM Customers WHERE ID = ?" );
+     * results = stmt.execMany( [ [101], [102], [103] ] );
+     * stmt.drop();
+     * console.log( results[1] );
+     * client.disconnect();
+     * </pre></p>
+     *
+     * @fn results Statement::execMany( Array paramSets, Function callback )
+     *
+     * @param paramSets An array of bind parameter arrays.
+     * @param callback The optional callback function.
+     *
+     * @return If no callback is specified, the array of results is returned.
+     *
+     */
+    static NODE_API_FUNC( execMany );
     
     /** Drops the statement.
      *
@@ -168,9 +214,64 @@ class StmtObject : public node::ObjectWrap
      */
     static NODE_API_FUNC( getMoreResults );
 
+    /** Executes the statement and fetches all of its result sets.
+     *
+     * This method executes the prepared statement and then fetches every
+     * result set it returns, such as those of a procedure call or of a
+     * batch of queries, in a single request. This saves calling
+     * getMoreResults once per result set.
+     *
+     * This method can be either synchronous or asynchronous depending on
+     * whether or not a callback function is specified.
+     * The callback function is of the form:
+     *
+     * <p><pre>
+     * function( err, results )
+     * {
+     *
+     * };
+     * </pre></p>
+     *
+     * The results array holds one entry per result set, in the same form
+     * that the exec method returns.
+     *
+     * The following synchronous example shows how to use the execAll method.
+     *
+     * <p><pre>
+     * var sqlanywhere = require( 'sqlanywhere' );
+     * var client = sqlanywhere.createConnection();
+     * client.connect( "ServerName=demo17;UID=DBA;PWD=sql" )
+     * stmt = client.prepare( "SELECT * FROM Customers WHERE ID = ?; SELECT * FROM Customers where ID = ?" );
+     * results = stmt.execAll( [200, 300] );
+     * console.log( results[0] ); // first query
+     * console.log( results[1] ); // second query
+     * stmt.drop();
+     * client.disconnect();
+     * </pre></p>
+     *
+     * @fn results Statement::execAll( Array params, Function callback )
+     *
+     * @param params The optional array of bind parameters.
+     * @param callback The optional callback function.
+     *
+     * @return If no callback is specified, the array of results is returned.
+     *
+     */
+    static NODE_API_FUNC( execAll );
+
   public:
     /// @internal
     Connection		*connection;
     /// @internal
     a_sqlany_stmt	*sqlany_stmt;
+    /// @internal
+    bool		promise_mode;
+    /// @internal
+    std::string		sql;
+    /// @internal
+    bool		cached;	// sqlany_stmt goes back to the statement cache
+    /// @internal
+    std::string		fingerprint;
+    /// @internal
+    int64_t		external_bytes;
 };
@@ -0,0 +1,62 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <string.h>
+#include <stdint.h>
+#include "uv.h"
+
+// Points in the life of a query at which a timestamp is taken
+enum timingMark {
+    TIMING_ENQUEUED,		// work handed to the thread pool
+    TIMING_WORKER_STARTED,	// worker thread picked the work up
+    TIMING_LOCKED,		// conn_mutex acquired
+    TIMING_PREPARED,		// statement prepared
+    TIMING_BOUND,		// parameters bound
+    TIMING_EXECUTED,		// sqlany_execute returned
+    TIMING_FETCHED,		// all rows fetched
+    TIMING_AFTER_STARTED,	// back on the main thread
+    TIMING_MATERIALIZED,	// getResultSet complete
+    TIMING_CALLBACK_DONE,	// callback returned or promise settled
+    TIMING_NUM_MARKS
+};
+
+// Phases measured between consecutive marks
+#define TIMING_NUM_PHASES	( TIMING_NUM_MARKS - 1 )
+
+struct queryTiming {
+    bool	enabled;
+    uint64_t	marks[TIMING_NUM_MARKS];
+
+    queryTiming() {
+	enabled = false;
+	memset( marks, 0, sizeof( marks ) );
+    }
+
+    void mark( timingMark which ) {
+	if( enabled ) {
+	    marks[which] = uv_hrtime();
+	}
+    }
+};
+
+// Per-connection phase durations in nanoseconds
+struct queryTimings {
+    unsigned	count;
+    uint64_t	last[TIMING_NUM_PHASES];
+    uint64_t	total[TIMING_NUM_PHASES];
+
+    queryTimings() {
+	reset();
+    }
+
+    void reset() {
+	count = 0;
+	memset( last, 0, sizeof( last ) );
+	memset( total, 0, sizeof( total ) );
+    }
+};
+
+#endif
@@ -0,0 +1,71 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+// Opt-in tracing of driver activity in the Chrome trace event format, for
+// loading into chrome://tracing or Perfetto. When tracing is on, the driver
+// records when work waits in the thread pool queue, when it waits for a
+// connection, each dbcapi call it makes and the time spent on the main
+// thread turning results into JavaScript values. Each thread gets its own
+// track, and spans are tagged with the connection they were made for.
+//
+// Tracing is off by default. It costs one relaxed atomic load per span
+// while off.
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+extern std::atomic<bool> trace_enabled;
+
+inline bool traceEnabled( void )
+{
+    return trace_enabled.load( std::memory_order_relaxed );
+}
+
+// Starts writing a trace to the file, replacing any trace in progress.
+// The calling thread is named "main". Returns false if the file cannot be
+// created.
+bool traceStart( const std::string &file );
+// Completes the trace in progress and closes its file
+void traceStop( void );
+
+// Microseconds on the clock used for the trace
+uint64_t traceNow( void );
+
+// The connection the calling thread is working for, or 0. Spans recorded
+// by the thread are tagged with it.
+void traceSetConnection( unsigned conn );
+
+// Records a span on the calling thread's track
+void traceComplete( const char *name, const char *category,
+		    uint64_t start_us, uint64_t end_us );
+// Records the start or end of a span that may begin and end on different
+// threads, such as the wait in the thread pool queue. The name, category
+// and id of the two ends must match.
+void traceAsync( const char *name, const char *category, bool begin,
+		 const void *id, uint64_t ts_us );
+
+// Records a span from construction to destruction. The strings must
+// outlive the span.
+class traceSpan {
+  public:
+    traceSpan( const char *name, const char *category = "dbcapi" ) {
+	_name = name;
+	_category = category;
+	_start = traceEnabled() ? traceNow() : 0;
+    }
+    ~traceSpan() {
+	if( _start != 0 && traceEnabled() ) {
+	    traceComplete( _name, _category, _start, traceNow() );
+	}
+    }
+
+  private:
+    const char *	_name;
+    const char *	_category;
+    uint64_t		_start;
+};
+
+#endif
@@ -0,0 +1,214 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <deque>
+#include "uv.h"
+#include "slowlog.h"
+
+static const char *phase_names[SLOW_NUM_PHASES] = {
+    "queueWait",
+    "lockWait",
+    "prepare",
+    "bind",
+    "execute",
+    "fetch"
+};
+
+const char *slowQueryRecord::phaseName( slowQueryPhase phase )
+/************************************************************/
+{
+    return phase_names[phase];
+}
+
+static void appendJsonString( std::string &out, const std::string &value )
+/************************************************************************/
+{
+    out += '"';
+    for( size_t i = 0; i < value.length(); i++ ) {
+	unsigned char c = (unsigned char)value[i];
+	switch( c ) {
+	    case '"':	out += "\\\""; break;
+	    case '\\':	out += "\\\\"; break;
+	    case '\n':	out += "\\n"; break;
+	    case '\r':	out += "\\r"; break;
+	    case '\t':	out += "\\t"; break;
+	    default:
+		if( c < 0x20 ) {
+		    char buffer[8];
+		    snprintf( buffer, sizeof( buffer ), "\\u%04x", c );
+		    out += buffer;
+		} else {
+		    out += (char)c;
+		}
+	}
+    }
+    out += '"';
+}
+
+static void appendJsonNumber( std::string &out, double value )
+/************************************************************/
+{
+    char buffer[32];
+    snprintf( buffer, sizeof( buffer ), "%.3f", value );
+    out += buffer;
+}
+
+static void appendJsonInteger( std::string &out, long long value )
+/****************************************************************/
+{
+    char buffer[32];
+    snprintf( buffer, sizeof( buffer ), "%lld", value );
+    out += buffer;
+}
+
+std::string slowQueryRecord::toJson( void ) const
+/***********************************************/
+{
+    std::string out = "{\"sql\":";
+    appendJsonString( out, sql );
+    out += ",\"params\":[";
+    for( size_t i = 0; i < params.size(); i++ ) {
+	if( i > 0 ) {
+	    out += ',';
+	}
+	appendJsonString( out, params[i] );
+    }
+    out += "],\"paramRows\":";
+    appendJsonInteger( out, param_rows );
+    out += ",\"duration\":";
+    appendJsonNumber( out, total_ms );
+    out += ",\"timings\":{";
+    for( int i = 0; i < SLOW_NUM_PHASES; i++ ) {
+	if( i > 0 ) {
+	    out += ',';
+	}
+	appendJsonString( out, phase_names[i] );
+	out += ':';
+	appendJsonNumber( out, phases_ms[i] );
+    }
+    out += "},\"rowsAffected\":";
+    appendJsonInteger( out, rows_affected );
+    out += ",\"rows\":";
+    appendJsonInteger( out, (long long)rows );
+    if( error.length() > 0 ) {
+	out += ",\"error\":";
+	appendJsonString( out, error );
+    }
+    out += '}';
+    return out;
+}
+
+std::string summarizeString( const char *value, size_t length )
+/*************************************************************/
+{
+    std::string summary = "'";
+    if( length > SLOW_PARAM_PREVIEW ) {
+	summary.append( value, SLOW_PARAM_PREVIEW );
+	summary += "'...";
+    } else {
+	summary.append( value, length );
+	summary += "'";
+    }
+    return summary;
+}
+
+// Lines are queued and written by one background thread, which keeps the
+// file open between writes, so a worker reporting a slow query never waits
+// for the disk or for other workers writing.
+struct logLine {
+    std::string	file;
+    std::string	line;
+};
+
+// Lines beyond this many waiting to be written are dropped
+#define SLOW_LOG_MAX_QUEUED	10000
+
+static uv_once_t		log_once = UV_ONCE_INIT;
+static uv_mutex_t		log_mutex;
+static uv_cond_t		log_cond;
+static uv_thread_t		log_thread;
+static std::deque<logLine>	log_queue;
+static bool			log_stopping = false;
+
+static void logWriter( void *arg )
+/********************************/
+{
+    FILE *fp = NULL;
+    std::string open_file;
+    std::deque<logLine> lines;
+
+    uv_mutex_lock( &log_mutex );
+    while( true ) {
+	while( log_queue.empty() && !log_stopping ) {
+	    uv_cond_wait( &log_cond, &log_mutex );
+	}
+	if( log_queue.empty() ) {
+	    break;
+	}
+	lines.swap( log_queue );
+	uv_mutex_unlock( &log_mutex );
+
+	for( size_t i = 0; i < lines.size(); i++ ) {
+	    if( fp == NULL || lines[i].file != open_file ) {
+		if( fp != NULL ) {
+		    fclose( fp );
+		}
+		fp = fopen( lines[i].file.c_str(), "a" );
+		open_file = lines[i].file;
+	    }
+	    if( fp != NULL ) {
+		fwrite( lines[i].line.c_str(), 1, lines[i].line.length(), fp );
+		fputc( '\n', fp );
+	    }
+	}
+	if( fp != NULL ) {
+	    fflush( fp );
+	}
+	lines.clear();
+	uv_mutex_lock( &log_mutex );
+    }
+    uv_mutex_unlock( &log_mutex );
+    if( fp != NULL ) {
+	fclose( fp );
+    }
+}
+
+// Writes out the lines still queued before the process exits
+static void stopLogWriter( void )
+/*******************************/
+{
+    uv_mutex_lock( &log_mutex );
+    log_stopping = true;
+    uv_cond_signal( &log_cond );
+    uv_mutex_unlock( &log_mutex );
+    uv_thread_join( &log_thread );
+}
+
+static void startLogWriter( void )
+/********************************/
+{
+    uv_mutex_init( &log_mutex );
+    uv_cond_init( &log_cond );
+    if( uv_thread_create( &log_thread, logWriter, NULL ) == 0 ) {
+	atexit( stopLogWriter );
+    } else {
+	log_stopping = true;
+    }
+}
+
+void appendSlowQueryLog( const std::string &file, const std::string &line )
+/*************************************************************************/
+{
+    uv_once( &log_once, startLogWriter );
+    uv_mutex_lock( &log_mutex );
+    if( !log_stopping && log_queue.size() < SLOW_LOG_MAX_QUEUED ) {
+	logLine entry;
+	entry.file = file;
+	entry.line = line;
+	log_queue.push_back( entry );
+	uv_cond_signal( &log_cond );
+    }
+    uv_mutex_unlock( &log_mutex );
+}
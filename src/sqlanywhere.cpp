@@ -1,6 +1,7 @@
 // ***************************************************************************
 // Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
 // ***************************************************************************
+#include <cmath>
 #include "nodever_cover.h"
 #include "sqlany_utils.h"
 
@@ -8,12 +9,12 @@
 
 using namespace v8;
 
-SQLAnywhereInterface api;
 unsigned openConnections = 0;
 uv_mutex_t api_mutex;
 
 struct executeBaton {
     Persistent<Function>		callback;
+    Persistent<Promise::Resolver>	resolver;
     bool 				err;
     std::string 			error_msg;
     bool 				callback_required;
@@ -31,6 +32,23 @@ struct executeBaton {
     int 				rows_affected;
     std::vector<a_sqlany_data_type> 	col_types;
 
+    queryTiming				timing;
+    diagEvent				diag;
+    bool				record_statement;
+
+    // Slow query log settings of the connection, and what is kept for it
+    double				slow_query_ms;
+    std::string				slow_query_file;
+    ExecuteData				*bound_data;
+    slowQueryRecord			*slow_query;
+
+    resultLimits			limits;
+    // uv_hrtime after which the statement is not executed, or 0
+    uint64_t				deadline;
+
+    // Native memory reported to V8 for this execution
+    int64_t				external_bytes;
+
     executeBaton() {
 	err = false;
 	callback_required = false;
@@ -39,6 +57,12 @@ struct executeBaton {
 	rows_affected = -1;
 	free_stmt = false;
 	num_rows = 0;
+	record_statement = false;
+	slow_query_ms = 0;
+	bound_data = NULL;
+	slow_query = NULL;
+	deadline = 0;
+	external_bytes = 0;
     }
 
     ~executeBaton() {
@@ -49,12 +73,65 @@ struct executeBaton {
 	}
 	col_types.clear();
 	callback.Reset();
+	resolver.Reset();
 	params.clear();
 	CLEAN_STRINGS( colNames );
 	CLEAN_PTRS( execData );
+	delete bound_data;
+	delete slow_query;
+	releaseExternalMemory( external_bytes );
     }
 };
 
+// Publishes the end of an execution on the diagnostics channels
+static void diagExecEnd( executeBaton *baton, std::string *error_msg )
+/********************************************************************/
+{
+    if( !baton->diag.active ) {
+	return;
+    }
+    Isolate *isolate = Isolate::GetCurrent();
+    HandleScope scope( isolate );
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<Object> details = Object::New( isolate );
+
+    if( error_msg == NULL ) {
+	size_t num_cols = baton->colNames.size();
+	size_t rows = num_cols > 0 ? baton->col_types.size() / num_cols : 0;
+	details->Set( context,
+		      String::NewFromUtf8( isolate, "rowsAffected",
+					   NewStringType::kNormal ).ToLocalChecked(),
+		      Integer::New( isolate, baton->rows_affected ) ).FromJust();
+	details->Set( context,
+		      String::NewFromUtf8( isolate, "rows",
+					   NewStringType::kNormal ).ToLocalChecked(),
+		      Number::New( isolate, (double)rows ) ).FromJust();
+	details->Set( context,
+		      String::NewFromUtf8( isolate, "bytes",
+					   NewStringType::kNormal ).ToLocalChecked(),
+		      Number::New( isolate,
+				   (double)baton->execData[0]->dataBytes() ) ).FromJust();
+    }
+    details->Set( context,
+		  String::NewFromUtf8( isolate, "timings",
+				       NewStringType::kNormal ).ToLocalChecked(),
+		  timingObject( isolate, baton->timing ) ).FromJust();
+    diagEnd( baton->diag, error_msg, details );
+}
+
+// Reports the rows fetched for the baton to V8. queueWork calls it as soon as
+// the work is done, so the memory is seen while the result waits to be
+// delivered and while it is converted. It is released with the baton.
+static void chargeResultMemory( uv_work_t *req )
+/**********************************************/
+{
+    executeBaton *baton = static_cast<executeBaton*>(req->data);
+    if( baton->execData.size() > 0 ) {
+	chargeExternalMemory( baton->external_bytes,
+			      (int64_t)baton->execData[0]->dataBytes() );
+    }
+}
+
 static bool fillResult( executeBaton *baton, Persistent<Value> &ResultSet )
 /*************************************************************************/
 {
@@ -63,7 +140,8 @@ static bool fillResult( executeBaton *baton, Persistent<Value> &ResultSet )
     Local<Value> undef = Local<Value>::New( isolate, Undefined( isolate ) );
 
     if( baton->err ) {
-	callBack( &( baton->error_msg ), baton->callback, undef,
+	diagExecEnd( baton, &( baton->error_msg ) );
+	callBack( &( baton->error_msg ), baton->callback, baton->resolver, undef,
 		  baton->callback_required );
 	return false;
     }
@@ -72,31 +150,138 @@ static bool fillResult( executeBaton *baton, Persistent<Value> &ResultSet )
     if( !getResultSet( ResultSet, baton->rows_affected, baton->colNames,
 		       baton->execData[0], baton->col_types ) ) {
 	getErrorMsg( JS_ERR_RESULTSET, baton->error_msg );
-	callBack( &( baton->error_msg ), baton->callback, undef,
+	diagExecEnd( baton, &( baton->error_msg ) );
+	callBack( &( baton->error_msg ), baton->callback, baton->resolver, undef,
 		  baton->callback_required );
 	return false;
     }
-    if( baton->callback_required ) {
-	callBack( NULL, baton->callback, ResultSet, baton->callback_required );
+    baton->timing.mark( TIMING_MATERIALIZED );
+    diagExecEnd( baton, NULL );
+    if( baton->callback_required || !baton->resolver.IsEmpty() ) {
+	callBack( NULL, baton->callback, baton->resolver, ResultSet,
+		  baton->callback_required );
     }
     return true;
 }
 
-void executeWork( uv_work_t *req )
-/********************************/
+// Fails an execution whose result set went over the connection's limits.
+// The cursor is closed and the rows fetched so far are dropped.
+static void resultTooLarge( executeBaton *baton, a_sqlany_stmt *sqlany_stmt )
+/***************************************************************************/
+{
+    api.sqlany_reset( sqlany_stmt );
+    baton->execData[0]->clear();
+    baton->col_types.clear();
+    baton->err = true;
+    getErrorMsg( JS_ERR_RESULT_TOO_LARGE, baton->error_msg );
+}
+
+// Returns the deadline of a request made now on the connection
+static uint64_t requestDeadline( Connection *conn )
+/*************************************************/
+{
+    if( conn->deadline_ms <= 0 ) {
+	return 0;
+    }
+    uint64_t now = uv_hrtime();
+    double ns = conn->deadline_ms * 1e6;
+    if( ns >= (double)( UINT64_MAX - now ) ) {
+	// too far away to ever pass
+	return 0;
+    }
+    return now + (uint64_t)ns;
+}
+
+// Fails the request if it waited past its deadline in the queue; running it
+// now would only add to the load
+static bool requestExpired( executeBaton *baton )
+/***********************************************/
+{
+    if( baton->deadline == 0 || uv_hrtime() <= baton->deadline ) {
+	return false;
+    }
+    baton->obj->stats.add( STAT_REQUESTS_EXPIRED, 1 );
+    baton->err = true;
+    getErrorMsg( JS_ERR_DEADLINE_EXCEEDED, baton->error_msg );
+    return true;
+}
+
+// Binds the parameters held in the baton, executes the statement and
+// fetches its result into the baton. The caller must hold conn_mutex.
+static bool executeStatement( executeBaton *baton, a_sqlany_stmt *sqlany_stmt )
+/*****************************************************************************/
 {
     int rc = 0;
     int sqlcode = 0;
 
-    executeBaton *baton = static_cast<executeBaton*>(req->data);
-    scoped_lock lock( baton->obj->conn_mutex );
+    if( requestExpired( baton ) ) {
+	return false;
+    }
 
-    if( baton->obj->conn == NULL ) {
+    if( !api.sqlany_reset( sqlany_stmt ) ) {
 	baton->err = true;
-	getErrorMsg( JS_ERR_NOT_CONNECTED, baton->error_msg );
-	return;
+	getErrorMsg( baton->obj->conn, baton->error_msg );
+	return false;
+    }
+
+    if( !bindParameters( sqlany_stmt, baton->params, baton->num_rows ) ) {
+	baton->err = true;
+	getErrorMsg( baton->obj->conn, baton->error_msg );
+	return false;
+    }
+    baton->timing.mark( TIMING_BOUND );
+
+    if( baton->params.size() > 0 ) {
+	baton->obj->stats.add( STAT_ROWS_BOUND, baton->num_rows );
+	baton->obj->stats.add( STAT_BYTES_BOUND, boundBytes( baton->params, baton->num_rows ) );
     }
     
+    sacapi_bool success_execute;
+    {
+	traceSpan span( "sqlany_execute" );
+	success_execute = api.sqlany_execute( sqlany_stmt );
+    }
+    baton->obj->stats.add( STAT_EXECUTES, 1 );
+    baton->timing.mark( TIMING_EXECUTED );
+    if( baton->slow_query_ms > 0 && baton->bound_data == NULL ) {
+	// Keep the bound values in case the query turns out to be slow
+	baton->bound_data = baton->execData[0];
+	baton->execData[0] = new ExecuteData;
+    } else {
+	baton->execData[0]->clear();
+    }
+
+    if( !success_execute ) {
+	baton->err = true;
+	getErrorMsg( baton->obj->conn, baton->error_msg );
+	return false;
+    }
+
+    rc = fetchResultSet( sqlany_stmt, baton->rows_affected, baton->colNames,
+		    baton->execData[0], baton->col_types, &baton->obj->stats,
+		    &baton->limits );
+    baton->timing.mark( TIMING_FETCHED );
+
+    if( baton->limits.exceeded ) {
+	resultTooLarge( baton, sqlany_stmt );
+	return false;
+    }
+    if( !rc ) {
+	sqlcode = getError( baton->obj->conn, NULL, 0 );
+	if( (sqlcode != 0) && (sqlcode != 100) ) {
+	    baton->err = true;
+	    getErrorMsg( baton->obj->conn, baton->error_msg );
+	    return false;
+	}
+    }
+    return true;
+}
+
+// Returns the statement handle for the baton, preparing the SQL text of the
+// baton first if it has no statement yet. The caller must hold conn_mutex.
+static a_sqlany_stmt *prepareStatement( executeBaton *baton )
+/***********************************************************/
+{
     a_sqlany_stmt *sqlany_stmt = NULL;
     if( baton->stmt_obj == NULL ) {
 	baton->stmt_obj = new StmtObject();
@@ -107,68 +292,268 @@ void executeWork( uv_work_t *req )
     }
 
     if( sqlany_stmt == NULL && baton->stmt.length() > 0 ) {
-	sqlany_stmt = api.sqlany_prepare( baton->obj->conn,
-					  baton->stmt.c_str() );
-	if( sqlany_stmt == NULL ) {
-	    baton->err = true;
-	    getErrorMsg( baton->obj->conn, baton->error_msg );
-	    return;
+	sqlany_stmt = baton->obj->takeCachedStmt( baton->stmt );
+	if( sqlany_stmt != NULL ) {
+	    baton->stmt_obj->sql = baton->stmt;
+	    baton->stmt_obj->cached = true;
+	} else {
+	    {
+		traceSpan span( "sqlany_prepare" );
+		sqlany_stmt = api.sqlany_prepare( baton->obj->conn,
+						  baton->stmt.c_str() );
+	    }
+	    baton->obj->stats.add( STAT_PREPARES, 1 );
+	    if( sqlany_stmt == NULL ) {
+		baton->err = true;
+		getErrorMsg( baton->obj->conn, baton->error_msg );
+		return NULL;
+	    }
 	}
 	baton->stmt_obj->sqlany_stmt = sqlany_stmt;
 
     } else if( sqlany_stmt == NULL ) {
 	baton->err = true;
 	getErrorMsg( JS_ERR_INVALID_OBJECT, baton->error_msg );
-	return;
+	return NULL;
     }
-    
-    if( !api.sqlany_reset( sqlany_stmt ) ) {
-	baton->err = true;
-	getErrorMsg( baton->obj->conn, baton->error_msg );
-	return;
+    baton->timing.mark( TIMING_PREPARED );
+    return sqlany_stmt;
+}
+
+static uint64_t markDiff( queryTiming &timing, timingMark from, timingMark to )
+/****************************************************************************/
+{
+    return timing.marks[to] > timing.marks[from] ?
+	   timing.marks[to] - timing.marks[from] : 0;
+}
+
+// Adds the execution to the per-fingerprint latency histograms. Called on
+// the worker thread with conn_mutex held.
+static void recordStatement( executeBaton *baton )
+/************************************************/
+{
+    std::string direct_fingerprint;
+    const std::string *fingerprint;
+    if( baton->stmt.length() > 0 ) {
+	direct_fingerprint = fingerprintSql( baton->stmt );
+	fingerprint = &direct_fingerprint;
+    } else {
+	// prepared statements keep their fingerprint
+	if( baton->stmt_obj->fingerprint.length() == 0 ) {
+	    baton->stmt_obj->fingerprint = fingerprintSql( baton->stmt_obj->sql );
+	}
+	fingerprint = &baton->stmt_obj->fingerprint;
     }
 
-    for( unsigned int i = 0; i < baton->params.size(); i++ ) {
-	a_sqlany_bind_param 	param;
-	
-	if( !api.sqlany_describe_bind_param( sqlany_stmt, i, &param ) ) {
-	    baton->err = true;
-	    getErrorMsg( baton->obj->conn, baton->error_msg );
-	    return;
+    uint64_t durations[PHASE_NUM_PHASES];
+    durations[PHASE_PREPARE] = markDiff( baton->timing, TIMING_LOCKED, TIMING_PREPARED );
+    durations[PHASE_EXECUTE] = markDiff( baton->timing, TIMING_BOUND, TIMING_EXECUTED );
+    durations[PHASE_FETCH] = markDiff( baton->timing, TIMING_EXECUTED, TIMING_FETCHED );
+    statementStats().record( *fingerprint, baton->err, durations );
+}
+
+// Returns a summary of the value bound to a parameter in the first row
+static std::string summarizeParam( a_sqlany_data_value &value )
+/*************************************************************/
+{
+    if( value.is_null != NULL && value.is_null[0] ) {
+	return "NULL";
+    }
+    char buffer[32];
+    switch( value.type ) {
+	case A_STRING:
+	case A_BINARY:
+	{
+	    const char *data = value.is_address ? *(char **)value.buffer
+						: value.buffer;
+	    size_t length = value.length != NULL ? value.length[0] : 0;
+	    if( value.type == A_BINARY ) {
+		snprintf( buffer, sizeof( buffer ), "<%lu bytes>",
+			  (unsigned long)length );
+		return buffer;
+	    }
+	    return summarizeString( data, length );
 	}
+	case A_DOUBLE:
+	    snprintf( buffer, sizeof( buffer ), "%.17g", *(double *)value.buffer );
+	    return buffer;
+	case A_VAL32:
+	    snprintf( buffer, sizeof( buffer ), "%d", *(int *)value.buffer );
+	    return buffer;
+	default:
+	    return "NULL";
+    }
+}
 
-        memcpy( &param.value, &baton->params[i].value, sizeof( param.value ) );
+// Builds a slow query record if the execution took longer than the
+// connection's threshold. The record is queued for the log file writer, or
+// kept in the baton for the JavaScript sink.
+static void checkSlowQuery( executeBaton *baton )
+/***********************************************/
+{
+    queryTiming &timing = baton->timing;
+    uint64_t elapsed = uv_hrtime() - timing.marks[TIMING_ENQUEUED];
+    if( (double)elapsed / 1e6 < baton->slow_query_ms ) {
+	return;
+    }
 
-	if( !api.sqlany_bind_param( sqlany_stmt, i, &param ) ) {
-	    baton->err = true;
-	    getErrorMsg( baton->obj->conn, baton->error_msg );
-	    return;
+    slowQueryRecord *record = new slowQueryRecord();
+    record->sql = baton->stmt.length() > 0 ? baton->stmt : baton->stmt_obj->sql;
+    if( baton->bound_data != NULL ) {
+	for( size_t i = 0; i < baton->params.size(); i++ ) {
+	    record->params.push_back( summarizeParam( baton->params[i].value ) );
 	}
+	record->param_rows = baton->num_rows;
+    }
+    record->total_ms = (double)elapsed / 1e6;
+    record->phases_ms[SLOW_QUEUE_WAIT] =
+	markDiff( timing, TIMING_ENQUEUED, TIMING_WORKER_STARTED ) / 1e6;
+    record->phases_ms[SLOW_LOCK_WAIT] =
+	markDiff( timing, TIMING_WORKER_STARTED, TIMING_LOCKED ) / 1e6;
+    record->phases_ms[SLOW_PREPARE] =
+	markDiff( timing, TIMING_LOCKED, TIMING_PREPARED ) / 1e6;
+    record->phases_ms[SLOW_BIND] =
+	markDiff( timing, TIMING_PREPARED, TIMING_BOUND ) / 1e6;
+    record->phases_ms[SLOW_EXECUTE] =
+	markDiff( timing, TIMING_BOUND, TIMING_EXECUTED ) / 1e6;
+    record->phases_ms[SLOW_FETCH] =
+	markDiff( timing, TIMING_EXECUTED, TIMING_FETCHED ) / 1e6;
+    record->rows_affected = baton->rows_affected;
+    if( baton->colNames.size() > 0 ) {
+	record->rows = baton->col_types.size() / baton->colNames.size();
+    }
+    if( baton->err ) {
+	record->error = baton->error_msg;
     }
 
-    if( baton->num_rows > 1 ) {
-	api.sqlany_set_batch_size( sqlany_stmt, baton->num_rows );
+    if( baton->slow_query_file.length() > 0 ) {
+	appendSlowQueryLog( baton->slow_query_file, record->toJson() );
+	delete record;
+    } else {
+	baton->slow_query = record;
     }
-    
-    sacapi_bool success_execute = api.sqlany_execute( sqlany_stmt );
-    baton->execData[0]->clear();
+}
 
-    if( !success_execute ) {
+// Feeds a finished execution to the statement statistics and the slow query
+// log. Called on the worker, with the connection locked.
+static void noteExecution( executeBaton *baton )
+/**********************************************/
+{
+    if( baton->record_statement ) {
+	recordStatement( baton );
+    }
+    if( baton->slow_query_ms > 0 ) {
+	checkSlowQuery( baton );
+    }
+}
+
+// Passes the slow query record of the baton, if any, to the connection's
+// sink. Called on the main thread.
+static void reportSlowQuery( executeBaton *baton )
+/************************************************/
+{
+    if( baton->slow_query == NULL || baton->obj->slow_query_sink.IsEmpty() ) {
+	return;
+    }
+    Isolate *isolate = Isolate::GetCurrent();
+    HandleScope scope( isolate );
+    Local<Context> context = isolate->GetCurrentContext();
+    slowQueryRecord *record = baton->slow_query;
+
+    Local<Object> obj = Object::New( isolate );
+    obj->Set( context,
+	      String::NewFromUtf8( isolate, "sql",
+				   NewStringType::kNormal ).ToLocalChecked(),
+	      String::NewFromUtf8( isolate, record->sql.c_str(),
+				   NewStringType::kNormal ).ToLocalChecked() ).FromJust();
+    Local<Array> params = Array::New( isolate, (int)record->params.size() );
+    for( size_t i = 0; i < record->params.size(); i++ ) {
+	params->Set( context, (uint32_t)i,
+		     String::NewFromUtf8( isolate, record->params[i].c_str(),
+					  NewStringType::kNormal ).ToLocalChecked() ).FromJust();
+    }
+    obj->Set( context,
+	      String::NewFromUtf8( isolate, "params",
+				   NewStringType::kNormal ).ToLocalChecked(),
+	      params ).FromJust();
+    obj->Set( context,
+	      String::NewFromUtf8( isolate, "paramRows",
+				   NewStringType::kNormal ).ToLocalChecked(),
+	      Number::New( isolate, record->param_rows ) ).FromJust();
+    obj->Set( context,
+	      String::NewFromUtf8( isolate, "duration",
+				   NewStringType::kNormal ).ToLocalChecked(),
+	      Number::New( isolate, record->total_ms ) ).FromJust();
+    Local<Object> timings = Object::New( isolate );
+    for( int i = 0; i < SLOW_NUM_PHASES; i++ ) {
+	timings->Set( context,
+		      String::NewFromUtf8( isolate,
+					   slowQueryRecord::phaseName( (slowQueryPhase)i ),
+					   NewStringType::kNormal ).ToLocalChecked(),
+		      Number::New( isolate, record->phases_ms[i] ) ).FromJust();
+    }
+    obj->Set( context,
+	      String::NewFromUtf8( isolate, "timings",
+				   NewStringType::kNormal ).ToLocalChecked(),
+	      timings ).FromJust();
+    obj->Set( context,
+	      String::NewFromUtf8( isolate, "rowsAffected",
+				   NewStringType::kNormal ).ToLocalChecked(),
+	      Integer::New( isolate, record->rows_affected ) ).FromJust();
+    obj->Set( context,
+	      String::NewFromUtf8( isolate, "rows",
+				   NewStringType::kNormal ).ToLocalChecked(),
+	      Number::New( isolate, (double)record->rows ) ).FromJust();
+    if( record->error.length() > 0 ) {
+	obj->Set( context,
+		  String::NewFromUtf8( isolate, "error",
+				       NewStringType::kNormal ).ToLocalChecked(),
+		  String::NewFromUtf8( isolate, record->error.c_str(),
+				       NewStringType::kNormal ).ToLocalChecked() ).FromJust();
+    }
+
+    Local<Function> sink = Local<Function>::New( isolate, baton->obj->slow_query_sink );
+    Local<Value> argv[1] = { obj };
+#if v012
+    TryCatch try_catch;
+#else
+    TryCatch try_catch( isolate );
+#endif
+    sink->Call( context, context->Global(), 1, argv ).IsEmpty();
+    if( try_catch.HasCaught() ) {
+	node::FatalException( isolate, try_catch );
+    }
+}
+
+void executeWork( uv_work_t *req )
+/********************************/
+{
+    executeBaton *baton = static_cast<executeBaton*>(req->data);
+    baton->timing.mark( TIMING_WORKER_STARTED );
+    scoped_lock lock( baton->obj->conn_mutex, baton->obj->conn_lock );
+    baton->timing.mark( TIMING_LOCKED );
+
+    if( baton->obj->conn == NULL ) {
 	baton->err = true;
-	getErrorMsg( baton->obj->conn, baton->error_msg );
+	getErrorMsg( JS_ERR_NOT_CONNECTED, baton->error_msg );
 	return;
     }
 
-    rc = fetchResultSet( sqlany_stmt, baton->rows_affected, baton->colNames,
-		    baton->execData[0], baton->col_types );
+    a_sqlany_stmt *sqlany_stmt = prepareStatement( baton );
+    if( sqlany_stmt != NULL ) {
+	executeStatement( baton, sqlany_stmt );
+    }
+    noteExecution( baton );
+}
 
-    if( !rc ) {
-	sqlcode = getError( baton->obj->conn, NULL, 0 );
-	if( (sqlcode != 0) && (sqlcode != 100) ) {
-	    baton->err = true;
-	    getErrorMsg( baton->obj->conn, baton->error_msg );
-	    return;
-	}
+// Records the end of a timed execution in the connection's timings.
+// Called on the main thread once the result has been delivered.
+static void finishTiming( executeBaton *baton )
+/*********************************************/
+{
+    if( baton->timing.enabled && baton->obj->timing_mode ) {
+	baton->timing.mark( TIMING_CALLBACK_DONE );
+	addTiming( baton->obj->timings, baton->timing );
     }
 }
 
@@ -178,9 +563,12 @@ void executeAfter( uv_work_t *req )
     Isolate *isolate = Isolate::GetCurrent();
     HandleScope scope( isolate );
     executeBaton *baton = static_cast<executeBaton*>( req->data );
+    baton->timing.mark( TIMING_AFTER_STARTED );
     Persistent<Value> ResultSet;
     fillResult( baton, ResultSet );
     ResultSet.Reset();
+    reportSlowQuery( baton );
+    finishTiming( baton );
 
     delete baton;
     delete req;
@@ -195,7 +583,6 @@ NODE_API_FUNC( StmtObject::exec )
     int num_args = args.Length();
     bool callback_required = false, bind_required = false;
     int cbfunc_arg = -1;
-    Local<Value> undef = Local<Value>::New( isolate, Undefined( isolate ) );
     
     if( num_args == 0 ) {
 	
@@ -217,20 +604,29 @@ NODE_API_FUNC( StmtObject::exec )
 	return;
     }
     
+    bool promise_required = !callback_required && obj != NULL &&
+			    obj->promise_mode;
+
     if( obj == NULL || obj->connection == NULL || obj->connection->conn == NULL ||
 	obj->sqlany_stmt == NULL ) {
 	std::string error_msg;
 	getErrorMsg( JS_ERR_INVALID_OBJECT, error_msg );
-	callBack( &( error_msg ), args[cbfunc_arg], undef, callback_required );
-	args.GetReturnValue().SetUndefined();
+	returnError( args, error_msg, cbfunc_arg, callback_required,
+		     promise_required );
 	return;
     }
     
     executeBaton *baton = new executeBaton();
     baton->obj = obj->connection;
+    baton->limits = obj->connection->result_limits;
+    baton->deadline = requestDeadline( obj->connection );
     baton->stmt_obj = obj;
     baton->free_stmt = false;
     baton->callback_required = callback_required;
+    baton->timing.enabled = obj->connection->timing_mode;
+    baton->record_statement = obj->connection->statement_stats_mode;
+    baton->slow_query_ms = obj->connection->slow_query_ms;
+    baton->slow_query_file = obj->connection->slow_query_file;
 
     if( bind_required ) {
         if( !getBindParameters( baton->execData, isolate, args[0], baton->params,
@@ -238,8 +634,8 @@ NODE_API_FUNC( StmtObject::exec )
 	    delete baton;
 	    std::string error_msg;
 	    getErrorMsg( JS_ERR_BINDING_PARAMETERS, error_msg );
-	    callBack( &( error_msg ), args[cbfunc_arg], undef, callback_required );
-	    args.GetReturnValue().SetUndefined();
+	    returnError( args, error_msg, cbfunc_arg, callback_required,
+			 promise_required );
 	    return;
 	}
 	if( baton->num_rows > 1 &&
@@ -248,35 +644,57 @@ NODE_API_FUNC( StmtObject::exec )
 	    delete baton;
 	    std::string error_msg;
 	    getErrorMsg( JS_ERR_NO_WIDE_STATEMENTS, error_msg );
-	    callBack( &( error_msg ), args[cbfunc_arg], undef, callback_required );
-	    args.GetReturnValue().SetUndefined();
+	    returnError( args, error_msg, cbfunc_arg, callback_required,
+			 promise_required );
 	    return;
 	}
+	chargeExternalMemory( baton->external_bytes,
+			      (int64_t)boundBytes( baton->params, baton->num_rows ) );
     } else {
 	baton->execData.push_back( new ExecuteData );
 	baton->num_rows = 1;
     }
 
+    diagStart( baton->diag, "exec", obj->sql, baton->params.size() );
+    baton->timing.enabled = baton->timing.enabled || baton->diag.active ||
+			    baton->record_statement || baton->slow_query_ms > 0;
+
     uv_work_t *req = new uv_work_t();
     req->data = baton;
     
-    if( callback_required ) {
-	Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
-	baton->callback.Reset( isolate, callback );
+    if( callback_required || promise_required ) {
+	Local<Value> promise;
+	if( callback_required ) {
+	    Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
+	    baton->callback.Reset( isolate, callback );
+	} else {
+	    promise = newPromise( isolate, baton->resolver );
+	}
 	
 	int status;
-	status = uv_queue_work( uv_default_loop(), req, executeWork,
-				(uv_after_work_cb)executeAfter );
+	baton->timing.mark( TIMING_ENQUEUED );
+	status = queueWork( req, executeWork, (uv_after_work_cb)executeAfter,
+			"sqlanywhere:exec",
+			chargeResultMemory );
 	assert(status == 0);
-	
-	args.GetReturnValue().SetUndefined();
+
+	if( promise_required ) {
+	    args.GetReturnValue().Set( promise );
+	} else {
+	    args.GetReturnValue().SetUndefined();
+	}
 	return;
     }
     
     Persistent<Value> ResultSet;
     
+    baton->timing.mark( TIMING_ENQUEUED );
     executeWork( req );
+    chargeResultMemory( req );
+    baton->timing.mark( TIMING_AFTER_STARTED );
     bool success = fillResult( baton, ResultSet );
+    reportSlowQuery( baton );
+    finishTiming( baton );
     delete baton;
     delete req;
     
@@ -288,80 +706,415 @@ NODE_API_FUNC( StmtObject::exec )
     ResultSet.Reset();
 }
 
-void getMoreResultsWork( uv_work_t *req )
-/***************************************/
-{
-    int rc = 0;
-    int sqlcode = 0;
+struct batchBaton {
+    Persistent<Function>		callback;
+    Persistent<Promise::Resolver>	resolver;
+    bool 				err;
+    std::string 			error_msg;
+    bool 				callback_required;
 
-    executeBaton *baton = static_cast<executeBaton*>(req->data);
-    scoped_lock lock( baton->obj->conn_mutex );
+    Connection 				*obj;
+    StmtObject				*stmt_obj;
 
-    if( baton->obj->conn == NULL ) {
-	baton->err = true;
-	getErrorMsg( JS_ERR_NOT_CONNECTED, baton->error_msg );
-	return;
+    // One entry per execution, each holding its binds and its result
+    std::vector<executeBaton *>		executions;
+    bool				transaction;
+    diagEvent				diag;
+
+    batchBaton() {
+	err = false;
+	callback_required = false;
+	obj = NULL;
+	stmt_obj = NULL;
+	transaction = false;
     }
 
-    a_sqlany_stmt *stmt = baton->stmt_obj->sqlany_stmt;
+    ~batchBaton() {
+	obj = NULL;
+	stmt_obj = NULL;
+	callback.Reset();
+	resolver.Reset();
+	CLEAN_PTRS( executions );
+    }
+};
 
-    if( stmt == NULL ) {
-	baton->err = true;
-	getErrorMsg( JS_ERR_INVALID_OBJECT, baton->error_msg );
-	return;
+// Takes the same timestamp for every execution of the batch
+static void markBatch( batchBaton *baton, timingMark which )
+/**********************************************************/
+{
+    for( size_t i = 0; i < baton->executions.size(); i++ ) {
+	baton->executions[i]->timing.mark( which );
     }
-    int retval = ( api.sqlany_get_next_result( stmt ) != 0 );
-    if( !retval ) {
-	char buffer[SACAPI_ERROR_SIZE];
-	int rc;
-	rc = api.sqlany_error( baton->obj->conn, buffer, sizeof(buffer) );
-	if( rc != 105 ) {
-	    // rc == 105 means "procedure has completed" - i.e. no more result
-	    // sets. Just return null, not an error
-	    baton->err = true;
-	    getErrorMsg( baton->obj->conn, baton->error_msg );
+}
+
+// The same as chargeResultMemory, for each execution of a batch
+static void chargeBatchMemory( uv_work_t *req )
+/*********************************************/
+{
+    batchBaton *baton = static_cast<batchBaton*>(req->data);
+    for( size_t i = 0; i < baton->executions.size(); i++ ) {
+	executeBaton *execution = baton->executions[i];
+	if( execution->execData.size() > 0 ) {
+	    chargeExternalMemory( execution->external_bytes,
+				  (int64_t)execution->execData[0]->dataBytes() );
 	}
-	return;
     }
+}
 
-    baton->execData[0]->clear();
-    rc = fetchResultSet( stmt, baton->rows_affected, baton->colNames,
-		    baton->execData[0], baton->col_types );
+// Publishes the start of a batch on the diagnostics channels, counting the
+// values bound by all of its executions
+static void diagBatchStart( batchBaton *baton, const char *kind,
+			    const std::string &sql, size_t num_statements )
+/**************************************************************/
+{
+    size_t num_params = 0;
+    for( size_t i = 0; i < baton->executions.size(); i++ ) {
+	num_params += baton->executions[i]->params.size();
+    }
+    baton->diag.num_statements = num_statements;
+    diagStart( baton->diag, kind, sql, num_params );
+}
 
-    if( !rc ) {
-	sqlcode = getError( baton->obj->conn, NULL, 0 );
-	if( (sqlcode != 0 ) && (sqlcode != 100) ) {
-	    baton->err = true;
-	    getErrorMsg( baton->obj->conn, baton->error_msg );
-	    return;
+// Reports the slow queries of the batch and records the timings of the
+// executions that ran
+static void finishBatch( batchBaton *baton )
+/******************************************/
+{
+    for( size_t i = 0; i < baton->executions.size(); i++ ) {
+	executeBaton *execution = baton->executions[i];
+	reportSlowQuery( execution );
+	if( execution->timing.marks[TIMING_EXECUTED] != 0 ) {
+	    finishTiming( execution );
 	}
     }
 }
 
-void getMoreResultsAfter( uv_work_t *req )
-/****************************************/
+static bool fillManyResults( batchBaton *baton, Persistent<Value> &Results )
+/*****************************************************************************/
 {
     Isolate *isolate = Isolate::GetCurrent();
     HandleScope scope( isolate );
-    executeBaton *baton = static_cast<executeBaton*>( req->data );
-    Persistent<Value> ResultSet;
-    fillResult( baton, ResultSet );
-    ResultSet.Reset();
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<Value> undef = Local<Value>::New( isolate, Undefined( isolate ) );
 
-    delete baton;
-    delete req;
+    markBatch( baton, TIMING_AFTER_STARTED );
+    if( baton->err ) {
+	diagEnd( baton->diag, &( baton->error_msg ) );
+	callBack( &( baton->error_msg ), baton->callback, baton->resolver, undef,
+		  baton->callback_required );
+	finishBatch( baton );
+	return false;
+    }
+
+    Local<Array> results = Array::New( isolate, (int)baton->executions.size() );
+    for( size_t i = 0; i < baton->executions.size(); i++ ) {
+	executeBaton *execution = baton->executions[i];
+	Persistent<Value> ResultSet;
+	if( !getResultSet( ResultSet, execution->rows_affected,
+			   execution->colNames, execution->execData[0],
+			   execution->col_types ) ) {
+	    getErrorMsg( JS_ERR_RESULTSET, baton->error_msg );
+	    diagEnd( baton->diag, &( baton->error_msg ) );
+	    callBack( &( baton->error_msg ), baton->callback, baton->resolver,
+		      undef, baton->callback_required );
+	    finishBatch( baton );
+	    return false;
+	}
+	execution->timing.mark( TIMING_MATERIALIZED );
+	results->Set( context, (uint32_t)i,
+		      Local<Value>::New( isolate, ResultSet ) ).FromJust();
+	ResultSet.Reset();
+    }
+    Results.Reset( isolate, results );
+
+    diagEnd( baton->diag, NULL );
+    if( baton->callback_required || !baton->resolver.IsEmpty() ) {
+	callBack( NULL, baton->callback, baton->resolver, Results,
+		  baton->callback_required );
+    }
+    finishBatch( baton );
+    return true;
 }
 
-NODE_API_FUNC( StmtObject::getMoreResults )
-/*****************************************/
+static void execManyWork( uv_work_t *req )
+/****************************************/
 {
-    Isolate *isolate = args.GetIsolate();
-    HandleScope scope( isolate );
+    batchBaton *baton = static_cast<batchBaton*>(req->data);
+    markBatch( baton, TIMING_WORKER_STARTED );
+    scoped_lock lock( baton->obj->conn_mutex, baton->obj->conn_lock );
+    markBatch( baton, TIMING_LOCKED );
+
+    if( baton->obj->conn == NULL ) {
+	baton->err = true;
+	getErrorMsg( JS_ERR_NOT_CONNECTED, baton->error_msg );
+	return;
+    }
+
+    a_sqlany_stmt *sqlany_stmt = baton->stmt_obj->sqlany_stmt;
+    if( sqlany_stmt == NULL ) {
+	baton->err = true;
+	getErrorMsg( JS_ERR_INVALID_OBJECT, baton->error_msg );
+	return;
+    }
+
+    // Run all executions back to back; stop at the first failure
+    for( size_t i = 0; i < baton->executions.size(); i++ ) {
+	executeBaton *execution = baton->executions[i];
+	if( i > 0 ) {
+	    // The request waited for a worker and the lock once, before its
+	    // first execution; later ones are timed from their turn
+	    execution->timing.mark( TIMING_ENQUEUED );
+	    execution->timing.mark( TIMING_WORKER_STARTED );
+	    execution->timing.mark( TIMING_LOCKED );
+	}
+	execution->timing.mark( TIMING_PREPARED );
+	bool executed = executeStatement( execution, sqlany_stmt );
+	noteExecution( execution );
+	if( !executed ) {
+	    baton->err = true;
+	    baton->error_msg = execution->error_msg;
+	    return;
+	}
+    }
+}
+
+static void execManyAfter( uv_work_t *req )
+/*****************************************/
+{
+    Isolate *isolate = Isolate::GetCurrent();
+    HandleScope scope( isolate );
+    batchBaton *baton = static_cast<batchBaton*>( req->data );
+    Persistent<Value> Results;
+    fillManyResults( baton, Results );
+    Results.Reset();
+
+    delete baton;
+    delete req;
+}
+
+NODE_API_FUNC( StmtObject::execMany )
+/***********************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    Local<Context> context = isolate->GetCurrentContext();
+    HandleScope scope( isolate );
+    StmtObject *obj = ObjectWrap::Unwrap<StmtObject>( args.This() );
+    int num_args = args.Length();
+    bool callback_required = false;
+    int cbfunc_arg = -1;
+
+    if( num_args == 1 && args[0]->IsArray() ) {
+
+    } else if( num_args == 2 && args[0]->IsArray() && args[1]->IsFunction() ) {
+	callback_required = true;
+	cbfunc_arg = 1;
+
+    } else {
+	throwError( JS_ERR_INVALID_ARGUMENTS );
+	args.GetReturnValue().SetUndefined();
+	return;
+    }
+
+    bool promise_required = !callback_required && obj != NULL &&
+			    obj->promise_mode;
+
+    if( obj == NULL || obj->connection == NULL || obj->connection->conn == NULL ||
+	obj->sqlany_stmt == NULL ) {
+	std::string error_msg;
+	getErrorMsg( JS_ERR_INVALID_OBJECT, error_msg );
+	returnError( args, error_msg, cbfunc_arg, callback_required,
+		     promise_required );
+	return;
+    }
+
+    batchBaton *baton = new batchBaton();
+    baton->obj = obj->connection;
+    baton->stmt_obj = obj;
+    baton->callback_required = callback_required;
+
+    // One deadline for the request, checked before its first execution; once
+    // it has started, stopping partway would waste the work already done
+    uint64_t deadline = requestDeadline( obj->connection );
+    Local<Array> param_sets = Local<Array>::Cast( args[0] );
+    for( uint32_t i = 0; i < param_sets->Length(); i++ ) {
+	Local<Value> param_set = param_sets->Get( context, i ).ToLocalChecked();
+	executeBaton *execution = new executeBaton();
+	execution->obj = obj->connection;
+	execution->limits = obj->connection->result_limits;
+	execution->deadline = i == 0 ? deadline : 0;
+	execution->record_statement = obj->connection->statement_stats_mode;
+	execution->slow_query_ms = obj->connection->slow_query_ms;
+	execution->slow_query_file = obj->connection->slow_query_file;
+	execution->timing.enabled = obj->connection->timing_mode ||
+				    execution->record_statement ||
+				    execution->slow_query_ms > 0;
+	execution->stmt_obj = obj;
+	execution->free_stmt = false;
+	baton->executions.push_back( execution );
+
+	if( !param_set->IsArray() ||
+	    !getBindParameters( execution->execData, isolate, param_set,
+				execution->params, execution->num_rows ) ) {
+	    delete baton;
+	    std::string error_msg;
+	    getErrorMsg( JS_ERR_BINDING_PARAMETERS, error_msg );
+	    returnError( args, error_msg, cbfunc_arg, callback_required,
+			 promise_required );
+	    return;
+	}
+	if( execution->num_rows > 1 &&
+	    baton->obj->max_api_ver < SQLANY_API_VERSION_4 ) {
+	    // can't support wide inserts with older dbcapi
+	    delete baton;
+	    std::string error_msg;
+	    getErrorMsg( JS_ERR_NO_WIDE_STATEMENTS, error_msg );
+	    returnError( args, error_msg, cbfunc_arg, callback_required,
+			 promise_required );
+	    return;
+	}
+	chargeExternalMemory( execution->external_bytes,
+			      (int64_t)boundBytes( execution->params, execution->num_rows ) );
+    }
+
+    diagBatchStart( baton, "execMany", obj->sql, 0 );
+
+    uv_work_t *req = new uv_work_t();
+    req->data = baton;
+
+    if( callback_required || promise_required ) {
+	Local<Value> promise;
+	if( callback_required ) {
+	    Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
+	    baton->callback.Reset( isolate, callback );
+	} else {
+	    promise = newPromise( isolate, baton->resolver );
+	}
+
+	int status;
+	markBatch( baton, TIMING_ENQUEUED );
+	status = queueWork( req, execManyWork, (uv_after_work_cb)execManyAfter,
+			"sqlanywhere:execMany",
+			chargeBatchMemory );
+	assert(status == 0);
+
+	if( promise_required ) {
+	    args.GetReturnValue().Set( promise );
+	} else {
+	    args.GetReturnValue().SetUndefined();
+	}
+	return;
+    }
+
+    Persistent<Value> Results;
+
+    markBatch( baton, TIMING_ENQUEUED );
+    execManyWork( req );
+    chargeBatchMemory( req );
+    bool success = fillManyResults( baton, Results );
+    delete baton;
+    delete req;
+
+    if( !success ) {
+	args.GetReturnValue().SetUndefined();
+	return;
+    }
+    args.GetReturnValue().Set( Local<Value>::New( isolate, Results ) );
+    Results.Reset();
+}
+
+// Advances the statement to its next result set and fetches it into the
+// baton. Returns false when the statement has no more result sets, or on
+// error with baton->err set. The caller must hold conn_mutex.
+static bool fetchNextResult( executeBaton *baton, a_sqlany_stmt *sqlany_stmt )
+/****************************************************************************/
+{
+    int rc = 0;
+    int sqlcode = 0;
+
+    sacapi_bool next_result;
+    {
+	traceSpan span( "sqlany_get_next_result" );
+	next_result = api.sqlany_get_next_result( sqlany_stmt );
+    }
+    if( !next_result ) {
+	sqlcode = getError( baton->obj->conn, NULL, 0 );
+	if( sqlcode != 105 ) {
+	    // sqlcode 105 means "procedure has completed" - i.e. no more result
+	    // sets. Just return null, not an error
+	    baton->err = true;
+	    getErrorMsg( baton->obj->conn, baton->error_msg );
+	}
+	return false;
+    }
+
+    baton->execData[0]->clear();
+    rc = fetchResultSet( sqlany_stmt, baton->rows_affected, baton->colNames,
+		    baton->execData[0], baton->col_types, &baton->obj->stats,
+		    &baton->limits );
+
+    if( baton->limits.exceeded ) {
+	resultTooLarge( baton, sqlany_stmt );
+	return false;
+    }
+    if( !rc ) {
+	sqlcode = getError( baton->obj->conn, NULL, 0 );
+	if( (sqlcode != 0 ) && (sqlcode != 100) ) {
+	    baton->err = true;
+	    getErrorMsg( baton->obj->conn, baton->error_msg );
+	    return false;
+	}
+    }
+    return true;
+}
+
+void getMoreResultsWork( uv_work_t *req )
+/***************************************/
+{
+    executeBaton *baton = static_cast<executeBaton*>(req->data);
+    scoped_lock lock( baton->obj->conn_mutex, baton->obj->conn_lock );
+
+    if( baton->obj->conn == NULL ) {
+	baton->err = true;
+	getErrorMsg( JS_ERR_NOT_CONNECTED, baton->error_msg );
+	return;
+    }
+
+    a_sqlany_stmt *stmt = baton->stmt_obj->sqlany_stmt;
+
+    if( stmt == NULL ) {
+	baton->err = true;
+	getErrorMsg( JS_ERR_INVALID_OBJECT, baton->error_msg );
+	return;
+    }
+    if( requestExpired( baton ) ) {
+	return;
+    }
+    fetchNextResult( baton, stmt );
+}
+
+void getMoreResultsAfter( uv_work_t *req )
+/****************************************/
+{
+    Isolate *isolate = Isolate::GetCurrent();
+    HandleScope scope( isolate );
+    executeBaton *baton = static_cast<executeBaton*>( req->data );
+    Persistent<Value> ResultSet;
+    fillResult( baton, ResultSet );
+    ResultSet.Reset();
+
+    delete baton;
+    delete req;
+}
+
+NODE_API_FUNC( StmtObject::getMoreResults )
+/*****************************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    HandleScope scope( isolate );
     StmtObject *obj = ObjectWrap::Unwrap<StmtObject>( args.This() );
     int num_args = args.Length();
     bool callback_required = false;
     int cbfunc_arg = -1;
-    Local<Value> undef = Local<Value>::New( isolate, Undefined( isolate ) );
     
     if( num_args == 0 ) {
 	
@@ -375,17 +1128,22 @@ NODE_API_FUNC( StmtObject::getMoreResults )
 	return;
     }
     
+    bool promise_required = !callback_required && obj != NULL &&
+			    obj->promise_mode;
+
     if( obj == NULL || obj->connection == NULL || obj->connection->conn == NULL ||
 	obj->sqlany_stmt == NULL ) {
 	std::string error_msg;
 	getErrorMsg( JS_ERR_INVALID_OBJECT, error_msg );
-	callBack( &( error_msg ), args[cbfunc_arg], undef, callback_required );
-	args.GetReturnValue().SetUndefined();
+	returnError( args, error_msg, cbfunc_arg, callback_required,
+		     promise_required );
 	return;
     }
 
     executeBaton *baton = new executeBaton;
     baton->obj = obj->connection;
+    baton->limits = obj->connection->result_limits;
+    baton->deadline = requestDeadline( obj->connection );
     baton->stmt_obj = obj;
     baton->free_stmt = false;
     baton->callback_required = callback_required;
@@ -396,22 +1154,33 @@ NODE_API_FUNC( StmtObject::getMoreResults )
     uv_work_t *req = new uv_work_t();
     req->data = baton;
     
-    if( callback_required ) {
-	Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
-	baton->callback.Reset( isolate, callback );
+    if( callback_required || promise_required ) {
+	Local<Value> promise;
+	if( callback_required ) {
+	    Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
+	    baton->callback.Reset( isolate, callback );
+	} else {
+	    promise = newPromise( isolate, baton->resolver );
+	}
 	
 	int status;
-	status = uv_queue_work( uv_default_loop(), req, getMoreResultsWork,
-				(uv_after_work_cb)getMoreResultsAfter );
+	status = queueWork( req, getMoreResultsWork, (uv_after_work_cb)getMoreResultsAfter,
+			"sqlanywhere:getMoreResults",
+			chargeResultMemory );
 	assert(status == 0);
-	
-	args.GetReturnValue().SetUndefined();
+
+	if( promise_required ) {
+	    args.GetReturnValue().Set( promise );
+	} else {
+	    args.GetReturnValue().SetUndefined();
+	}
 	return;
     }
     
     Persistent<Value> ResultSet;
     
     getMoreResultsWork( req );
+    chargeResultMemory( req );
     bool success = fillResult( baton, ResultSet );
     delete baton;
     delete req;
@@ -424,13 +1193,212 @@ NODE_API_FUNC( StmtObject::getMoreResults )
     ResultSet.Reset();
 }
 
+// Executes the statement of the first execution in the baton and fetches
+// every result set it returns, appending one execution per further result
+// set to the baton.
+static void execAllWork( uv_work_t *req )
+/***************************************/
+{
+    batchBaton *baton = static_cast<batchBaton*>(req->data);
+    markBatch( baton, TIMING_WORKER_STARTED );
+    scoped_lock lock( baton->obj->conn_mutex, baton->obj->conn_lock );
+    markBatch( baton, TIMING_LOCKED );
+
+    if( baton->obj->conn == NULL ) {
+	baton->err = true;
+	getErrorMsg( JS_ERR_NOT_CONNECTED, baton->error_msg );
+	return;
+    }
+
+    executeBaton *first = baton->executions[0];
+    a_sqlany_stmt *sqlany_stmt = prepareStatement( first );
+    if( sqlany_stmt == NULL || !executeStatement( first, sqlany_stmt ) ) {
+	baton->err = true;
+	baton->error_msg = first->error_msg;
+	noteExecution( first );
+	return;
+    }
+
+    // A batch or procedure may return result sets after statements that
+    // return none, so keep asking until the server reports completion
+    while( true ) {
+	executeBaton *next = new executeBaton();
+	next->obj = baton->obj;
+	// Once the request has started, its later result sets are fetched
+	// whatever the deadline
+	next->limits = first->limits;
+	next->execData.push_back( new ExecuteData );
+	next->num_rows = 1;
+
+	if( !fetchNextResult( next, sqlany_stmt ) ) {
+	    if( next->err ) {
+		baton->err = true;
+		baton->error_msg = next->error_msg;
+	    }
+	    delete next;
+	    // the fetch phase of the request covers every result set
+	    first->timing.mark( TIMING_FETCHED );
+	    noteExecution( first );
+	    return;
+	}
+	baton->executions.push_back( next );
+    }
+}
+
+static void execAllAfter( uv_work_t *req )
+/****************************************/
+{
+    Isolate *isolate = Isolate::GetCurrent();
+    HandleScope scope( isolate );
+    batchBaton *baton = static_cast<batchBaton*>( req->data );
+    Persistent<Value> Results;
+    fillManyResults( baton, Results );
+    Results.Reset();
+
+    delete baton;
+    delete req;
+}
+
+NODE_API_FUNC( StmtObject::execAll )
+/**********************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    HandleScope scope( isolate );
+    StmtObject *obj = ObjectWrap::Unwrap<StmtObject>( args.This() );
+    int num_args = args.Length();
+    bool callback_required = false, bind_required = false;
+    int cbfunc_arg = -1;
+
+    if( num_args == 0 ) {
+
+    } else if( num_args == 1 && args[0]->IsArray() ) {
+	bind_required = true;
+
+    } else if( num_args == 1 && args[0]->IsFunction() ) {
+	callback_required = true;
+	cbfunc_arg = 0;
+
+    } else if( num_args == 2 && args[0]->IsArray() && args[1]->IsFunction() ) {
+	callback_required = true;
+	bind_required = true;
+	cbfunc_arg = 1;
+
+    } else {
+	throwError( JS_ERR_INVALID_ARGUMENTS );
+	args.GetReturnValue().SetUndefined();
+	return;
+    }
+
+    bool promise_required = !callback_required && obj != NULL &&
+			    obj->promise_mode;
+
+    if( obj == NULL || obj->connection == NULL || obj->connection->conn == NULL ||
+	obj->sqlany_stmt == NULL ) {
+	std::string error_msg;
+	getErrorMsg( JS_ERR_INVALID_OBJECT, error_msg );
+	returnError( args, error_msg, cbfunc_arg, callback_required,
+		     promise_required );
+	return;
+    }
+
+    batchBaton *baton = new batchBaton();
+    baton->obj = obj->connection;
+    baton->stmt_obj = obj;
+    baton->callback_required = callback_required;
+
+    executeBaton *execution = new executeBaton();
+    execution->obj = obj->connection;
+    execution->limits = obj->connection->result_limits;
+    execution->deadline = requestDeadline( obj->connection );
+    execution->record_statement = obj->connection->statement_stats_mode;
+    execution->slow_query_ms = obj->connection->slow_query_ms;
+    execution->slow_query_file = obj->connection->slow_query_file;
+    execution->timing.enabled = obj->connection->timing_mode ||
+				execution->record_statement ||
+				execution->slow_query_ms > 0;
+    execution->stmt_obj = obj;
+    execution->free_stmt = false;
+    baton->executions.push_back( execution );
+
+    if( bind_required ) {
+	if( !getBindParameters( execution->execData, isolate, args[0],
+				execution->params, execution->num_rows ) ) {
+	    delete baton;
+	    std::string error_msg;
+	    getErrorMsg( JS_ERR_BINDING_PARAMETERS, error_msg );
+	    returnError( args, error_msg, cbfunc_arg, callback_required,
+			 promise_required );
+	    return;
+	}
+	if( execution->num_rows > 1 &&
+	    baton->obj->max_api_ver < SQLANY_API_VERSION_4 ) {
+	    // can't support wide inserts with older dbcapi
+	    delete baton;
+	    std::string error_msg;
+	    getErrorMsg( JS_ERR_NO_WIDE_STATEMENTS, error_msg );
+	    returnError( args, error_msg, cbfunc_arg, callback_required,
+			 promise_required );
+	    return;
+	}
+	chargeExternalMemory( execution->external_bytes,
+			      (int64_t)boundBytes( execution->params, execution->num_rows ) );
+    } else {
+	execution->execData.push_back( new ExecuteData );
+	execution->num_rows = 1;
+    }
+
+    diagBatchStart( baton, "execAll", obj->sql, 0 );
+
+    uv_work_t *req = new uv_work_t();
+    req->data = baton;
+
+    if( callback_required || promise_required ) {
+	Local<Value> promise;
+	if( callback_required ) {
+	    Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
+	    baton->callback.Reset( isolate, callback );
+	} else {
+	    promise = newPromise( isolate, baton->resolver );
+	}
+
+	int status;
+	markBatch( baton, TIMING_ENQUEUED );
+	status = queueWork( req, execAllWork, (uv_after_work_cb)execAllAfter,
+			"sqlanywhere:execAll",
+			chargeBatchMemory );
+	assert(status == 0);
+
+	if( promise_required ) {
+	    args.GetReturnValue().Set( promise );
+	} else {
+	    args.GetReturnValue().SetUndefined();
+	}
+	return;
+    }
+
+    Persistent<Value> Results;
+
+    markBatch( baton, TIMING_ENQUEUED );
+    execAllWork( req );
+    chargeBatchMemory( req );
+    bool success = fillManyResults( baton, Results );
+    delete baton;
+    delete req;
+
+    if( !success ) {
+	args.GetReturnValue().SetUndefined();
+	return;
+    }
+    args.GetReturnValue().Set( Local<Value>::New( isolate, Results ) );
+    Results.Reset();
+}
+
 NODE_API_FUNC( Connection::exec )
 /*******************************/
 {
     Isolate *isolate = args.GetIsolate();
     Local<Context> context = isolate->GetCurrentContext();
     HandleScope scope( isolate );
-    Local<Value> undef = Local<Value>::New( isolate, Undefined( isolate ) );
 
     int num_args = args.Length();
     bool callback_required = false, bind_required = false;
@@ -462,12 +1430,14 @@ NODE_API_FUNC( Connection::exec )
     }
 
     Connection *obj = ObjectWrap::Unwrap<Connection>( args.This() );
+    bool promise_required = !callback_required && obj != NULL &&
+			    obj->promise_mode;
     
     if( obj == NULL || obj->conn == NULL ) {
 	std::string error_msg;
 	getErrorMsg( JS_ERR_INVALID_OBJECT, error_msg );
-	callBack( &( error_msg ), args[cbfunc_arg], undef, callback_required );
-	args.GetReturnValue().SetUndefined();
+	returnError( args, error_msg, cbfunc_arg, callback_required,
+		     promise_required );
 	return;
     }
     
@@ -479,7 +1449,13 @@ NODE_API_FUNC( Connection::exec )
 
     executeBaton *baton = new executeBaton();
     baton->obj = obj;
+    baton->limits = obj->result_limits;
+    baton->deadline = requestDeadline( obj );
     baton->callback_required = callback_required;
+    baton->timing.enabled = obj->timing_mode;
+    baton->record_statement = obj->statement_stats_mode;
+    baton->slow_query_ms = obj->slow_query_ms;
+    baton->slow_query_file = obj->slow_query_file;
     baton->free_stmt = true;
     baton->stmt_obj = NULL;
     baton->stmt = std::string(*param0);
@@ -490,8 +1466,8 @@ NODE_API_FUNC( Connection::exec )
 	    delete baton;
 	    std::string error_msg;
 	    getErrorMsg( JS_ERR_BINDING_PARAMETERS, error_msg );
-	    callBack( &( error_msg ), args[cbfunc_arg], undef, callback_required );
-	    args.GetReturnValue().SetUndefined();
+	    returnError( args, error_msg, cbfunc_arg, callback_required,
+			 promise_required );
 	    return;
 	}
 	if( baton->num_rows > 1 &&
@@ -500,49 +1476,452 @@ NODE_API_FUNC( Connection::exec )
 	    delete baton;
 	    std::string error_msg;
 	    getErrorMsg( JS_ERR_NO_WIDE_STATEMENTS, error_msg );
-	    callBack( &( error_msg ), args[cbfunc_arg], undef, callback_required );
-	    args.GetReturnValue().SetUndefined();
+	    returnError( args, error_msg, cbfunc_arg, callback_required,
+			 promise_required );
 	    return;
 	}
+	chargeExternalMemory( baton->external_bytes,
+			      (int64_t)boundBytes( baton->params, baton->num_rows ) );
     } else {
 	baton->execData.push_back( new ExecuteData );
 	baton->num_rows = 1;
     }
     
+    diagStart( baton->diag, "exec", baton->stmt, baton->params.size() );
+    baton->timing.enabled = baton->timing.enabled || baton->diag.active ||
+			    baton->record_statement || baton->slow_query_ms > 0;
+
     uv_work_t *req = new uv_work_t();
     req->data = baton;
     
-    if( callback_required ) {
-	Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
-	baton->callback.Reset( isolate, callback );
+    if( callback_required || promise_required ) {
+	Local<Value> promise;
+	if( callback_required ) {
+	    Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
+	    baton->callback.Reset( isolate, callback );
+	} else {
+	    promise = newPromise( isolate, baton->resolver );
+	}
 	int status;
-	status = uv_queue_work( uv_default_loop(), req, executeWork,
-				(uv_after_work_cb)executeAfter );
+	baton->timing.mark( TIMING_ENQUEUED );
+	status = queueWork( req, executeWork, (uv_after_work_cb)executeAfter,
+			"sqlanywhere:exec",
+			chargeResultMemory );
 	assert(status == 0);
-	
+
+	if( promise_required ) {
+	    args.GetReturnValue().Set( promise );
+	} else {
+	    args.GetReturnValue().SetUndefined();
+	}
+	return;
+    }
+    
+    Persistent<Value> ResultSet;
+
+    baton->timing.mark( TIMING_ENQUEUED );
+    executeWork( req );
+    chargeResultMemory( req );
+    baton->timing.mark( TIMING_AFTER_STARTED );
+    bool success = fillResult( baton, ResultSet );
+    reportSlowQuery( baton );
+    finishTiming( baton );
+
+    delete baton;
+    delete req;
+    
+    if( !success ) {
+	args.GetReturnValue().SetUndefined();
+	return;
+    }
+    Local<Value> local_result = Local<Value>::New( isolate, ResultSet );
+    args.GetReturnValue().Set( local_result );
+    ResultSet.Reset();
+}
+
+static void execBatchWork( uv_work_t *req )
+/*****************************************/
+{
+    batchBaton *baton = static_cast<batchBaton*>(req->data);
+    markBatch( baton, TIMING_WORKER_STARTED );
+    scoped_lock lock( baton->obj->conn_mutex, baton->obj->conn_lock );
+    markBatch( baton, TIMING_LOCKED );
+
+    if( baton->obj->conn == NULL ) {
+	baton->err = true;
+	getErrorMsg( JS_ERR_NOT_CONNECTED, baton->error_msg );
+	return;
+    }
+
+    // Run the statements in order; stop at the first failure
+    for( size_t i = 0; i < baton->executions.size(); i++ ) {
+	executeBaton *execution = baton->executions[i];
+	if( i > 0 ) {
+	    // The request waited for a worker and the lock once, before its
+	    // first execution; later ones are timed from their turn
+	    execution->timing.mark( TIMING_ENQUEUED );
+	    execution->timing.mark( TIMING_WORKER_STARTED );
+	    execution->timing.mark( TIMING_LOCKED );
+	}
+	a_sqlany_stmt *sqlany_stmt = prepareStatement( execution );
+	bool executed = sqlany_stmt != NULL &&
+			executeStatement( execution, sqlany_stmt );
+	noteExecution( execution );
+	if( !executed ) {
+	    // Undo the statements that succeeded, so that they are not left
+	    // pending for the next request on the connection to commit
+	    baton->err = true;
+	    baton->error_msg = execution->error_msg;
+	    api.sqlany_rollback( baton->obj->conn );
+	    return;
+	}
+    }
+
+    if( baton->transaction && !api.sqlany_commit( baton->obj->conn ) ) {
+	baton->err = true;
+	getErrorMsg( baton->obj->conn, baton->error_msg );
+	api.sqlany_rollback( baton->obj->conn );
+    }
+}
+
+static void execBatchAfter( uv_work_t *req )
+/******************************************/
+{
+    Isolate *isolate = Isolate::GetCurrent();
+    HandleScope scope( isolate );
+    batchBaton *baton = static_cast<batchBaton*>( req->data );
+    Persistent<Value> Results;
+    fillManyResults( baton, Results );
+    Results.Reset();
+
+    delete baton;
+    delete req;
+}
+
+NODE_API_FUNC( Connection::execBatch )
+/************************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    Local<Context> context = isolate->GetCurrentContext();
+    HandleScope scope( isolate );
+    int num_args = args.Length();
+    bool callback_required = false;
+    int cbfunc_arg = -1;
+    int options_arg = -1;
+
+    if( num_args == 1 && args[0]->IsArray() ) {
+
+    } else if( num_args == 2 && args[0]->IsArray() && args[1]->IsFunction() ) {
+	callback_required = true;
+	cbfunc_arg = 1;
+
+    } else if( num_args == 2 && args[0]->IsArray() && args[1]->IsObject() ) {
+	options_arg = 1;
+
+    } else if( num_args == 3 && args[0]->IsArray() && args[1]->IsObject() &&
+	       args[2]->IsFunction() ) {
+	callback_required = true;
+	cbfunc_arg = 2;
+	options_arg = 1;
+
+    } else {
+	throwError( JS_ERR_INVALID_ARGUMENTS );
 	args.GetReturnValue().SetUndefined();
 	return;
     }
-    
-    Persistent<Value> ResultSet;
 
-    executeWork( req );
-    bool success = fillResult( baton, ResultSet );
+    Connection *obj = ObjectWrap::Unwrap<Connection>( args.This() );
+    bool promise_required = !callback_required && obj != NULL &&
+			    obj->promise_mode;
+
+    if( obj == NULL || obj->conn == NULL ) {
+	std::string error_msg;
+	getErrorMsg( JS_ERR_INVALID_OBJECT, error_msg );
+	returnError( args, error_msg, cbfunc_arg, callback_required,
+		     promise_required );
+	return;
+    }
+
+    batchBaton *baton = new batchBaton();
+    baton->obj = obj;
+    baton->callback_required = callback_required;
+
+    if( options_arg >= 0 ) {
+	Local<Object> options = args[options_arg]->ToObject( context ).ToLocalChecked();
+	getBoolOption( isolate, options, "transaction", baton->transaction );
+    }
+
+    Local<String> sql_key =
+	String::NewFromUtf8( isolate, "sql", NewStringType::kNormal ).ToLocalChecked();
+    Local<String> params_key =
+	String::NewFromUtf8( isolate, "params", NewStringType::kNormal ).ToLocalChecked();
+    // As for execMany, only the first statement checks the deadline
+    uint64_t deadline = requestDeadline( obj );
+    Local<Array> statements = Local<Array>::Cast( args[0] );
+    for( uint32_t i = 0; i < statements->Length(); i++ ) {
+	Local<Value> entry = statements->Get( context, i ).ToLocalChecked();
+	Local<Value> sql;
+	Local<Value> params;
+	if( entry->IsObject() ) {
+	    Local<Object> entry_obj = entry->ToObject( context ).ToLocalChecked();
+	    sql = entry_obj->Get( context, sql_key ).ToLocalChecked();
+	    params = entry_obj->Get( context, params_key ).ToLocalChecked();
+	}
+	if( sql.IsEmpty() || !sql->IsString() ||
+	    !( params->IsUndefined() || params->IsArray() ) ) {
+	    delete baton;
+	    std::string error_msg;
+	    getErrorMsg( JS_ERR_INVALID_ARGUMENTS, error_msg );
+	    returnError( args, error_msg, cbfunc_arg, callback_required,
+			 promise_required );
+	    return;
+	}
+
+#if NODE_MAJOR_VERSION >= 12
+	String::Utf8Value sql_utf8( isolate, sql );
+#else
+	String::Utf8Value sql_utf8( sql );
+#endif
+	executeBaton *execution = new executeBaton();
+	execution->obj = obj;
+	execution->limits = obj->result_limits;
+	execution->deadline = i == 0 ? deadline : 0;
+	execution->record_statement = obj->statement_stats_mode;
+	execution->slow_query_ms = obj->slow_query_ms;
+	execution->slow_query_file = obj->slow_query_file;
+	execution->timing.enabled = obj->timing_mode ||
+				    execution->record_statement ||
+				    execution->slow_query_ms > 0;
+	execution->free_stmt = true;
+	execution->stmt_obj = NULL;
+	execution->stmt = std::string( *sql_utf8 );
+	baton->executions.push_back( execution );
+
+	if( params->IsArray() ) {
+	    if( !getBindParameters( execution->execData, isolate, params,
+				    execution->params, execution->num_rows ) ) {
+		delete baton;
+		std::string error_msg;
+		getErrorMsg( JS_ERR_BINDING_PARAMETERS, error_msg );
+		returnError( args, error_msg, cbfunc_arg, callback_required,
+			     promise_required );
+		return;
+	    }
+	    if( execution->num_rows > 1 &&
+		obj->max_api_ver < SQLANY_API_VERSION_4 ) {
+		// can't support wide inserts with older dbcapi
+		delete baton;
+		std::string error_msg;
+		getErrorMsg( JS_ERR_NO_WIDE_STATEMENTS, error_msg );
+		returnError( args, error_msg, cbfunc_arg, callback_required,
+			     promise_required );
+		return;
+	    }
+	    chargeExternalMemory( execution->external_bytes,
+				      (int64_t)boundBytes( execution->params, execution->num_rows ) );
+	} else {
+	    execution->execData.push_back( new ExecuteData );
+	    execution->num_rows = 1;
+	}
+    }
+
+    // the statements differ, so the batch is described by its size
+    diagBatchStart( baton, "execBatch", std::string(),
+		    baton->executions.size() );
+
+    uv_work_t *req = new uv_work_t();
+    req->data = baton;
+
+    if( callback_required || promise_required ) {
+	Local<Value> promise;
+	if( callback_required ) {
+	    Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
+	    baton->callback.Reset( isolate, callback );
+	} else {
+	    promise = newPromise( isolate, baton->resolver );
+	}
+
+	int status;
+	markBatch( baton, TIMING_ENQUEUED );
+	status = queueWork( req, execBatchWork, (uv_after_work_cb)execBatchAfter,
+			"sqlanywhere:execBatch",
+			chargeBatchMemory );
+	assert(status == 0);
+
+	if( promise_required ) {
+	    args.GetReturnValue().Set( promise );
+	} else {
+	    args.GetReturnValue().SetUndefined();
+	}
+	return;
+    }
+
+    Persistent<Value> Results;
+
+    markBatch( baton, TIMING_ENQUEUED );
+    execBatchWork( req );
+    chargeBatchMemory( req );
+    bool success = fillManyResults( baton, Results );
+    delete baton;
+    delete req;
+
+    if( !success ) {
+	args.GetReturnValue().SetUndefined();
+	return;
+    }
+    args.GetReturnValue().Set( Local<Value>::New( isolate, Results ) );
+    Results.Reset();
+}
+
+NODE_API_FUNC( Connection::execAll )
+/**********************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    Local<Context> context = isolate->GetCurrentContext();
+    HandleScope scope( isolate );
+
+    int num_args = args.Length();
+    bool callback_required = false, bind_required = false;
+    int cbfunc_arg = 0;
+    if( args[0]->IsString() ) {
+	if( num_args == 1 ) {
+
+	} else if( num_args == 2 && args[1]->IsArray() ) {
+	    bind_required = true;
+
+	} else if( num_args == 2 && args[1]->IsFunction() ) {
+	    callback_required = true;
+	    cbfunc_arg = 1;
+
+	} else if( num_args == 3 && args[1]->IsArray() && args[2]->IsFunction() ) {
+	    callback_required = true;
+	    bind_required = true;
+	    cbfunc_arg = 2;
+
+	} else {
+	    throwError( JS_ERR_INVALID_ARGUMENTS );
+	    args.GetReturnValue().SetUndefined();
+	    return;
+	}
+    } else {
+	throwError( JS_ERR_INVALID_ARGUMENTS );
+	args.GetReturnValue().SetUndefined();
+	return;
+    }
+
+    Connection *obj = ObjectWrap::Unwrap<Connection>( args.This() );
+    bool promise_required = !callback_required && obj != NULL &&
+			    obj->promise_mode;
+
+    if( obj == NULL || obj->conn == NULL ) {
+	std::string error_msg;
+	getErrorMsg( JS_ERR_INVALID_OBJECT, error_msg );
+	returnError( args, error_msg, cbfunc_arg, callback_required,
+		     promise_required );
+	return;
+    }
+
+#if NODE_MAJOR_VERSION >= 12
+    String::Utf8Value param0( isolate, (args[0]->ToString(context)).ToLocalChecked() );
+#else
+    String::Utf8Value param0( (args[0]->ToString(context)).ToLocalChecked() );
+#endif
+
+    batchBaton *baton = new batchBaton();
+    baton->obj = obj;
+    baton->callback_required = callback_required;
+
+    executeBaton *execution = new executeBaton();
+    execution->obj = obj;
+    execution->limits = obj->result_limits;
+    execution->deadline = requestDeadline( obj );
+    execution->record_statement = obj->statement_stats_mode;
+    execution->slow_query_ms = obj->slow_query_ms;
+    execution->slow_query_file = obj->slow_query_file;
+    execution->timing.enabled = obj->timing_mode ||
+				execution->record_statement ||
+				execution->slow_query_ms > 0;
+    execution->free_stmt = true;
+    execution->stmt_obj = NULL;
+    execution->stmt = std::string(*param0);
+    baton->executions.push_back( execution );
+
+    if( bind_required ) {
+	if( !getBindParameters( execution->execData, isolate, args[1],
+				execution->params, execution->num_rows ) ) {
+	    delete baton;
+	    std::string error_msg;
+	    getErrorMsg( JS_ERR_BINDING_PARAMETERS, error_msg );
+	    returnError( args, error_msg, cbfunc_arg, callback_required,
+			 promise_required );
+	    return;
+	}
+	if( execution->num_rows > 1 &&
+	    obj->max_api_ver < SQLANY_API_VERSION_4 ) {
+	    // can't support wide inserts with older dbcapi
+	    delete baton;
+	    std::string error_msg;
+	    getErrorMsg( JS_ERR_NO_WIDE_STATEMENTS, error_msg );
+	    returnError( args, error_msg, cbfunc_arg, callback_required,
+			 promise_required );
+	    return;
+	}
+	chargeExternalMemory( execution->external_bytes,
+			      (int64_t)boundBytes( execution->params, execution->num_rows ) );
+    } else {
+	execution->execData.push_back( new ExecuteData );
+	execution->num_rows = 1;
+    }
+
+    diagBatchStart( baton, "execAll", execution->stmt, 0 );
+
+    uv_work_t *req = new uv_work_t();
+    req->data = baton;
+
+    if( callback_required || promise_required ) {
+	Local<Value> promise;
+	if( callback_required ) {
+	    Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
+	    baton->callback.Reset( isolate, callback );
+	} else {
+	    promise = newPromise( isolate, baton->resolver );
+	}
+
+	int status;
+	markBatch( baton, TIMING_ENQUEUED );
+	status = queueWork( req, execAllWork, (uv_after_work_cb)execAllAfter,
+			"sqlanywhere:execAll",
+			chargeBatchMemory );
+	assert(status == 0);
+
+	if( promise_required ) {
+	    args.GetReturnValue().Set( promise );
+	} else {
+	    args.GetReturnValue().SetUndefined();
+	}
+	return;
+    }
+
+    Persistent<Value> Results;
 
+    markBatch( baton, TIMING_ENQUEUED );
+    execAllWork( req );
+    chargeBatchMemory( req );
+    bool success = fillManyResults( baton, Results );
     delete baton;
     delete req;
-    
+
     if( !success ) {
 	args.GetReturnValue().SetUndefined();
 	return;
     }
-    Local<Value> local_result = Local<Value>::New( isolate, ResultSet );
-    args.GetReturnValue().Set( local_result );
-    ResultSet.Reset();
+    args.GetReturnValue().Set( Local<Value>::New( isolate, Results ) );
+    Results.Reset();
 }
 
 struct prepareBaton {
     Persistent<Function> 	callback;
+    Persistent<Promise::Resolver>	resolver;
     bool 			err;
     std::string 		error_msg;
     bool 			callback_required;
@@ -550,6 +1929,7 @@ struct prepareBaton {
     StmtObject 			*obj;
     std::string 		stmt;
     Persistent<Value> 		StmtObj;
+    diagEvent			diag;
     
     prepareBaton() {
 	err = false;
@@ -560,6 +1940,7 @@ struct prepareBaton {
     ~prepareBaton() {
 	obj = NULL;
 	callback.Reset();
+	resolver.Reset();
 	StmtObj.Reset();
     }
 };
@@ -575,10 +1956,20 @@ void Connection::prepareWork( uv_work_t *req )
 	return;
     }
     
-    scoped_lock lock( baton->obj->connection->conn_mutex );
+    scoped_lock lock( baton->obj->connection->conn_mutex,
+		      baton->obj->connection->conn_lock );
 
-    baton->obj->sqlany_stmt = api.sqlany_prepare( baton->obj->connection->conn,
-						  baton->stmt.c_str() );
+    baton->obj->sqlany_stmt = baton->obj->connection->takeCachedStmt( baton->stmt );
+    if( baton->obj->sqlany_stmt != NULL ) {
+	baton->obj->cached = true;
+	return;
+    }
+    {
+	traceSpan span( "sqlany_prepare" );
+	baton->obj->sqlany_stmt = api.sqlany_prepare( baton->obj->connection->conn,
+						      baton->stmt.c_str() );
+    }
+    baton->obj->connection->stats.add( STAT_PREPARES, 1 );
     if( baton->obj->sqlany_stmt == NULL ) {
 	baton->err = true;
 	getErrorMsg( baton->obj->connection->conn, baton->error_msg );
@@ -586,6 +1977,10 @@ void Connection::prepareWork( uv_work_t *req )
     }
 }
 
+// Rough size of the client-side buffers dbcapi keeps for a prepared statement
+// and its cursor, reported to V8 while the statement is open.
+static const int64_t PREPARED_STMT_BYTES = 16 * 1024;
+
 void Connection::prepareAfter( uv_work_t *req ) 
 /**********************************************/
 {
@@ -595,16 +1990,20 @@ void Connection::prepareAfter( uv_work_t *req )
     Local<Value> undef = Local<Value>::New( isolate, Undefined( isolate ) );
     
     if( baton->err ) {
-	callBack( &( baton->error_msg ), baton->callback, undef,
+	diagEnd( baton->diag, &( baton->error_msg ) );
+	callBack( &( baton->error_msg ), baton->callback, baton->resolver, undef,
 		  baton->callback_required );
 	delete baton;
 	delete req;
 	return;
     }
     
-    if( baton->callback_required ) {
+    diagEnd( baton->diag, NULL );
+    chargeExternalMemory( baton->obj->external_bytes, PREPARED_STMT_BYTES );
+    if( baton->callback_required || !baton->resolver.IsEmpty() ) {
 	Local<Value> StmtObj = Local<Value>::New( isolate, baton->StmtObj );
-	callBack( NULL, baton->callback, StmtObj,  baton->callback_required );
+	callBack( NULL, baton->callback, baton->resolver, StmtObj,
+		  baton->callback_required );
 	baton->StmtObj.Reset();
     }
     
@@ -620,7 +2019,6 @@ NODE_API_FUNC( Connection::prepare )
     HandleScope scope( isolate );
     bool callback_required = false;
     int cbfunc_arg = -1;
-    Local<Value> undef = Local<Value>::New( isolate, Undefined( isolate ) );
 
     if( args.Length() == 1 && args[0]->IsString() ) {
 	// do nothing
@@ -634,12 +2032,14 @@ NODE_API_FUNC( Connection::prepare )
     }
         
     Connection *db = ObjectWrap::Unwrap<Connection>( args.This() );
+    bool promise_required = !callback_required && db != NULL &&
+			    db->promise_mode;
     
     if( db == NULL || db->conn == NULL ) {
 	std::string error_msg;
 	getErrorMsg( JS_ERR_NOT_CONNECTED, error_msg );
-	callBack( &( error_msg ), args[cbfunc_arg], undef, callback_required );
-	args.GetReturnValue().SetUndefined();
+	returnError( args, error_msg, cbfunc_arg, callback_required,
+		     promise_required );
 	return;
     }
 
@@ -649,18 +2049,19 @@ NODE_API_FUNC( Connection::prepare )
     StmtObject *obj = ObjectWrap::Unwrap<StmtObject>( l_stmt );
     obj->connection = db;
     {
-        scoped_lock	lock( db->conn_mutex );
+        scoped_lock	lock( db->conn_mutex, db->conn_lock );
 	db->statements.push_back( obj );
     }
 
     if( obj == NULL ) {
         std::string error_msg;
 	getErrorMsg( JS_ERR_GENERAL_ERROR, error_msg );
-	callBack( &( error_msg ), args[cbfunc_arg], undef, callback_required );
-	args.GetReturnValue().SetUndefined();
+	returnError( args, error_msg, cbfunc_arg, callback_required,
+		     promise_required );
 	p_stmt.Reset();
 	return;
     }
+    obj->promise_mode = db->promise_mode;
     
 #if NODE_MAJOR_VERSION >= 12
     String::Utf8Value param0( isolate, (args[0]->ToString(context)).ToLocalChecked() );
@@ -672,20 +2073,31 @@ NODE_API_FUNC( Connection::prepare )
     baton->obj = obj;
     baton->callback_required = callback_required;    
     baton->stmt =  std::string(*param0);
+    obj->sql = baton->stmt;
+    diagStart( baton->diag, "prepare", baton->stmt, 0 );
     
     uv_work_t *req = new uv_work_t();
     req->data = baton;
     
-    if( callback_required ) {
-	Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
-	baton->callback.Reset( isolate, callback );
+    if( callback_required || promise_required ) {
+	Local<Value> promise;
+	if( callback_required ) {
+	    Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
+	    baton->callback.Reset( isolate, callback );
+	} else {
+	    promise = newPromise( isolate, baton->resolver );
+	}
 	baton->StmtObj.Reset( isolate, p_stmt );
 	int status;
-	status = uv_queue_work( uv_default_loop(), req, prepareWork,
-				(uv_after_work_cb)prepareAfter );
+	status = queueWork( req, prepareWork, (uv_after_work_cb)prepareAfter,
+			"sqlanywhere:prepare" );
 	assert(status == 0);
-	
-	args.GetReturnValue().SetUndefined();
+
+	if( promise_required ) {
+	    args.GetReturnValue().Set( promise );
+	} else {
+	    args.GetReturnValue().SetUndefined();
+	}
 	p_stmt.Reset();
 	return;
     }
@@ -703,10 +2115,179 @@ NODE_API_FUNC( Connection::prepare )
 }
 
 
+// Statement cache
+struct cacheBaton {
+    Persistent<Function> 	callback;
+    Persistent<Promise::Resolver>	resolver;
+    bool 			err;
+    std::string 		error_msg;
+    bool 			callback_required;
+    
+    Connection 			*obj;
+    std::vector<std::string>	statements;
+    diagEvent			diag;
+    
+    cacheBaton() {
+	err = false;
+	callback_required = false;
+	obj = NULL;
+    }
+    
+    ~cacheBaton() {
+	obj = NULL;
+	callback.Reset();
+	resolver.Reset();
+    }
+};
+
+void Connection::cacheStatementsWork( uv_work_t *req ) 
+/*****************************************************/
+{
+    cacheBaton *baton = static_cast<cacheBaton*>(req->data);
+    scoped_lock lock( baton->obj->conn_mutex, baton->obj->conn_lock );
+    
+    if( baton->obj->conn == NULL ) {
+	baton->err = true;
+	getErrorMsg( JS_ERR_NOT_CONNECTED, baton->error_msg );
+	return;
+    }
+
+    for( size_t i = 0; i < baton->statements.size(); i++ ) {
+	const std::string &sql = baton->statements[i];
+	if( baton->obj->stmt_cache.count( sql ) > 0 ) {
+	    continue;
+	}
+	a_sqlany_stmt *sqlany_stmt;
+	{
+	    traceSpan span( "sqlany_prepare" );
+	    sqlany_stmt = api.sqlany_prepare( baton->obj->conn, sql.c_str() );
+	}
+	baton->obj->stats.add( STAT_PREPARES, 1 );
+	if( sqlany_stmt == NULL ) {
+	    baton->err = true;
+	    getErrorMsg( baton->obj->conn, baton->error_msg );
+	    return;
+	}
+	baton->obj->stmt_cache[sql] = sqlany_stmt;
+    }
+}
+
+void Connection::cacheStatementsAfter( uv_work_t *req ) 
+/******************************************************/
+{
+    Isolate *isolate = Isolate::GetCurrent();
+    HandleScope scope( isolate );
+    cacheBaton *baton = static_cast<cacheBaton*>(req->data);
+    Local<Value> undef = Local<Value>::New( isolate, Undefined( isolate ) );
+    
+    if( baton->err ) {
+	diagEnd( baton->diag, &( baton->error_msg ) );
+	callBack( &( baton->error_msg ), baton->callback, baton->resolver, undef,
+		  baton->callback_required );
+    } else {
+	diagEnd( baton->diag, NULL );
+	callBack( NULL, baton->callback, baton->resolver, undef,
+		  baton->callback_required );
+    }
+    
+    delete baton;
+    delete req;
+}
+
+NODE_API_FUNC( Connection::cacheStatements )
+/******************************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    Local<Context> context = isolate->GetCurrentContext();
+    HandleScope scope( isolate );
+    int num_args = args.Length();
+    bool callback_required = false;
+    int cbfunc_arg = -1;
+
+    if( num_args == 1 && args[0]->IsArray() ) {
+
+    } else if( num_args == 2 && args[0]->IsArray() && args[1]->IsFunction() ) {
+	callback_required = true;
+	cbfunc_arg = 1;
+
+    } else {
+	throwError( JS_ERR_INVALID_ARGUMENTS );
+	args.GetReturnValue().SetUndefined();
+	return;
+    }
+
+    Connection *obj = ObjectWrap::Unwrap<Connection>( args.This() );
+    bool promise_required = !callback_required && obj != NULL &&
+			    obj->promise_mode;
+
+    if( obj == NULL || obj->conn == NULL ) {
+	std::string error_msg;
+	getErrorMsg( JS_ERR_NOT_CONNECTED, error_msg );
+	returnError( args, error_msg, cbfunc_arg, callback_required,
+		     promise_required );
+	return;
+    }
+
+    cacheBaton *baton = new cacheBaton();
+    baton->obj = obj;
+    baton->callback_required = callback_required;
+
+    Local<Array> statements = Local<Array>::Cast( args[0] );
+    for( uint32_t i = 0; i < statements->Length(); i++ ) {
+	Local<Value> sql = statements->Get( context, i ).ToLocalChecked();
+	if( !sql->IsString() ) {
+	    delete baton;
+	    std::string error_msg;
+	    getErrorMsg( JS_ERR_INVALID_ARGUMENTS, error_msg );
+	    returnError( args, error_msg, cbfunc_arg, callback_required,
+			 promise_required );
+	    return;
+	}
+#if NODE_MAJOR_VERSION >= 12
+	String::Utf8Value sql_utf8( isolate, sql );
+#else
+	String::Utf8Value sql_utf8( sql );
+#endif
+	baton->statements.push_back( std::string( *sql_utf8 ) );
+    }
+    diagStart( baton->diag, "cacheStatements", std::string(), 0 );
+
+    uv_work_t *req = new uv_work_t();
+    req->data = baton;
+
+    if( callback_required || promise_required ) {
+	Local<Value> promise;
+	if( callback_required ) {
+	    Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
+	    baton->callback.Reset( isolate, callback );
+	} else {
+	    promise = newPromise( isolate, baton->resolver );
+	}
+	int status;
+	status = queueWork( req, cacheStatementsWork,
+			    (uv_after_work_cb)cacheStatementsAfter,
+			    "sqlanywhere:cacheStatements" );
+	assert(status == 0);
+
+	if( promise_required ) {
+	    args.GetReturnValue().Set( promise );
+	} else {
+	    args.GetReturnValue().SetUndefined();
+	}
+	return;
+    }
+
+    cacheStatementsWork( req );
+    cacheStatementsAfter( req );
+    args.GetReturnValue().SetUndefined();
+}
+
+
 // Connect and disconnect
 // Connect Function
 struct connectBaton {
     Persistent<Function> 	callback;
+    Persistent<Promise::Resolver>	resolver;
     bool 			err;
     std::string 		error_msg;
     bool 			callback_required;
@@ -728,6 +2309,7 @@ struct connectBaton {
 	obj = NULL;
 	sqlca = NULL;
 	callback.Reset();
+	resolver.Reset();
     }
     
 };
@@ -736,8 +2318,7 @@ void Connection::connectWork( uv_work_t *req )
 /*********************************************/
 {
     connectBaton *baton = static_cast<connectBaton*>(req->data);
-    scoped_lock api_lock( api_mutex );
-    scoped_lock lock( baton->obj->conn_mutex );
+    scoped_lock lock( baton->obj->conn_mutex, baton->obj->conn_lock );
     
     if( baton->obj->conn != NULL ) {
 	baton->err = true;
@@ -745,41 +2326,28 @@ void Connection::connectWork( uv_work_t *req )
 	return;
     }
     
-    if( api.initialized == false) {
-    
-	if( !sqlany_initialize_interface( &api, NULL ) ) {
-	    baton->err = true;
-	    getErrorMsg( JS_ERR_INITIALIZING_DBCAPI, baton->error_msg );
-	    return;
-	}
-    
-	if( !api.sqlany_init( "Node.js", SQLANY_API_VERSION_4,
-			      &(baton->obj->max_api_ver) )) {
-	    // As long as the version is >= 2, we're OK. We just have to disable
-	    // wide inserts
-	    if( baton->obj->max_api_ver >= SQLANY_API_VERSION_2 ) {
-		if( !api.sqlany_init( "Node.js", baton->obj->max_api_ver,
-				      &(baton->obj->max_api_ver) )) {
-		    baton->err = true;
-		    getErrorMsg( JS_ERR_INITIALIZING_DBCAPI, baton->error_msg );
-		    return;
-		}
-	    } else {
-		baton->err = true;
-		getErrorMsg( JS_ERR_INITIALIZING_DBCAPI, baton->error_msg );
-		return;
-	    }
-	}
+    // Only the API reference is taken under api_mutex. The connect itself
+    // runs under this connection's lock alone, so that many connections can
+    // be opened at once.
+    if( !acquireAPI( baton->obj->max_api_ver ) ) {
+	baton->err = true;
+	getErrorMsg( JS_ERR_INITIALIZING_DBCAPI, baton->error_msg );
+	return;
     }
     
     if( !baton->sqlca_connection ) {
 	baton->obj->conn = api.sqlany_new_connection();
-	if( !api.sqlany_connect( baton->obj->conn, baton->conn_string.c_str() ) ) {
+	sacapi_bool connected;
+	{
+	    traceSpan span( "sqlany_connect" );
+	    connected = api.sqlany_connect( baton->obj->conn, baton->conn_string.c_str() );
+	}
+	if( !connected ) {
 	    getErrorMsg( baton->obj->conn, baton->error_msg );
 	    baton->err = true;
 	    api.sqlany_free_connection( baton->obj->conn );
 	    baton->obj->conn = NULL;
-	    cleanAPI();
+	    releaseAPI();
 	    return;
 	}
 	
@@ -787,13 +2355,12 @@ void Connection::connectWork( uv_work_t *req )
 	baton->obj->conn = api.sqlany_make_connection( baton->sqlca );
 	if( baton->obj->conn == NULL ) {
 	    getErrorMsg( baton->obj->conn, baton->error_msg );
-	    cleanAPI();
+	    releaseAPI();
 	    return;
 	}
     } 
     
     baton->obj->sqlca_connection = baton->sqlca_connection;
-    openConnections++;
 }
 
 void Connection::connectAfter( uv_work_t *req ) 
@@ -805,14 +2372,15 @@ void Connection::connectAfter( uv_work_t *req )
     Local<Value> undef = Local<Value>::New( isolate, Undefined( isolate ) );
     
     if( baton->err ) {
-	callBack( &( baton->error_msg ), baton->callback, undef,
+	callBack( &( baton->error_msg ), baton->callback, baton->resolver, undef,
 		  baton->callback_required );
 	delete baton;
 	delete req;
 	return;
     }
     
-    callBack( NULL, baton->callback, undef, baton->callback_required );
+    callBack( NULL, baton->callback, baton->resolver, undef,
+	      baton->callback_required );
     
     delete baton;
     delete req;
@@ -875,6 +2443,8 @@ NODE_API_FUNC( Connection::connect )
 	return;
     }
     
+    bool promise_required = !callback_required && obj->promise_mode;
+
     connectBaton *baton = new connectBaton();
     baton->obj = obj;
     baton->callback_required = callback_required;
@@ -924,15 +2494,25 @@ NODE_API_FUNC( Connection::connect )
     uv_work_t *req = new uv_work_t();
     req->data = baton;
     
-    if( callback_required ) {
-	Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
-	baton->callback.Reset( isolate, callback );
+    if( callback_required || promise_required ) {
+	Local<Value> promise;
+	if( callback_required ) {
+	    Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
+	    baton->callback.Reset( isolate, callback );
+	} else {
+	    promise = newPromise( isolate, baton->resolver );
+	}
 
 	int status;
-	status = uv_queue_work( uv_default_loop(), req, connectWork,
-				(uv_after_work_cb)connectAfter );
+	status = queueWork( req, connectWork, (uv_after_work_cb)connectAfter,
+			"sqlanywhere:connect" );
 	assert(status == 0);
-	args.GetReturnValue().SetUndefined();
+
+	if( promise_required ) {
+	    args.GetReturnValue().Set( promise );
+	} else {
+	    args.GetReturnValue().SetUndefined();
+	}
 	return;
     }
     
@@ -947,29 +2527,26 @@ void Connection::disconnectWork( uv_work_t *req )
 /************************************************/
 {
     noParamBaton *baton = static_cast<noParamBaton*>(req->data);
-    scoped_lock api_lock(api_mutex );
-    scoped_lock lock( baton->obj->conn_mutex );
+    {
+	scoped_lock lock( baton->obj->conn_mutex, baton->obj->conn_lock );
     
-    if( baton->obj->conn == NULL ) {
-	getErrorMsg( JS_ERR_NOT_CONNECTED, baton->error_msg );
-	return;
-    }
+	if( baton->obj->conn == NULL ) {
+	    getErrorMsg( JS_ERR_NOT_CONNECTED, baton->error_msg );
+	    return;
+	}
 
-    baton->obj->cleanupStmts();
+	baton->obj->cleanupStmts();
+	baton->obj->clearStmtCache();
 
-    if( !baton->obj->sqlca_connection ) {
-	api.sqlany_disconnect( baton->obj->conn );
+	if( !baton->obj->sqlca_connection ) {
+	    api.sqlany_disconnect( baton->obj->conn );
+	}
+	// Must free the connection object or there will be a memory leak 
+	api.sqlany_free_connection( baton->obj->conn );
+	baton->obj->conn = NULL;
     }
-    // Must free the connection object or there will be a memory leak 
-    api.sqlany_free_connection( baton->obj->conn );
-    baton->obj->conn = NULL;
-    openConnections--;
 
-    if( openConnections <= 0 ) {	
-	openConnections = 0;
-	cleanAPI();
-    }
-    
+    releaseAPI();
     return;
 }
 
@@ -995,6 +2572,7 @@ NODE_API_FUNC( Connection::disconnect )
     }
     
     Connection *obj = ObjectWrap::Unwrap<Connection>( args.This() );
+    bool promise_required = !callback_required && obj->promise_mode;
     noParamBaton *baton = new noParamBaton();
     
     baton->callback_required = callback_required;
@@ -1003,16 +2581,25 @@ NODE_API_FUNC( Connection::disconnect )
     uv_work_t *req = new uv_work_t();
     req->data = baton;
     
-    if( callback_required ) {
-	Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
-	baton->callback.Reset( isolate, callback );
+    if( callback_required || promise_required ) {
+	Local<Value> promise;
+	if( callback_required ) {
+	    Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
+	    baton->callback.Reset( isolate, callback );
+	} else {
+	    promise = newPromise( isolate, baton->resolver );
+	}
 	
 	int status;
-	status = uv_queue_work( uv_default_loop(), req, disconnectWork,
-				(uv_after_work_cb)noParamAfter );
+	status = queueWork( req, disconnectWork, (uv_after_work_cb)noParamAfter,
+			"sqlanywhere:disconnect" );
 	assert(status == 0);
-	
-	args.GetReturnValue().SetUndefined();
+
+	if( promise_required ) {
+	    args.GetReturnValue().Set( promise );
+	} else {
+	    args.GetReturnValue().SetUndefined();
+	}
 	return;
     }
     
@@ -1026,7 +2613,7 @@ void Connection::commitWork( uv_work_t *req )
 /********************************************/
 {
     noParamBaton *baton = static_cast<noParamBaton*>(req->data);
-    scoped_lock lock( baton->obj->conn_mutex );
+    scoped_lock lock( baton->obj->conn_mutex, baton->obj->conn_lock );
     
     if( baton->obj->conn == NULL ) {
 	baton->err = true;
@@ -1063,24 +2650,35 @@ NODE_API_FUNC( Connection::commit )
     }
     
     Connection *obj = ObjectWrap::Unwrap<Connection>( args.This() );
+    bool promise_required = !callback_required && obj->promise_mode;
     
     noParamBaton *baton = new noParamBaton();
     baton->obj = obj;
     baton->callback_required = callback_required;
+    diagStart( baton->diag, "commit", std::string(), 0 );
     
     uv_work_t *req = new uv_work_t();
     req->data = baton;
     
-    if( callback_required ) {
-	Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
-	baton->callback.Reset( isolate, callback );
+    if( callback_required || promise_required ) {
+	Local<Value> promise;
+	if( callback_required ) {
+	    Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
+	    baton->callback.Reset( isolate, callback );
+	} else {
+	    promise = newPromise( isolate, baton->resolver );
+	}
 	
 	int status;
-	status = uv_queue_work( uv_default_loop(), req, commitWork, 
-				(uv_after_work_cb)noParamAfter );
+	status = queueWork( req, commitWork, (uv_after_work_cb)noParamAfter,
+			"sqlanywhere:commit" );
 	assert(status == 0);
-	
-	args.GetReturnValue().SetUndefined();
+
+	if( promise_required ) {
+	    args.GetReturnValue().Set( promise );
+	} else {
+	    args.GetReturnValue().SetUndefined();
+	}
 	return;
     }
     
@@ -1094,7 +2692,7 @@ void Connection::rollbackWork( uv_work_t *req )
 /**********************************************/
 {
     noParamBaton *baton = static_cast<noParamBaton*>(req->data);
-    scoped_lock lock( baton->obj->conn_mutex );
+    scoped_lock lock( baton->obj->conn_mutex, baton->obj->conn_lock );
 
     if( baton->obj->conn == NULL ) {
 	baton->err = true;
@@ -1131,24 +2729,35 @@ NODE_API_FUNC( Connection::rollback )
     }
     
     Connection *obj = ObjectWrap::Unwrap<Connection>( args.This() );
+    bool promise_required = !callback_required && obj->promise_mode;
 
     noParamBaton *baton = new noParamBaton();
     baton->obj = obj;
     baton->callback_required = callback_required;
+    diagStart( baton->diag, "rollback", std::string(), 0 );
     
     uv_work_t *req = new uv_work_t();
     req->data = baton;
     
-    if( callback_required ) {
-	Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
-	baton->callback.Reset( isolate, callback );
+    if( callback_required || promise_required ) {
+	Local<Value> promise;
+	if( callback_required ) {
+	    Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
+	    baton->callback.Reset( isolate, callback );
+	} else {
+	    promise = newPromise( isolate, baton->resolver );
+	}
 	
 	int status;
-	status = uv_queue_work( uv_default_loop(), req, rollbackWork,
-				(uv_after_work_cb)noParamAfter );
+	status = queueWork( req, rollbackWork, (uv_after_work_cb)noParamAfter,
+			"sqlanywhere:rollback" );
 	assert(status == 0);
-	
-	args.GetReturnValue().SetUndefined();
+
+	if( promise_required ) {
+	    args.GetReturnValue().Set( promise );
+	} else {
+	    args.GetReturnValue().SetUndefined();
+	}
 	return;
     }
     
@@ -1165,8 +2774,113 @@ NODE_API_FUNC( Connection::connected )
     args.GetReturnValue().Set( obj->conn == NULL ? false : true );
 }
 
+// Reads a result size limit. Zero, a negative number, NaN or Infinity
+// removes the limit, and a limit too large for uint64_t is capped.
+static void getLimitOption( Isolate *isolate, Local<Object> options,
+			    const char *name, uint64_t &limit )
+/*****************************************************************/
+{
+    double value;
+    if( !getNumberOption( isolate, options, name, value ) ) {
+	return;
+    }
+    if( !std::isfinite( value ) || value <= 0 ) {
+	limit = 0;
+    } else if( value >= (double)UINT64_MAX ) {
+	limit = UINT64_MAX;
+    } else {
+	limit = (uint64_t)value;
+    }
+}
+
+NODE_API_FUNC( Connection::setOptions )
+/*************************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    Local<Context> context = isolate->GetCurrentContext();
+    HandleScope scope( isolate );
+
+    if( args.Length() != 1 || !args[0]->IsObject() ) {
+	throwError( JS_ERR_INVALID_ARGUMENTS );
+	args.GetReturnValue().SetUndefined();
+	return;
+    }
+
+    Connection *obj = ObjectWrap::Unwrap<Connection>( args.This() );
+    Local<Object> options = args[0]->ToObject( context ).ToLocalChecked();
+
+    // Checked before any option is applied; NaN fails the comparison
+    double deadline_ms = obj->deadline_ms;
+    if( getNumberOption( isolate, options, "deadlineMs", deadline_ms ) &&
+	!( deadline_ms >= 0 && std::isfinite( deadline_ms ) ) ) {
+	throwError( JS_ERR_INVALID_ARGUMENTS );
+	args.GetReturnValue().SetUndefined();
+	return;
+    }
+
+    getBoolOption( isolate, options, "promises", obj->promise_mode );
+    if( getBoolOption( isolate, options, "timing", obj->timing_mode ) ) {
+	obj->timings.reset();
+    }
+    getBoolOption( isolate, options, "statementStats", obj->statement_stats_mode );
+    getNumberOption( isolate, options, "slowQueryMs", obj->slow_query_ms );
+    getLimitOption( isolate, options, "maxRows", obj->result_limits.max_rows );
+    getLimitOption( isolate, options, "maxResultBytes",
+		    obj->result_limits.max_bytes );
+    obj->deadline_ms = deadline_ms;
+
+    Local<Value> slow_query_log;
+    if( getOption( isolate, options, "slowQueryLog", slow_query_log ) ) {
+	obj->slow_query_sink.Reset();
+	obj->slow_query_file.clear();
+	if( slow_query_log->IsFunction() ) {
+	    obj->slow_query_sink.Reset( isolate, Local<Function>::Cast( slow_query_log ) );
+	} else if( slow_query_log->IsString() ) {
+#if NODE_MAJOR_VERSION >= 12
+	    String::Utf8Value file( isolate, slow_query_log );
+#else
+	    String::Utf8Value file( slow_query_log );
+#endif
+	    obj->slow_query_file = std::string( *file );
+	} else if( !slow_query_log->IsNull() && !slow_query_log->IsUndefined() ) {
+	    throwError( JS_ERR_INVALID_ARGUMENTS );
+	    args.GetReturnValue().SetUndefined();
+	    return;
+	}
+    }
+    args.GetReturnValue().SetUndefined();
+}
+
+NODE_API_FUNC( Connection::getStats )
+/***********************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    HandleScope scope( isolate );
+    Connection *obj = ObjectWrap::Unwrap<Connection>( args.This() );
+    args.GetReturnValue().Set( statsObject( isolate, obj->stats ) );
+}
+
+NODE_API_FUNC( Connection::getLockStats )
+/***************************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    HandleScope scope( isolate );
+    Connection *obj = ObjectWrap::Unwrap<Connection>( args.This() );
+    args.GetReturnValue().Set( lockStatsObject( isolate, obj->conn_lock ) );
+}
+
+NODE_API_FUNC( Connection::getTimings )
+/*************************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    HandleScope scope( isolate );
+    Connection *obj = ObjectWrap::Unwrap<Connection>( args.This() );
+    args.GetReturnValue().Set( timingsObject( isolate, obj->timings ) );
+}
+
 struct dropBaton {
     Persistent<Function> 	callback;
+    Persistent<Promise::Resolver>	resolver;
     bool 			err;
     std::string 		error_msg;
     bool 			callback_required;
@@ -1182,6 +2896,7 @@ struct dropBaton {
     ~dropBaton() {
 	obj = NULL;
 	callback.Reset();
+	resolver.Reset();
     }
 };
 
@@ -1194,14 +2909,16 @@ void StmtObject::dropAfter( uv_work_t *req )
     Local<Value> undef = Local<Value>::New( isolate, Undefined( isolate ) );
     
     if( baton->err ) {
-	callBack( &( baton->error_msg ), baton->callback, undef,
+	callBack( &( baton->error_msg ), baton->callback, baton->resolver, undef,
 		  baton->callback_required );
 	delete baton;
 	delete req;
 	return;
     }
     
-    callBack( NULL, baton->callback, undef, baton->callback_required );
+    releaseExternalMemory( baton->obj->external_bytes );
+    callBack( NULL, baton->callback, baton->resolver, undef,
+	      baton->callback_required );
     
     delete baton;
     delete req;
@@ -1211,7 +2928,8 @@ void StmtObject::dropWork( uv_work_t *req )
 /******************************************/
 {
     dropBaton *baton = static_cast<dropBaton*>(req->data);
-    scoped_lock connlock( baton->obj->connection->conn_mutex );
+    scoped_lock connlock( baton->obj->connection->conn_mutex,
+			  baton->obj->connection->conn_lock );
 
     baton->obj->cleanup();
     baton->obj->removeConnection();
@@ -1239,6 +2957,7 @@ NODE_API_FUNC( StmtObject::drop )
     }
     
     StmtObject *obj = ObjectWrap::Unwrap<StmtObject>( args.This() );
+    bool promise_required = !callback_required && obj->promise_mode;
 
     dropBaton *baton = new dropBaton();
     baton->obj = obj;
@@ -1247,16 +2966,25 @@ NODE_API_FUNC( StmtObject::drop )
     uv_work_t *req = new uv_work_t();
     req->data = baton;
     
-    if( callback_required ) {
-	Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
-	baton->callback.Reset( isolate, callback );
+    if( callback_required || promise_required ) {
+	Local<Value> promise;
+	if( callback_required ) {
+	    Local<Function> callback = Local<Function>::Cast(args[cbfunc_arg]);
+	    baton->callback.Reset( isolate, callback );
+	} else {
+	    promise = newPromise( isolate, baton->resolver );
+	}
 	
 	int status;
-	status = uv_queue_work( uv_default_loop(), req, dropWork,
-				(uv_after_work_cb)dropAfter );
+	status = queueWork( req, dropWork, (uv_after_work_cb)dropAfter,
+			"sqlanywhere:drop" );
 	assert(status == 0);
-	
-	args.GetReturnValue().SetUndefined();
+
+	if( promise_required ) {
+	    args.GetReturnValue().Set( promise );
+	} else {
+	    args.GetReturnValue().SetUndefined();
+	}
 	return;
     }
     
@@ -1270,6 +2998,7 @@ void init( Local<Object> exports )
 /********************************/
 {
     uv_mutex_init(&api_mutex);
+    initCompletionQueue();
 #if v012
     Isolate *isolate = Isolate::GetCurrent();
 #else
@@ -1278,6 +3007,18 @@ void init( Local<Object> exports )
     StmtObject::Init( isolate );
     Connection::Init( isolate );
     NODE_SET_METHOD( exports, "createConnection", Connection::NewInstance );
+    NODE_SET_METHOD( exports, "setDiagnosticsChannels", setDiagnosticsChannels );
+    NODE_SET_METHOD( exports, "stats", getGlobalStats );
+    NODE_SET_METHOD( exports, "topStatements", getTopStatements );
+    NODE_SET_METHOD( exports, "lockStats", getLockStats );
+    NODE_SET_METHOD( exports, "startTrace", startTrace );
+    NODE_SET_METHOD( exports, "stopTrace", stopTrace );
+
+    // Trace from the start when SQLANY_TRACE_FILE names a file
+    const char *trace_file = getenv( "SQLANY_TRACE_FILE" );
+    if( trace_file != NULL && trace_file[0] != '\0' ) {
+	traceStart( trace_file );
+    }
 }
 
 NODE_MODULE( DRIVER_NAME, init )
@@ -0,0 +1,294 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+#include <algorithm>
+#include <ctype.h>
+#include <string.h>
+#include "statements.h"
+
+static bool isWordChar( char c )
+/******************************/
+{
+    return isalnum( (unsigned char)c ) || c == '_' || c == '$' || c == '#' ||
+	   c == '@';
+}
+
+// Collapses each "IN ( ?, ?, ... )" in the normalized text to "IN (?)"
+static std::string collapseInLists( const std::string &text )
+/***********************************************************/
+{
+    std::string out;
+    size_t i = 0;
+    while( i < text.length() ) {
+	out += text[i];
+	if( text[i] != '(' || out.length() < 3 ) {
+	    i++;
+	    continue;
+	}
+	// Is the parenthesis preceded by the keyword IN?
+	size_t k = out.length() - 1;
+	if( k > 0 && out[k - 1] == ' ' ) {
+	    k--;
+	}
+	if( k < 2 || toupper( (unsigned char)out[k - 2] ) != 'I' ||
+	    toupper( (unsigned char)out[k - 1] ) != 'N' ||
+	    ( k > 2 && isWordChar( out[k - 3] ) ) ) {
+	    i++;
+	    continue;
+	}
+	// Match a list of placeholders up to the closing parenthesis
+	size_t j = i + 1;
+	bool list = false;
+	while( true ) {
+	    if( j < text.length() && text[j] == ' ' ) j++;
+	    if( j >= text.length() || text[j] != '?' ) break;
+	    j++;
+	    if( j < text.length() && text[j] == ' ' ) j++;
+	    if( j < text.length() && text[j] == ')' ) {
+		list = true;
+		break;
+	    }
+	    if( j >= text.length() || text[j] != ',' ) break;
+	    j++;
+	}
+	if( list ) {
+	    out += "?)";
+	    i = j + 1;
+	} else {
+	    i++;
+	}
+    }
+    return out;
+}
+
+std::string fingerprintSql( const std::string &sql )
+/**************************************************/
+{
+    std::string out;
+    size_t len = sql.length();
+    size_t i = 0;
+    bool space = false;
+
+    out.reserve( len );
+    while( i < len ) {
+	char c = sql[i];
+
+	if( isspace( (unsigned char)c ) ) {
+	    space = true;
+	    i++;
+	    continue;
+	}
+	if( c == '-' && i + 1 < len && sql[i + 1] == '-' ) {
+	    // comment to end of line
+	    while( i < len && sql[i] != '\n' ) i++;
+	    space = true;
+	    continue;
+	}
+	if( c == '/' && i + 1 < len && sql[i + 1] == '*' ) {
+	    size_t end = sql.find( "*/", i + 2 );
+	    i = ( end == std::string::npos ) ? len : end + 2;
+	    space = true;
+	    continue;
+	}
+	if( space && out.length() > 0 ) {
+	    out += ' ';
+	}
+	space = false;
+
+	if( c == '\'' ) {
+	    // string literal, with '' as an embedded quote
+	    i++;
+	    while( i < len ) {
+		if( sql[i] == '\'' ) {
+		    if( i + 1 < len && sql[i + 1] == '\'' ) {
+			i += 2;
+			continue;
+		    }
+		    break;
+		}
+		i++;
+	    }
+	    i++;
+	    out += '?';
+
+	} else if( c == '"' || c == '[' ) {
+	    // quoted identifier, kept as it is
+	    char close = ( c == '"' ) ? '"' : ']';
+	    size_t end = sql.find( close, i + 1 );
+	    end = ( end == std::string::npos ) ? len : end + 1;
+	    out.append( sql, i, end - i );
+	    i = end;
+
+	} else if( isdigit( (unsigned char)c ) &&
+		   ( out.length() == 0 || !isWordChar( out[out.length() - 1] ) ) ) {
+	    // numeric literal, including hex, decimals and exponents
+	    while( i < len && ( isalnum( (unsigned char)sql[i] ) || sql[i] == '.' ||
+				( ( sql[i] == '+' || sql[i] == '-' ) &&
+				  ( sql[i - 1] == 'e' || sql[i - 1] == 'E' ) ) ) ) {
+		i++;
+	    }
+	    out += '?';
+
+	} else {
+	    out += c;
+	    i++;
+	}
+    }
+    return collapseInLists( out );
+}
+
+latencyHistogram::latencyHistogram()
+/**********************************/
+{
+    memset( buckets, 0, sizeof( buckets ) );
+    count = 0;
+    max = 0;
+}
+
+static int bucketIndex( uint64_t value )
+/**************************************/
+{
+    if( value < HIST_SUB_BUCKETS ) {
+	return (int)value;
+    }
+    int msb = 63;
+    while( !( value & ( (uint64_t)1 << msb ) ) ) {
+	msb--;
+    }
+    int shift = msb - HIST_SUB_BITS;
+    int magnitude = shift + 1;
+    if( magnitude >= HIST_MAGNITUDES ) {
+	return HIST_NUM_BUCKETS - 1;
+    }
+    return magnitude * HIST_SUB_BUCKETS +
+	   (int)( ( value >> shift ) & ( HIST_SUB_BUCKETS - 1 ) );
+}
+
+// Returns the largest value that falls into the bucket
+static uint64_t bucketLimit( int index )
+/**************************************/
+{
+    int magnitude = index / HIST_SUB_BUCKETS;
+    uint64_t sub = (uint64_t)( index % HIST_SUB_BUCKETS );
+    if( magnitude == 0 ) {
+	return sub;
+    }
+    return ( ( ( HIST_SUB_BUCKETS + sub + 1 ) << ( magnitude - 1 ) ) - 1 );
+}
+
+void latencyHistogram::record( uint64_t micros )
+/**********************************************/
+{
+    buckets[bucketIndex( micros )]++;
+    count++;
+    if( micros > max ) {
+	max = micros;
+    }
+}
+
+uint64_t latencyHistogram::percentile( double fraction ) const
+/************************************************************/
+{
+    if( count == 0 ) {
+	return 0;
+    }
+    uint64_t rank = (uint64_t)( fraction * (double)count + 0.5 );
+    if( rank < 1 ) {
+	rank = 1;
+    }
+    uint64_t seen = 0;
+    for( int i = 0; i < HIST_NUM_BUCKETS; i++ ) {
+	seen += buckets[i];
+	if( seen >= rank ) {
+	    if( i == HIST_NUM_BUCKETS - 1 ) {
+		// the last bucket also holds everything larger
+		return max;
+	    }
+	    return std::min( bucketLimit( i ), max );
+	}
+    }
+    return max;
+}
+
+statementRegistry::statementRegistry()
+/************************************/
+{
+    uv_mutex_init( &mutex );
+}
+
+statementRegistry::~statementRegistry()
+/*************************************/
+{
+    uv_mutex_destroy( &mutex );
+}
+
+void statementRegistry::record( const std::string &	fingerprint,
+				bool			error,
+				const uint64_t		durations[PHASE_NUM_PHASES] )
+/***********************************************************************************/
+{
+    uv_mutex_lock( &mutex );
+
+    std::map<std::string, entryList::iterator>::iterator found =
+	index.find( fingerprint );
+    if( found != index.end() ) {
+	// move to the front of the LRU list
+	lru.splice( lru.begin(), lru, found->second );
+    } else {
+	if( lru.size() >= STATEMENT_STATS_LIMIT ) {
+	    index.erase( lru.back().fingerprint );
+	    lru.pop_back();
+	}
+	lru.push_front( statementEntry() );
+	lru.front().fingerprint = fingerprint;
+	index[fingerprint] = lru.begin();
+    }
+
+    statementEntry &entry = lru.front();
+    entry.calls++;
+    if( error ) {
+	entry.errors++;
+    } else {
+	for( int i = 0; i < PHASE_NUM_PHASES; i++ ) {
+	    entry.phases[i].record( durations[i] / 1000 );
+	    entry.total_ns += durations[i];
+	}
+    }
+
+    uv_mutex_unlock( &mutex );
+}
+
+static bool byTotalTime( const statementEntry &a, const statementEntry &b )
+/*************************************************************************/
+{
+    return a.total_ns > b.total_ns;
+}
+
+void statementRegistry::top( size_t limit, std::vector<statementEntry> &entries )
+/*******************************************************************************/
+{
+    uv_mutex_lock( &mutex );
+    entries.assign( lru.begin(), lru.end() );
+    uv_mutex_unlock( &mutex );
+
+    std::sort( entries.begin(), entries.end(), byTotalTime );
+    if( entries.size() > limit ) {
+	entries.resize( limit );
+    }
+}
+
+void statementRegistry::clear( void )
+/***********************************/
+{
+    uv_mutex_lock( &mutex );
+    lru.clear();
+    index.clear();
+    uv_mutex_unlock( &mutex );
+}
+
+statementRegistry &statementStats( void )
+/***************************************/
+{
+    static statementRegistry registry;
+    return registry;
+}
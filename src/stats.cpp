@@ -0,0 +1,163 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+#include "stats.h"
+
+static driverStats global_stats;
+
+static const char *stat_names[STAT_NUM_COUNTERS] = {
+    "executes",
+    "prepares",
+    "cacheHits",
+    "fetchCalls",
+    "rowsFetched",
+    "bytesFetchedString",
+    "bytesFetchedBinary",
+    "bytesFetchedInt",
+    "bytesFetchedDouble",
+    "rowsBound",
+    "bytesBound",
+    "peakResultBytes",
+    "requestsExpired"
+};
+
+driverStats &globalStats( void )
+/******************************/
+{
+    return global_stats;
+}
+
+const char *driverStats::name( statCounter which )
+/************************************************/
+{
+    return stat_names[which];
+}
+
+void driverStats::add( statCounter which, uint64_t n )
+/****************************************************/
+{
+    if( n == 0 ) {
+	return;
+    }
+    addLocal( which, n );
+    if( this != &global_stats ) {
+	global_stats.addLocal( which, n );
+    }
+}
+
+void driverStats::peakLocal( statCounter which, uint64_t n )
+/**********************************************************/
+{
+    uint64_t current = counters[which].load( std::memory_order_relaxed );
+    while( n > current &&
+	   !counters[which].compare_exchange_weak( current, n,
+						   std::memory_order_relaxed ) ) {
+    }
+}
+
+void driverStats::peak( statCounter which, uint64_t n )
+/*****************************************************/
+{
+    peakLocal( which, n );
+    if( this != &global_stats ) {
+	global_stats.peakLocal( which, n );
+    }
+}
+
+fetchCounter::~fetchCounter()
+/***************************/
+{
+    if( _stats == NULL ) {
+	return;
+    }
+    _stats->add( STAT_FETCH_CALLS, fetch_calls );
+    _stats->add( STAT_ROWS_FETCHED, rows );
+    _stats->add( STAT_BYTES_FETCHED_STRING, bytes_string );
+    _stats->add( STAT_BYTES_FETCHED_BINARY, bytes_binary );
+    _stats->add( STAT_BYTES_FETCHED_INT, bytes_int );
+    _stats->add( STAT_BYTES_FETCHED_DOUBLE, bytes_double );
+    _stats->peak( STAT_PEAK_RESULT_BYTES,
+		  bytes_string + bytes_binary + bytes_int + bytes_double );
+}
+
+static lockStats api_lock_stats( "api_mutex" );
+static lockStats conn_lock_stats( "conn_mutex" );
+static lockStats completion_lock_stats( "completion_mutex" );
+
+static const char *lock_counter_names[LOCK_NUM_COUNTERS] = {
+    "acquisitions",
+    "contended",
+    "waitMs",
+    "maxWaitMs",
+    "holdMs",
+    "maxHoldMs"
+};
+
+lockStats &apiLockStats( void )
+/*****************************/
+{
+    return api_lock_stats;
+}
+
+lockStats &connLockStats( void )
+/******************************/
+{
+    return conn_lock_stats;
+}
+
+lockStats &completionLockStats( void )
+/************************************/
+{
+    return completion_lock_stats;
+}
+
+const char *lockStats::counterName( lockCounter which )
+/*****************************************************/
+{
+    return lock_counter_names[which];
+}
+
+static void raisePeak( std::atomic<uint64_t> &peak, uint64_t n )
+/**************************************************************/
+{
+    uint64_t current = peak.load( std::memory_order_relaxed );
+    while( n > current &&
+	   !peak.compare_exchange_weak( current, n, std::memory_order_relaxed ) ) {
+    }
+}
+
+void lockStats::acquiredLocal( bool contended, uint64_t wait_ns )
+/***************************************************************/
+{
+    counters[LOCK_ACQUISITIONS].fetch_add( 1, std::memory_order_relaxed );
+    if( contended ) {
+	counters[LOCK_CONTENDED].fetch_add( 1, std::memory_order_relaxed );
+	counters[LOCK_WAIT_NS].fetch_add( wait_ns, std::memory_order_relaxed );
+	raisePeak( counters[LOCK_MAX_WAIT_NS], wait_ns );
+    }
+}
+
+void lockStats::releasedLocal( uint64_t hold_ns )
+/***********************************************/
+{
+    counters[LOCK_HOLD_NS].fetch_add( hold_ns, std::memory_order_relaxed );
+    raisePeak( counters[LOCK_MAX_HOLD_NS], hold_ns );
+}
+
+void lockStats::acquired( bool contended, uint64_t wait_ns )
+/**********************************************************/
+{
+    acquiredLocal( contended, wait_ns );
+    if( _total != NULL ) {
+	_total->acquiredLocal( contended, wait_ns );
+    }
+}
+
+void lockStats::released( uint64_t hold_ns )
+/******************************************/
+{
+    releasedLocal( hold_ns );
+    if( _total != NULL ) {
+	_total->releasedLocal( hold_ns );
+    }
+}
@@ -0,0 +1,201 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <mutex>
+#include "trace.h"
+
+// Events are collected here and written out when this much is buffered
+#define TRACE_FLUSH_BYTES	( 64 * 1024 )
+
+std::atomic<bool>	trace_enabled( false );
+
+static std::mutex	trace_mutex;
+static FILE *		trace_file = NULL;
+static std::string	trace_buffer;
+static bool		trace_first_event = true;
+// Bumped for each new trace, so that threads name themselves again
+static unsigned		trace_generation = 0;
+static bool		trace_atexit = false;
+static std::atomic<unsigned>	next_tid( 1 );
+static const std::chrono::steady_clock::time_point trace_epoch =
+    std::chrono::steady_clock::now();
+
+struct traceThread {
+    unsigned	tid;
+    unsigned	named_generation;
+    unsigned	conn;
+    const char *name;
+};
+
+static thread_local traceThread this_thread = { 0, 0, 0, NULL };
+
+uint64_t traceNow( void )
+/***********************/
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+	std::chrono::steady_clock::now() - trace_epoch ).count() + 1;
+}
+
+void traceSetConnection( unsigned conn )
+/**************************************/
+{
+    this_thread.conn = conn;
+}
+
+// Returns the calling thread's track, assigning one on first use
+static unsigned threadId( void )
+/******************************/
+{
+    if( this_thread.tid == 0 ) {
+	this_thread.tid = next_tid.fetch_add( 1 );
+    }
+    return this_thread.tid;
+}
+
+static void flushLocked( void )
+/*****************************/
+{
+    if( trace_file != NULL && !trace_buffer.empty() ) {
+	fwrite( trace_buffer.data(), 1, trace_buffer.length(), trace_file );
+	fflush( trace_file );
+    }
+    trace_buffer.clear();
+}
+
+static void appendEvent( const char *event )
+/******************************************/
+{
+    if( !trace_first_event ) {
+	trace_buffer += ",\n";
+    }
+    trace_first_event = false;
+    trace_buffer += event;
+}
+
+// Writes the thread_name metadata event for the calling thread, once per
+// trace. trace_mutex must be held.
+static void nameThreadLocked( void )
+/**********************************/
+{
+    threadId();
+    if( this_thread.named_generation == trace_generation ) {
+	return;
+    }
+    this_thread.named_generation = trace_generation;
+
+    char event[160];
+    if( this_thread.name != NULL ) {
+	snprintf( event, sizeof( event ),
+		  "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+		  "\"args\":{\"name\":\"%s\"}}",
+		  this_thread.tid, this_thread.name );
+    } else {
+	snprintf( event, sizeof( event ),
+		  "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+		  "\"args\":{\"name\":\"worker %u\"}}",
+		  this_thread.tid, this_thread.tid );
+    }
+    appendEvent( event );
+}
+
+static void recordEvent( const char *event )
+/******************************************/
+{
+    std::lock_guard<std::mutex> lock( trace_mutex );
+    if( trace_file == NULL ) {
+	return;
+    }
+    nameThreadLocked();
+    appendEvent( event );
+    if( trace_buffer.length() >= TRACE_FLUSH_BYTES ) {
+	flushLocked();
+    }
+}
+
+static void stopLocked( void )
+/****************************/
+{
+    if( trace_file == NULL ) {
+	return;
+    }
+    trace_enabled.store( false );
+    trace_buffer += "\n]\n";
+    flushLocked();
+    fclose( trace_file );
+    trace_file = NULL;
+}
+
+static void stopAtExit( void )
+/****************************/
+{
+    traceStop();
+}
+
+bool traceStart( const std::string &file )
+/****************************************/
+{
+    std::lock_guard<std::mutex> lock( trace_mutex );
+    stopLocked();
+
+    trace_file = fopen( file.c_str(), "w" );
+    if( trace_file == NULL ) {
+	return false;
+    }
+    if( !trace_atexit ) {
+	// A trace still open at exit is completed, so that it can be loaded
+	atexit( stopAtExit );
+	trace_atexit = true;
+    }
+    trace_generation++;
+    trace_first_event = true;
+    trace_buffer = "[\n";
+    this_thread.name = "main";
+    nameThreadLocked();
+    trace_enabled.store( true );
+    return true;
+}
+
+void traceStop( void )
+/********************/
+{
+    std::lock_guard<std::mutex> lock( trace_mutex );
+    stopLocked();
+}
+
+void traceComplete( const char *name, const char *category,
+		    uint64_t start_us, uint64_t end_us )
+/*************************************************************/
+{
+    char event[256];
+    if( this_thread.conn != 0 ) {
+	snprintf( event, sizeof( event ),
+		  "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu,"
+		  "\"dur\":%llu,\"pid\":1,\"tid\":%u,\"args\":{\"conn\":%u}}",
+		  name, category, (unsigned long long)start_us,
+		  (unsigned long long)( end_us - start_us ),
+		  threadId(), this_thread.conn );
+    } else {
+	snprintf( event, sizeof( event ),
+		  "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu,"
+		  "\"dur\":%llu,\"pid\":1,\"tid\":%u}",
+		  name, category, (unsigned long long)start_us,
+		  (unsigned long long)( end_us - start_us ), threadId() );
+    }
+    recordEvent( event );
+}
+
+void traceAsync( const char *name, const char *category, bool begin,
+		 const void *id, uint64_t ts_us )
+/******************************************************************/
+{
+    char event[256];
+    snprintf( event, sizeof( event ),
+	      "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\",\"id\":\"%p\","
+	      "\"ts\":%llu,\"pid\":1,\"tid\":%u}",
+	      name, category, begin ? "b" : "e", id,
+	      (unsigned long long)ts_us, threadId() );
+    recordEvent( event );
+}
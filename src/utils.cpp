@@ -1,6 +1,7 @@
 // ***************************************************************************
 // Copyright (c) 2019 SAP SE or an SAP affiliate company. All rights reserved.
 // ***************************************************************************
+#include <cmath>
 #include "nodever_cover.h"
 #include "sqlany_utils.h"
 #include "nan.h"
@@ -54,6 +55,12 @@ void getErrorMsg( int code, std::string &str )
 	case JS_ERR_NO_WIDE_STATEMENTS:
 	    message << "The DBCAPI library must be upgraded to support wide statements";
 	    break;
+	case JS_ERR_RESULT_TOO_LARGE:
+	    message << "Result set exceeds the maxRows or maxResultBytes limit";
+	    break;
+	case JS_ERR_DEADLINE_EXCEEDED:
+	    message << "Request deadline passed before the statement was executed";
+	    break;
 	default:
 	    message << "Unknown Error";
     }
@@ -195,12 +202,608 @@ void callBack( std::string *		str,
 	
     } else {
 	if( str != NULL ) {
-	    isolate->ThrowException( 
+	    isolate->ThrowException(
 		Exception::Error( String::NewFromUtf8( isolate, str->c_str() ) ) );
 	}
     }
 }
 
+Local<Value> newPromise( Isolate *				isolate,
+			 Persistent<Promise::Resolver> &	resolver )
+/*****************************************************************/
+{
+    EscapableHandleScope scope( isolate );
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<Promise::Resolver> local_resolver =
+	Promise::Resolver::New( context ).ToLocalChecked();
+    resolver.Reset( isolate, local_resolver );
+    return scope.Escape( local_resolver->GetPromise() );
+}
+
+void settlePromise( std::string *			str,
+		    Persistent<Promise::Resolver> &	resolver,
+		    Local<Value> &			Result )
+/************************************************************/
+{
+    Isolate *isolate = Isolate::GetCurrent();
+    HandleScope scope( isolate );
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<Promise::Resolver> local_resolver =
+	Local<Promise::Resolver>::New( isolate, resolver );
+
+    // If string is NULL, then there is no error
+    if( str == NULL ) {
+	local_resolver->Resolve( context, Result ).FromJust();
+    } else {
+	Local<Value> Err = Exception::Error(
+	    String::NewFromUtf8( isolate, str->c_str(),
+				 NewStringType::kNormal ).ToLocalChecked() );
+	local_resolver->Reject( context, Err ).FromJust();
+    }
+}
+
+void callBack( std::string *			str,
+	       Persistent<Function> &		callback,
+	       Persistent<Promise::Resolver> &	resolver,
+	       Local<Value> &			Result,
+	       bool				callback_required )
+/*****************************************************************/
+{
+    if( resolver.IsEmpty() ) {
+	callBack( str, callback, Result, callback_required );
+	return;
+    }
+
+    // The *After functions run from drainCompletions, inside a callback
+    // scope in the request's async context. The reactions queued by
+    // settling the promise run when that scope drains the microtask queue.
+    settlePromise( str, resolver, Result );
+}
+
+void callBack( std::string *			str,
+	       Persistent<Function> &		callback,
+	       Persistent<Promise::Resolver> &	resolver,
+	       Persistent<Value> &		Result,
+	       bool				callback_required )
+/*****************************************************************/
+{
+    Isolate *isolate = Isolate::GetCurrent();
+    HandleScope scope( isolate );
+    Local<Value> local_result = Local<Value>::New( isolate, Result );
+
+    callBack( str, callback, resolver, local_result, callback_required );
+}
+
+void returnError( const FunctionCallbackInfo<Value> &	args,
+		  std::string &				error_msg,
+		  int					cbfunc_arg,
+		  bool					callback_required,
+		  bool					promise_required )
+/******************************************************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    HandleScope scope( isolate );
+    Local<Value> undef = Local<Value>::New( isolate, Undefined( isolate ) );
+
+    if( promise_required ) {
+	Persistent<Promise::Resolver> resolver;
+	Local<Value> promise = newPromise( isolate, resolver );
+	settlePromise( &error_msg, resolver, undef );
+	resolver.Reset();
+	args.GetReturnValue().Set( promise );
+	return;
+    }
+    callBack( &error_msg, args[cbfunc_arg], undef, callback_required );
+    args.GetReturnValue().SetUndefined();
+}
+
+bool getOption( Isolate *		isolate,
+		Local<Object>		options,
+		const char *		name,
+		Local<Value> &		value )
+/***********************************************/
+{
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<String> key =
+	String::NewFromUtf8( isolate, name, NewStringType::kNormal ).ToLocalChecked();
+    if( !options->Get( context, key ).ToLocal( &value ) ) {
+	return false;
+    }
+    return !value->IsUndefined();
+}
+
+bool getBoolOption( Isolate *		isolate,
+		    Local<Object>	options,
+		    const char *	name,
+		    bool &		value )
+/**********************************************/
+{
+    Local<Value> val;
+    if( !getOption( isolate, options, name, val ) ) {
+	return false;
+    }
+#if NODE_MAJOR_VERSION >= 12
+    value = val->BooleanValue( isolate );
+#else
+    value = val->BooleanValue( isolate->GetCurrentContext() ).FromJust();
+#endif
+    return true;
+}
+
+bool getNumberOption( Isolate *		isolate,
+		      Local<Object>	options,
+		      const char *	name,
+		      double &		value )
+/************************************************/
+{
+    Local<Value> val;
+    if( !getOption( isolate, options, name, val ) || !val->IsNumber() ) {
+	return false;
+    }
+    value = val->NumberValue( isolate->GetCurrentContext() ).FromJust();
+    return true;
+}
+
+static void getPhases( queryTiming &timing, uint64_t *phases )
+/************************************************************/
+{
+    // Marks that were not reached (for example when the statement was
+    // already prepared, or on error) take the time of the previous one.
+    for( int i = 1; i < TIMING_NUM_MARKS; i++ ) {
+	if( timing.marks[i] < timing.marks[i - 1] ) {
+	    timing.marks[i] = timing.marks[i - 1];
+	}
+    }
+    for( int i = 0; i < TIMING_NUM_PHASES; i++ ) {
+	phases[i] = timing.marks[i + 1] - timing.marks[i];
+    }
+}
+
+void addTiming( queryTimings &timings, queryTiming &timing )
+/**********************************************************/
+{
+    getPhases( timing, timings.last );
+    for( int i = 0; i < TIMING_NUM_PHASES; i++ ) {
+	timings.total[i] += timings.last[i];
+    }
+    timings.count++;
+}
+
+static const char *timing_phase_names[TIMING_NUM_PHASES] = {
+    "queueWait",	// enqueued -> worker started
+    "lockWait",		// worker started -> conn_mutex acquired
+    "prepare",
+    "bind",
+    "execute",
+    "fetch",
+    "deliver",		// fetch complete -> back on the main thread
+    "materialize",	// getResultSet
+    "callback"
+};
+
+static Local<Object> phasesObject( Isolate *isolate, uint64_t *phases )
+/*******************************************************************/
+{
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<Object> obj = Object::New( isolate );
+    for( int i = 0; i < TIMING_NUM_PHASES; i++ ) {
+	// reported in milliseconds
+	obj->Set( context,
+		  String::NewFromUtf8( isolate, timing_phase_names[i],
+				       NewStringType::kNormal ).ToLocalChecked(),
+		  Number::New( isolate, (double)phases[i] / 1e6 ) ).FromJust();
+    }
+    return obj;
+}
+
+Local<Object> timingsObject( Isolate *isolate, queryTimings &timings )
+/********************************************************************/
+{
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<Object> obj = Object::New( isolate );
+    obj->Set( context,
+	      String::NewFromUtf8( isolate, "count",
+				   NewStringType::kNormal ).ToLocalChecked(),
+	      Number::New( isolate, timings.count ) ).FromJust();
+    obj->Set( context,
+	      String::NewFromUtf8( isolate, "last",
+				   NewStringType::kNormal ).ToLocalChecked(),
+	      phasesObject( isolate, timings.last ) ).FromJust();
+    obj->Set( context,
+	      String::NewFromUtf8( isolate, "total",
+				   NewStringType::kNormal ).ToLocalChecked(),
+	      phasesObject( isolate, timings.total ) ).FromJust();
+    return obj;
+}
+
+Local<Object> timingObject( Isolate *isolate, queryTiming &timing )
+/****************************************************************/
+{
+    uint64_t phases[TIMING_NUM_PHASES];
+    getPhases( timing, phases );
+    return phasesObject( isolate, phases );
+}
+
+Local<Object> statsObject( Isolate *isolate, driverStats &stats )
+/**************************************************************/
+{
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<Object> obj = Object::New( isolate );
+    for( int i = 0; i < STAT_NUM_COUNTERS; i++ ) {
+	statCounter which = (statCounter)i;
+	obj->Set( context,
+		  String::NewFromUtf8( isolate, driverStats::name( which ),
+				       NewStringType::kNormal ).ToLocalChecked(),
+		  Number::New( isolate, (double)stats.get( which ) ) ).FromJust();
+    }
+    return obj;
+}
+
+NODE_API_FUNC( getGlobalStats )
+/*****************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    HandleScope scope( isolate );
+    args.GetReturnValue().Set( statsObject( isolate, globalStats() ) );
+}
+
+Local<Object> lockStatsObject( Isolate *isolate, lockStats &stats )
+/****************************************************************/
+{
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<Object> obj = Object::New( isolate );
+    for( int i = 0; i < LOCK_NUM_COUNTERS; i++ ) {
+	lockCounter which = (lockCounter)i;
+	double value = (double)stats.get( which );
+	if( which != LOCK_ACQUISITIONS && which != LOCK_CONTENDED ) {
+	    value /= 1e6;
+	}
+	obj->Set( context,
+		  String::NewFromUtf8( isolate, lockStats::counterName( which ),
+				       NewStringType::kNormal ).ToLocalChecked(),
+		  Number::New( isolate, value ) ).FromJust();
+    }
+    return obj;
+}
+
+NODE_API_FUNC( getLockStats )
+/***************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    Local<Context> context = isolate->GetCurrentContext();
+    HandleScope scope( isolate );
+    lockStats *locks[] = {
+	&apiLockStats(), &connLockStats(), &completionLockStats()
+    };
+    Local<Object> obj = Object::New( isolate );
+    for( size_t i = 0; i < sizeof( locks ) / sizeof( locks[0] ); i++ ) {
+	obj->Set( context,
+		  String::NewFromUtf8( isolate, locks[i]->name,
+				       NewStringType::kNormal ).ToLocalChecked(),
+		  lockStatsObject( isolate, *locks[i] ) ).FromJust();
+    }
+    args.GetReturnValue().Set( obj );
+}
+
+NODE_API_FUNC( startTrace )
+/*************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    HandleScope scope( isolate );
+
+    if( args.Length() != 1 || !args[0]->IsString() ) {
+	throwError( JS_ERR_INVALID_ARGUMENTS );
+	args.GetReturnValue().SetUndefined();
+	return;
+    }
+#if NODE_MAJOR_VERSION >= 12
+    String::Utf8Value file( isolate, args[0] );
+#else
+    String::Utf8Value file( args[0] );
+#endif
+    args.GetReturnValue().Set( Boolean::New( isolate,
+					     traceStart( std::string( *file ) ) ) );
+}
+
+NODE_API_FUNC( stopTrace )
+/************************/
+{
+    traceStop();
+    args.GetReturnValue().SetUndefined();
+}
+
+// External memory
+// Result rows, bind buffers and prepared statements hold native memory that
+// V8 cannot see. Reporting it lets the garbage collector run sooner when a
+// program holds many of them, instead of only when the JavaScript heap fills.
+// Both functions must be called on the main thread.
+void chargeExternalMemory( int64_t &charged, int64_t bytes )
+/**********************************************************/
+{
+    if( bytes <= 0 ) {
+	return;
+    }
+    Isolate *isolate = Isolate::GetCurrent();
+    if( isolate == NULL ) {
+	return;
+    }
+    isolate->AdjustAmountOfExternalAllocatedMemory( bytes );
+    charged += bytes;
+}
+
+void releaseExternalMemory( int64_t &charged )
+/********************************************/
+{
+    if( charged == 0 ) {
+	return;
+    }
+    Isolate *isolate = Isolate::GetCurrent();
+    if( isolate != NULL ) {
+	isolate->AdjustAmountOfExternalAllocatedMemory( -charged );
+    }
+    charged = 0;
+}
+
+static Local<Object> histogramObject( Isolate *isolate,
+				      const latencyHistogram &histogram )
+/*****************************************************************/
+{
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<Object> obj = Object::New( isolate );
+    // reported in milliseconds
+    obj->Set( context,
+	      String::NewFromUtf8( isolate, "p50",
+				   NewStringType::kNormal ).ToLocalChecked(),
+	      Number::New( isolate, (double)histogram.percentile( 0.5 ) / 1e3 ) ).FromJust();
+    obj->Set( context,
+	      String::NewFromUtf8( isolate, "p99",
+				   NewStringType::kNormal ).ToLocalChecked(),
+	      Number::New( isolate, (double)histogram.percentile( 0.99 ) / 1e3 ) ).FromJust();
+    obj->Set( context,
+	      String::NewFromUtf8( isolate, "max",
+				   NewStringType::kNormal ).ToLocalChecked(),
+	      Number::New( isolate, (double)histogram.maximum() / 1e3 ) ).FromJust();
+    return obj;
+}
+
+NODE_API_FUNC( getTopStatements )
+/*******************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    Local<Context> context = isolate->GetCurrentContext();
+    HandleScope scope( isolate );
+    static const char *phase_names[PHASE_NUM_PHASES] = {
+	"prepare", "execute", "fetch"
+    };
+    size_t limit = 10;
+
+    if( args.Length() == 1 && args[0]->IsNumber() ) {
+	double value = args[0]->NumberValue( context ).FromJust();
+	// NaN fails the comparison, and Infinity is not a count
+	if( !( value >= 1 ) || std::isinf( value ) ) {
+	    throwError( JS_ERR_INVALID_ARGUMENTS );
+	    args.GetReturnValue().SetUndefined();
+	    return;
+	}
+	limit = value < (double)UINT32_MAX ? (size_t)value : UINT32_MAX;
+    } else if( args.Length() != 0 ) {
+	throwError( JS_ERR_INVALID_ARGUMENTS );
+	args.GetReturnValue().SetUndefined();
+	return;
+    }
+
+    std::vector<statementEntry> entries;
+    statementStats().top( limit, entries );
+
+    Local<Array> result = Array::New( isolate, (int)entries.size() );
+    for( size_t i = 0; i < entries.size(); i++ ) {
+	statementEntry &entry = entries[i];
+	Local<Object> obj = Object::New( isolate );
+	obj->Set( context,
+		  String::NewFromUtf8( isolate, "sql",
+				       NewStringType::kNormal ).ToLocalChecked(),
+		  String::NewFromUtf8( isolate, entry.fingerprint.c_str(),
+				       NewStringType::kNormal ).ToLocalChecked() ).FromJust();
+	obj->Set( context,
+		  String::NewFromUtf8( isolate, "calls",
+				       NewStringType::kNormal ).ToLocalChecked(),
+		  Number::New( isolate, (double)entry.calls ) ).FromJust();
+	obj->Set( context,
+		  String::NewFromUtf8( isolate, "errors",
+				       NewStringType::kNormal ).ToLocalChecked(),
+		  Number::New( isolate, (double)entry.errors ) ).FromJust();
+	obj->Set( context,
+		  String::NewFromUtf8( isolate, "totalTime",
+				       NewStringType::kNormal ).ToLocalChecked(),
+		  Number::New( isolate, (double)entry.total_ns / 1e6 ) ).FromJust();
+	for( int p = 0; p < PHASE_NUM_PHASES; p++ ) {
+	    obj->Set( context,
+		      String::NewFromUtf8( isolate, phase_names[p],
+					   NewStringType::kNormal ).ToLocalChecked(),
+		      histogramObject( isolate, entry.phases[p] ) ).FromJust();
+	}
+	result->Set( context, (uint32_t)i, obj ).FromJust();
+    }
+    args.GetReturnValue().Set( result );
+}
+
+// Diagnostics channels
+// lib/index.js hands us the diagnostics_channel channels on runtimes that
+// have them. Nothing is published, and no event data is gathered, while
+// nobody subscribes to them.
+
+enum { DIAG_START, DIAG_END, DIAG_ERROR, DIAG_NUM_CHANNELS };
+static Persistent<Object>	diag_channels[DIAG_NUM_CHANNELS];
+
+NODE_API_FUNC( setDiagnosticsChannels )
+/*************************************/
+{
+    Isolate *isolate = args.GetIsolate();
+    HandleScope scope( isolate );
+
+    if( args.Length() != DIAG_NUM_CHANNELS ) {
+	throwError( JS_ERR_INVALID_ARGUMENTS );
+	args.GetReturnValue().SetUndefined();
+	return;
+    }
+    for( int i = 0; i < DIAG_NUM_CHANNELS; i++ ) {
+	if( !args[i]->IsObject() ) {
+	    throwError( JS_ERR_INVALID_ARGUMENTS );
+	    args.GetReturnValue().SetUndefined();
+	    return;
+	}
+    }
+    for( int i = 0; i < DIAG_NUM_CHANNELS; i++ ) {
+	diag_channels[i].Reset( isolate, Local<Object>::Cast( args[i] ) );
+    }
+    args.GetReturnValue().SetUndefined();
+}
+
+static bool diagSubscribed( Isolate *isolate )
+/********************************************/
+{
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<String> key = String::NewFromUtf8( isolate, "hasSubscribers",
+					     NewStringType::kInternalized ).ToLocalChecked();
+    for( int i = 0; i < DIAG_NUM_CHANNELS; i++ ) {
+	Local<Object> channel = Local<Object>::New( isolate, diag_channels[i] );
+	Local<Value> subscribed;
+	if( channel->Get( context, key ).ToLocal( &subscribed ) &&
+	    subscribed->IsTrue() ) {
+	    return true;
+	}
+    }
+    return false;
+}
+
+static void diagPublish( Isolate *isolate, int which, Local<Object> message )
+/***************************************************************************/
+{
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<Object> channel = Local<Object>::New( isolate, diag_channels[which] );
+    Local<Value> publish;
+    if( !channel->Get( context,
+		       String::NewFromUtf8( isolate, "publish",
+					    NewStringType::kInternalized ).ToLocalChecked() )
+		 .ToLocal( &publish ) || !publish->IsFunction() ) {
+	return;
+    }
+    Local<Value> argv[1] = { message };
+    // diagnostics_channel reports exceptions thrown by subscribers itself
+    Local<Function>::Cast( publish )->Call( context, channel, 1, argv ).IsEmpty();
+}
+
+static void setProperty( Isolate *isolate, Local<Object> obj, const char *name,
+			 Local<Value> value )
+/******************************************************************************/
+{
+    obj->Set( isolate->GetCurrentContext(),
+	      String::NewFromUtf8( isolate, name,
+				   NewStringType::kInternalized ).ToLocalChecked(),
+	      value ).FromJust();
+}
+
+// Returns the leading keyword of a SQL statement, such as SELECT or CALL
+static std::string sqlCommand( const std::string &sql )
+/*****************************************************/
+{
+    size_t i = 0;
+    while( i < sql.length() && ( isspace( (unsigned char)sql[i] ) || sql[i] == '(' ) ) {
+	i++;
+    }
+    std::string command;
+    while( i < sql.length() && isalpha( (unsigned char)sql[i] ) ) {
+	command += (char)toupper( (unsigned char)sql[i] );
+	i++;
+    }
+    return command;
+}
+
+static void diagDescribe( Isolate *isolate, diagEvent &event,
+			  Local<Object> message )
+/***********************************************************/
+{
+    setProperty( isolate, message, "kind",
+		 String::NewFromUtf8( isolate, event.kind,
+				      NewStringType::kNormal ).ToLocalChecked() );
+    if( event.sql.length() > 0 ) {
+	setProperty( isolate, message, "sql",
+		     String::NewFromUtf8( isolate, event.sql.c_str(),
+					  NewStringType::kNormal ).ToLocalChecked() );
+	setProperty( isolate, message, "command",
+		     String::NewFromUtf8( isolate, sqlCommand( event.sql ).c_str(),
+					  NewStringType::kNormal ).ToLocalChecked() );
+    }
+    if( event.num_statements > 0 ) {
+	setProperty( isolate, message, "statements",
+		     Number::New( isolate, (double)event.num_statements ) );
+    }
+    setProperty( isolate, message, "params",
+		 Number::New( isolate, (double)event.num_params ) );
+}
+
+void diagStart( diagEvent &	event,
+		const char *	kind,
+		const std::string &sql,
+		size_t		num_params )
+/******************************************/
+{
+    if( diag_channels[DIAG_START].IsEmpty() ) {
+	return;
+    }
+    Isolate *isolate = Isolate::GetCurrent();
+    HandleScope scope( isolate );
+    if( !diagSubscribed( isolate ) ) {
+	return;
+    }
+
+    event.active = true;
+    event.kind = kind;
+    event.sql = sql;
+    event.num_params = num_params;
+    event.start = uv_hrtime();
+
+    Local<Object> message = Object::New( isolate );
+    diagDescribe( isolate, event, message );
+    diagPublish( isolate, DIAG_START, message );
+}
+
+void diagEnd( diagEvent &	event,
+	      std::string *	error_msg,
+	      Local<Object>	details )
+/***************************************/
+{
+    if( !event.active ) {
+	return;
+    }
+    event.active = false;
+
+    Isolate *isolate = Isolate::GetCurrent();
+    HandleScope scope( isolate );
+    diagDescribe( isolate, event, details );
+    // reported in milliseconds
+    setProperty( isolate, details, "duration",
+		 Number::New( isolate, (double)( uv_hrtime() - event.start ) / 1e6 ) );
+    if( error_msg != NULL ) {
+	setProperty( isolate, details, "error",
+		     Exception::Error( String::NewFromUtf8( isolate, error_msg->c_str(),
+							    NewStringType::kNormal ).ToLocalChecked() ) );
+	diagPublish( isolate, DIAG_ERROR, details );
+    }
+    diagPublish( isolate, DIAG_END, details );
+}
+
+void diagEnd( diagEvent &event, std::string *error_msg )
+/******************************************************/
+{
+    if( !event.active ) {
+	return;
+    }
+    Isolate *isolate = Isolate::GetCurrent();
+    HandleScope scope( isolate );
+    diagEnd( event, error_msg, Object::New( isolate ) );
+}
+
 static bool getWideBindParameters( std::vector<ExecuteData *>		&execData,
                                    Isolate *            isolate,
                                    Local<Value>         arg,
@@ -247,50 +850,29 @@ static bool getWideBindParameters( std::vector<ExecuteData *>		&execData,
     }
 
     for( c = 0; c < num_cols; c++ ) {
-	a_sqlany_bind_param 	param;
-	memset( &param, 0, sizeof( param ) );
+	a_sqlany_data_type	type;
 
 	ExecuteData *ex = new ExecuteData;
 	execData.push_back( ex );
 
-	double *	param_double = new double[num_rows];
-	ex->addNum( param_double );
-	char **		char_arr = new char *[num_rows];
-	size_t *	len = new size_t[num_rows];
-	ex->addStrings( char_arr, len );
-	sacapi_bool *	is_null = new sacapi_bool[num_rows];
-	ex->addNull( is_null );
-	param.value.is_null	= is_null;
-	param.value.is_address	= false;
-
 	if( row0->Get(c)->IsInt32() || row0->Get(c)->IsNumber() ) {
-	    param.value.type	= A_DOUBLE;
-	    param.value.buffer	= (char *)( param_double );
-
+	    type = A_DOUBLE;
 	} else if( row0->Get(c)->IsString() ) {
-	    param.value.type	= A_STRING;
-	    param.value.buffer	= (char *)char_arr;
-	    param.value.length	= len;
-	    param.value.is_address = true;
-
+	    type = A_STRING;
 	} else if( Buffer::HasInstance( row0->Get(c) ) ) {
-	    param.value.type	= A_BINARY;
-	    param.value.buffer	= (char *)char_arr;
-	    param.value.length	= len;
-	    param.value.is_address = true;
-	    
+	    type = A_BINARY;
 	} else if( row0->Get(c)->IsNull() ) {
-
+	    type = A_INVALID_TYPE;
 	} else{
 	    return false;
 	}
+	wideColumn col = addWideColumn( ex, params, type, num_rows );
 
 	for( unsigned int r = 0; r < num_rows; r++ ) {
             Local<Array>    bind_params = Local<Array>::Cast( rows->Get(r) );
 	
-	    is_null[r] = false;
 	    if( bind_params->Get(c)->IsInt32() || bind_params->Get(c)->IsNumber() ) {
-                param_double[r] = bind_params->Get(c)->NumberValue(context).FromJust();
+                setWideDouble( col, r, bind_params->Get(c)->NumberValue(context).FromJust() );
 	
             } else if( bind_params->Get(c)->IsString() ) {
 #if NODE_MAJOR_VERSION >= 12
@@ -298,24 +880,16 @@ static bool getWideBindParameters( std::vector<ExecuteData *>		&execData,
 #else
                 String::Utf8Value paramValue( (bind_params->Get(c)->ToString(context)).ToLocalChecked() );
 #endif
-		const char* param_string = (*paramValue);
-		len[r] = (size_t)paramValue.length();
-		char *param_char = new char[len[r] + 1];
-		char_arr[r] = param_char;
-		memcpy( param_char, param_string, len[r] + 1 );
+		setWideBytes( col, r, *paramValue, (size_t)paramValue.length(), true );
 		
 	    } else if( Buffer::HasInstance( bind_params->Get(c) ) ) {
-		len[r] = Buffer::Length( bind_params->Get(c) );
-		char *param_char = new char[len[r]];
-		char_arr[r] = param_char;
-		memcpy( param_char, Buffer::Data( bind_params->Get(c) ), len[r] );
+		setWideBytes( col, r, Buffer::Data( bind_params->Get(c) ),
+			      Buffer::Length( bind_params->Get(c) ), false );
 
-	    } else if( bind_params->Get(c)->IsNull() ) {
-		is_null[r] = true;
+	    } else {
+		setWideNull( col, r );
 	    }
         }
-
-	params.push_back( param );
     }
 
     return true;	   
@@ -347,22 +921,11 @@ bool getBindParameters( std::vector<ExecuteData *>		&execData,
     execData.push_back( ex );
 
     for( unsigned int i = 0; i < bind_params->Length(); i++ ) {
-	a_sqlany_bind_param 	param;
-	memset( &param, 0, sizeof( param ) );
-
 	if( bind_params->Get(i)->IsInt32() ) {
-	    int *param_int = new int;
-            *param_int = bind_params->Get(i)->Int32Value(context).FromJust();
-	    ex->addInt( param_int );
-	    param.value.buffer = (char *)( param_int );
-	    param.value.type   = A_VAL32;
+            bindInt( ex, params, bind_params->Get(i)->Int32Value(context).FromJust() );
 	    
 	} else if( bind_params->Get(i)->IsNumber() ) {
-	    double *param_double = new double;
-            *param_double = bind_params->Get(i)->NumberValue(context).FromJust(); // Remove Round off Error
-	    ex->addNum( param_double );
-	    param.value.buffer = (char *)( param_double );
-	    param.value.type   = A_DOUBLE;
+            bindDouble( ex, params, bind_params->Get(i)->NumberValue(context).FromJust() ); // Remove Round off Error
 	
 	} else if( bind_params->Get(i)->IsString() ) {
 #if NODE_MAJOR_VERSION >= 12
@@ -370,49 +933,18 @@ bool getBindParameters( std::vector<ExecuteData *>		&execData,
 #else
             String::Utf8Value paramValue( (bind_params->Get(i)->ToString(context)).ToLocalChecked() );
 #endif
-            const char* param_string = (*paramValue);
-	    size_t *len = new size_t;
-	    *len = (size_t)paramValue.length();
-	    
-	    char **char_arr = new char *;
-	    char *param_char = new char[*len + 1];
-	    *char_arr = param_char;
-
-	    memcpy( param_char, param_string, ( *len ) + 1 );
-	    ex->addStrings( char_arr, len );
-	    
-	    param.value.type = A_STRING;
-	    param.value.buffer = param_char;
-	    param.value.length = len;
-	    param.value.buffer_size = *len + 1;
+	    bindBytes( ex, params, A_STRING, *paramValue, (size_t)paramValue.length() );
 	    
 	} else if( Buffer::HasInstance( bind_params->Get(i) ) ) {
-	    size_t *len = new size_t;
-	    *len = Buffer::Length( bind_params->Get(i) );
-	    char **char_arr = new char *;
-	    char *param_char = new char[*len];
-	    *char_arr = param_char;
-	    
-	    memcpy( param_char, Buffer::Data( bind_params->Get(i) ), *len );
-	    ex->addStrings( char_arr, len );
-	    
-	    param.value.type = A_BINARY;
-	    param.value.buffer = param_char;
-	    param.value.length = len;
-	    param.value.buffer_size = sizeof( param_char );
+	    bindBytes( ex, params, A_BINARY, Buffer::Data( bind_params->Get(i) ),
+		       Buffer::Length( bind_params->Get(i) ) );
 	    
 	} else if( bind_params->Get(i)->IsNull() ) {
-	    param.value.type = A_STRING;
-	    sacapi_bool *is_null = new sacapi_bool;
-	    param.value.is_null = is_null;
-	    ex->addNull( is_null );
-	    is_null[0] = true;
+	    bindNull( ex, params );
 	    
 	} else{
 	    return false;
 	}
-	    
-	params.push_back( param );
     }
 
     return true;	   
@@ -425,6 +957,7 @@ bool getResultSet( Persistent<Value> &			Result,
 		   std::vector<a_sqlany_data_type> &	col_types )
 /*****************************************************************/
 {
+    traceSpan span( "getResultSet", "main" );
     Isolate *isolate = Isolate::GetCurrent();
     HandleScope scope( isolate );
     int 	num_rows = 0;
@@ -544,181 +1077,219 @@ bool getResultSet( Persistent<Value> &			Result,
     return true;
 }
 
-bool fetchResultSet( a_sqlany_stmt *			sqlany_stmt,
-		     int &				rows_affected,
-		     std::vector<char *> &		colNames,
-		     ExecuteData *			execData,
-		     std::vector<a_sqlany_data_type> &	col_types )
-/*****************************************************************/
+// The API is initialized by the first connection and finalized when the
+// last one goes away. api_mutex is held only while the count changes, so
+// connections can be opened and closed in parallel.
+static unsigned api_max_ver = 0;
+
+bool acquireAPI( unsigned int &max_api_ver )
+/******************************************/
 {
-    
-    a_sqlany_data_value		value;
-    int				num_cols = 0;
-    
-    rows_affected = api.sqlany_affected_rows( sqlany_stmt );
-    num_cols = api.sqlany_num_cols( sqlany_stmt );
-    
-    
-    if( rows_affected > 0 && num_cols < 1 ) {
-        return true;
-    }
-    
-    rows_affected = -1;
-    if( num_cols > 0 ) {
-	
-	for( int i = 0; i < num_cols; i++ ) {
-	    a_sqlany_column_info info;
-	    api.sqlany_get_column_info( sqlany_stmt, i, &info );
-	    size_t size = strlen( info.name ) + 1;
-	    char *name = new char[ size ];
-	    memcpy( name, info.name, size );
-	    colNames.push_back( name );
-	}
-	
-	int count_string = 0, count_num = 0, count_int = 0;
-	while( true ) {
+    scoped_lock api_lock( api_mutex, apiLockStats() );
 
-	    if( !api.sqlany_fetch_next( sqlany_stmt ) ) {
+    if( openConnections == 0 ) {
+	if( !sqlany_initialize_interface( &api, NULL ) ) {
+	    return false;
+	}
+	if( !api.sqlany_init( "Node.js", SQLANY_API_VERSION_4, &api_max_ver ) ) {
+	    // As long as the version is >= 2, we're OK. We just have to disable
+	    // wide inserts
+	    if( api_max_ver < SQLANY_API_VERSION_2 ||
+		!api.sqlany_init( "Node.js", api_max_ver, &api_max_ver ) ) {
+		sqlany_finalize_interface( &api );
 		return false;
 	    }
+	}
+    }
+    openConnections++;
+    max_api_ver = api_max_ver;
+    return true;
+}
 
-	    for( int i = 0; i < num_cols; i++ ) {
+void releaseAPI()
+/***************/
+{
+    scoped_lock api_lock( api_mutex, apiLockStats() );
 
-		if( !api.sqlany_get_column( sqlany_stmt, i, &value ) ) {
-		    return false;
-		}
-	
-		if( *(value.is_null) ) {
-		    col_types.push_back( A_INVALID_TYPE );
-		    continue;
-		}
-		
-		switch( value.type ) {
-		    case A_BINARY:
-		    {
-			size_t *size = new size_t;
-			*size = *(value.length);
-			char *val = new char[ *size ];
-			memcpy( val, value.buffer, *size );
-			execData->addString( val, size );
-			count_string++;
-			break;
-		    }
-		    
-		    case A_STRING:
-		    {
-			size_t *size = new size_t;
-			*size = (size_t)( (int)*(value.length) );
-			char *val = new char[ *size ];
-			memcpy( val, (char *)value.buffer, *size );
-			execData->addString( val, size );
-			count_string++;
-			break;
-		    }
-			
-		    case A_VAL64:
-		    {
-			double *val = new double;
-			*val = (double)*(long long *)value.buffer;
-			execData->addNum( val );
-			count_num++;
-			break;
-		    }
-			
-		    case A_UVAL64:
-		    {
-			double *val = new double;
-			*val = (double)*(unsigned long long *)value.buffer;
-			execData->addNum( val );
-			count_num++;
-			break;
-		    }
-			
-		    case A_VAL32:
-		    {
-			int *val = new int;
-			*val = *(int*)value.buffer;
-			execData->addInt( val );
-			count_int++;
-			break;
-		    }
+    if( openConnections == 0 ) {
+	return;
+    }
+    openConnections--;
+    if( openConnections == 0 && api.initialized ) {
+	api.sqlany_fini();
+	sqlany_finalize_interface( &api );
+    }
+}
 
-		    case A_UVAL32:
-		    {
-			double *val = new double;
-			*val = (double)*(unsigned int*)value.buffer;
-			execData->addNum( val );
-			count_num++;
-			break;
-		    }
-			
-		    case A_VAL16:
-		    {
-			int *val = new int;
-			*val = (int)*(short*)value.buffer;
-			execData->addInt( val );
-			count_int++;
-			break;
-		    }
+// Completion queue
+// Worker threads push finished requests onto this queue and wake up the
+// main thread through a single uv_async_t. Since libuv coalesces async
+// sends, a burst of completions is delivered to JavaScript from one
+// callback, under one HandleScope and one microtask checkpoint. Each
+// request still runs its after_cb in its own async context, so that
+// AsyncLocalStorage and async_hooks based tracing follow the request.
+
+struct workRequest {
+    uv_work_t		work;
+    uv_work_t		*req;
+    uv_work_cb		work_cb;
+    uv_after_work_cb	after_cb;
+    // Reports the memory held by the result, if set
+    uv_work_cb		charge_cb;
+    const char *	name;
+    // When the work was queued, if it was traced
+    uint64_t		queued;
+#if NODE_MAJOR_VERSION >= 10
+    // Created on the main thread when the work is queued, destroyed once
+    // the after_cb has run.
+    node::AsyncResource	*async_resource;
+#endif
+    // The request is released by both the drain and libuv's after_work
+    // callback, whichever runs last frees it. Both run on the main thread.
+    int			refs;
+};
 
-		    case A_UVAL16:
-		    {
-			int *val = new int;
-			*val = (int)*(unsigned short*)value.buffer;
-			execData->addInt( val );
-			count_int++;
-			break;
-		    }
-			
-		    case A_VAL8:
-		    {
-			int *val = new int;
-			*val = (int)*(char *)value.buffer;
-			execData->addInt( val );
-			count_int++;
-			break;
-		    }
-			
-		    case A_UVAL8:
-		    {
-			int *val = new int;
-			*val = (int)*(unsigned char *)value.buffer;
-			execData->addInt( val );
-			count_int++;
-			break;
-		    }
-			
-		    case A_DOUBLE:
-		    {
-			double *val = new double;
-			*val = (double)*(double *)value.buffer;
-			execData->addNum( val );
-			count_num++;
-			break;
-		    }
-			
-                    default:
-			return false;
-		}
-		col_types.push_back( value.type );
+static uv_async_t			completion_async;
+static uv_mutex_t			completion_mutex;
+static std::vector<workRequest *>	completed;
+static unsigned				undelivered = 0;
+
+static void releaseWorkRequest( workRequest *wr )
+/***********************************************/
+{
+    if( --wr->refs == 0 ) {
+	delete wr;
+    }
+}
+
+static void runWork( uv_work_t *work )
+/************************************/
+{
+    workRequest *wr = static_cast<workRequest *>( work->data );
+    if( wr->queued != 0 && traceEnabled() ) {
+	traceAsync( wr->name, "queue", false, wr, traceNow() );
+    }
+    {
+	traceSpan span( wr->name, "work" );
+	wr->work_cb( wr->req );
+    }
+
+    {
+	scoped_lock lock( completion_mutex, completionLockStats() );
+	completed.push_back( wr );
+    }
+    uv_async_send( &completion_async );
+}
+
+static void workDone( uv_work_t *work, int status )
+/*************************************************/
+{
+    releaseWorkRequest( static_cast<workRequest *>( work->data ) );
+}
+
+static void drainCompletions( uv_async_t *handle )
+/************************************************/
+{
+    std::vector<workRequest *> ready;
+    {
+	scoped_lock lock( completion_mutex, completionLockStats() );
+	ready.swap( completed );
+    }
+    if( ready.empty() ) {
+	return;
+    }
+
+    traceSpan drain_span( "drainCompletions", "main" );
+    Isolate *isolate = Isolate::GetCurrent();
+    HandleScope scope( isolate );
+    // Count every result of the batch before the first one is converted
+    for( size_t i = 0; i < ready.size(); i++ ) {
+	if( ready[i]->charge_cb != NULL ) {
+	    ready[i]->charge_cb( ready[i]->req );
+	}
+    }
+    {
+#if NODE_MAJOR_VERSION >= 10
+	node::CallbackScope cb_scope( isolate, Object::New( isolate ),
+				      node::async_context() );
+#endif
+	for( size_t i = 0; i < ready.size(); i++ ) {
+	    workRequest *wr = ready[i];
+	    traceSpan after_span( wr->name, "main" );
+#if NODE_MAJOR_VERSION >= 10
+	    {
+		node::async_context context = {
+		    wr->async_resource->get_async_id(),
+		    wr->async_resource->get_trigger_async_id() };
+		node::CallbackScope req_scope( isolate,
+					       wr->async_resource->get_resource(),
+					       context );
+		wr->after_cb( wr->req, 0 );
 	    }
+	    delete wr->async_resource;
+	    wr->async_resource = NULL;
+#else
+	    wr->after_cb( wr->req, 0 );
+#endif
+	    releaseWorkRequest( wr );
 	}
+#if NODE_MAJOR_VERSION < 10
+	isolate->RunMicrotasks();
+#endif
+    }
+
+    undelivered -= (unsigned)ready.size();
+    if( undelivered == 0 ) {
+	uv_unref( (uv_handle_t *)&completion_async );
     }
-    
-    return true;
 }
 
-bool cleanAPI()
-/*************/
+void initCompletionQueue( void )
+/******************************/
 {
-    if( openConnections == 0 ) {
-	if( api.initialized ) {
-	    api.sqlany_fini();
-	    sqlany_finalize_interface( &api );
-	    return true;
-	}
+    uv_mutex_init( &completion_mutex );
+    uv_async_init( uv_default_loop(), &completion_async, drainCompletions );
+    // Only keep the loop alive while there are results to deliver
+    uv_unref( (uv_handle_t *)&completion_async );
+}
+
+int queueWork( uv_work_t *		req,
+	       uv_work_cb		work_cb,
+	       uv_after_work_cb		after_cb,
+	       const char *		resource_name,
+	       uv_work_cb		charge_cb )
+/****************************************************/
+{
+    workRequest *wr = new workRequest();
+    wr->work.data = wr;
+    wr->req = req;
+    wr->work_cb = work_cb;
+    wr->after_cb = after_cb;
+    wr->charge_cb = charge_cb;
+    wr->name = resource_name;
+    wr->refs = 2;
+
+    wr->queued = traceEnabled() ? traceNow() : 0;
+    int status = uv_queue_work( uv_default_loop(), &wr->work, runWork, workDone );
+    if( status != 0 ) {
+	delete wr;
+	return status;
     }
-    return false;
+    if( wr->queued != 0 ) {
+	traceAsync( resource_name, "queue", true, wr, wr->queued );
+    }
+#if NODE_MAJOR_VERSION >= 10
+    // The work cannot complete before we return to the event loop, so the
+    // resource is in place before drainCompletions can see the request.
+    Isolate *isolate = Isolate::GetCurrent();
+    HandleScope scope( isolate );
+    wr->async_resource = new node::AsyncResource( isolate, Object::New( isolate ),
+						  resource_name );
+#endif
+    if( undelivered++ == 0 ) {
+	uv_ref( (uv_handle_t *)&completion_async );
+    }
+    return status;
 }
 
 // Generic Baton and Callback (After) Function
@@ -735,12 +1306,15 @@ void Connection::noParamAfter( uv_work_t *req )
     Local<Value> undef = Local<Value>::New( isolate, Undefined( isolate ) );
 
     if( baton->err ) {
-	callBack( &( baton->error_msg ), baton->callback, undef,
-		  baton->callback_required );
+	diagEnd( baton->diag, &( baton->error_msg ) );
+	callBack( &( baton->error_msg ), baton->callback, baton->resolver,
+		  undef, baton->callback_required );
 	return;
     }
     
-    callBack( NULL, baton->callback, undef, baton->callback_required );
+    diagEnd( baton->diag, NULL );
+    callBack( NULL, baton->callback, baton->resolver, undef,
+	      baton->callback_required );
     
     delete baton;
     delete req;
@@ -753,6 +1327,9 @@ StmtObject::StmtObject()
 {
     connection = NULL;
     sqlany_stmt = NULL;
+    cached = false;
+    promise_mode = false;
+    external_bytes = 0;
 }
 
 StmtObject::~StmtObject()
@@ -770,6 +1347,7 @@ StmtObject::~StmtObject()
     if( mutex != NULL ) {
 	uv_mutex_unlock( mutex );
     }
+    releaseExternalMemory( external_bytes );
 }
 
 Persistent<Function> StmtObject::constructor;
@@ -785,6 +1363,8 @@ void StmtObject::Init( Isolate *isolate )
 
     // Prototype
     NODE_SET_PROTOTYPE_METHOD( tpl, "exec", exec );
+    NODE_SET_PROTOTYPE_METHOD( tpl, "execMany", execMany );
+    NODE_SET_PROTOTYPE_METHOD( tpl, "execAll", execAll );
     NODE_SET_PROTOTYPE_METHOD( tpl, "drop", drop );
     NODE_SET_PROTOTYPE_METHOD( tpl, "getMoreResults", getMoreResults );
     Local<Context> context = isolate->GetCurrentContext();
@@ -832,7 +1412,10 @@ void StmtObject::cleanup( void )
 /******************************/
 {
     if( sqlany_stmt != NULL ) {
-	api.sqlany_free_stmt( sqlany_stmt );
+	if( !cached || connection == NULL ||
+	    !connection->returnCachedStmt( sql, sqlany_stmt ) ) {
+	    api.sqlany_free_stmt( sqlany_stmt );
+	}
 	sqlany_stmt = NULL;
     }
 }
@@ -924,13 +1507,25 @@ static void CheckArgType( Local<Value> &obj )
 }
 #endif
 
+// Connections are numbered in the order they are created, to tell them
+// apart in traces
+static unsigned next_trace_id = 0;
+
 Connection::Connection( const FunctionCallbackInfo<Value> &args )
 /***************************************************************/
+    : conn_lock( "conn_mutex", &connLockStats() )
 {
     Isolate *isolate = args.GetIsolate();
     HandleScope scope( isolate );
     uv_mutex_init(&conn_mutex);
+    trace_id = ++next_trace_id;
+    conn_lock.conn = trace_id;
     conn = NULL;
+    promise_mode = false;
+    timing_mode = false;
+    statement_stats_mode = false;
+    slow_query_ms = 0;
+    deadline_ms = 0;
 
     if( args.Length() > 1 ) {
 	throwError( JS_ERR_INVALID_ARGUMENTS );
@@ -968,19 +1563,25 @@ Connection::Connection( const FunctionCallbackInfo<Value> &args )
 Connection::~Connection()
 /***********************/
 {
-    scoped_lock api_lock( api_mutex );
-    scoped_lock lock( conn_mutex );
-
-    _arg.Reset();
-    cleanupStmts();
-    if( conn != NULL ) {
-	api.sqlany_disconnect( conn );
-	api.sqlany_free_connection( conn );
-	conn = NULL;
-	openConnections--;
+    bool release = false;
+    {
+	scoped_lock lock( conn_mutex, conn_lock );
+
+	_arg.Reset();
+	slow_query_sink.Reset();
+	cleanupStmts();
+	clearStmtCache();
+	if( conn != NULL ) {
+	    api.sqlany_disconnect( conn );
+	    api.sqlany_free_connection( conn );
+	    conn = NULL;
+	    release = true;
+	}
     }
     
-    cleanAPI();
+    if( release ) {
+	releaseAPI();
+    }
 };
 
 void Connection::cleanupStmts( void )
@@ -1006,6 +1607,51 @@ void Connection::removeStmt( class StmtObject *stmt )
     }
 }
 
+// Statement cache
+// Statements prepared by cacheStatements are kept here while idle. A hit
+// takes the statement out of the cache, so that no two requests share it,
+// and StmtObject::cleanup puts it back. The caller must hold conn_mutex.
+a_sqlany_stmt *Connection::takeCachedStmt( const std::string &sql )
+/*****************************************************************/
+{
+    std::map<std::string, a_sqlany_stmt *>::iterator it = stmt_cache.find( sql );
+    if( it == stmt_cache.end() || it->second == NULL ) {
+	return NULL;
+    }
+    a_sqlany_stmt *stmt = it->second;
+    it->second = NULL;
+    stats.add( STAT_CACHE_HITS, 1 );
+    return stmt;
+}
+
+bool Connection::returnCachedStmt( const std::string &sql, a_sqlany_stmt *stmt )
+/******************************************************************************/
+{
+    if( conn == NULL ) {
+	return false;
+    }
+    std::map<std::string, a_sqlany_stmt *>::iterator it = stmt_cache.find( sql );
+    if( it == stmt_cache.end() || it->second != NULL ) {
+	return false;
+    }
+    // Close any open cursor before the statement sits idle
+    api.sqlany_reset( stmt );
+    it->second = stmt;
+    return true;
+}
+
+void Connection::clearStmtCache( void )
+/*************************************/
+{
+    std::map<std::string, a_sqlany_stmt *>::iterator it;
+    for( it = stmt_cache.begin(); it != stmt_cache.end(); it++ ) {
+	if( it->second != NULL ) {
+	    api.sqlany_free_stmt( it->second );
+	}
+    }
+    stmt_cache.clear();
+}
+
 Persistent<Function> Connection::constructor;
 
 void Connection::Init( Isolate *isolate )
@@ -1019,13 +1665,20 @@ void Connection::Init( Isolate *isolate )
     
     // Prototype
     NODE_SET_PROTOTYPE_METHOD( tpl, "exec", exec );
+    NODE_SET_PROTOTYPE_METHOD( tpl, "execBatch", execBatch );
+    NODE_SET_PROTOTYPE_METHOD( tpl, "execAll", execAll );
     NODE_SET_PROTOTYPE_METHOD( tpl, "prepare", prepare );
+    NODE_SET_PROTOTYPE_METHOD( tpl, "cacheStatements", cacheStatements );
     NODE_SET_PROTOTYPE_METHOD( tpl, "connect", connect );
     NODE_SET_PROTOTYPE_METHOD( tpl, "disconnect", disconnect );
     NODE_SET_PROTOTYPE_METHOD( tpl, "close", disconnect );
     NODE_SET_PROTOTYPE_METHOD( tpl, "commit", commit );
     NODE_SET_PROTOTYPE_METHOD( tpl, "rollback", rollback );
     NODE_SET_PROTOTYPE_METHOD( tpl, "connected", connected );
+    NODE_SET_PROTOTYPE_METHOD( tpl, "setOptions", setOptions );
+    NODE_SET_PROTOTYPE_METHOD( tpl, "getTimings", getTimings );
+    NODE_SET_PROTOTYPE_METHOD( tpl, "stats", getStats );
+    NODE_SET_PROTOTYPE_METHOD( tpl, "lockStats", getLockStats );
 
     Local<Context> context = isolate->GetCurrentContext();
     constructor.Reset(isolate, tpl->GetFunction(context).ToLocalChecked());
@@ -0,0 +1,167 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+// A stand-in for the native driver, for testing lib/pool.js without a
+// database. Queries run against an in-memory table, which understands the
+// statements that pool.scanPartitioned generates.
+//
+//   rows		the table, an array of objects
+//   failConnects	number of connect calls that fail before one succeeds
+//   execDelay		milliseconds each exec takes
+//
+// The driver records what the pool did with it in connects (the time of
+// each connect call), statements (each { sql, params } executed) and calls
+// (the names of the commit, rollback and execBatch calls, in order).
+'use strict';
+
+function Connection( driver )
+{
+    this._driver = driver;
+    this._connected = false;
+    this.options = {};
+}
+
+Connection.prototype.connect = function( params, callback )
+{
+    var conn = this;
+    var driver = this._driver;
+    driver.connects.push( Date.now() );
+    setImmediate( function() {
+	if( driver._failConnects > 0 ) {
+	    driver._failConnects--;
+	    return callback( new Error( "Connection refused" ) );
+	}
+	conn._connected = true;
+	callback( null );
+    } );
+};
+
+Connection.prototype.connected = function()
+{
+    return this._connected;
+};
+
+Connection.prototype.disconnect = function( callback )
+{
+    this._connected = false;
+    setImmediate( callback, null );
+};
+
+Connection.prototype.setOptions = function( options )
+{
+    for( var key in options ) {
+	this.options[key] = options[key];
+    }
+};
+
+Connection.prototype.cacheStatements = function( statements, callback )
+{
+    setImmediate( callback, null );
+};
+
+Connection.prototype.execBatch = function( statements, options, callback )
+{
+    if( typeof options === 'function' ) {
+	callback = options;
+	options = {};
+    }
+    this._driver.calls.push( options.transaction ? "execBatch transaction" : "execBatch" );
+    setImmediate( callback, null, statements.map( function() { return 0; } ) );
+};
+
+Connection.prototype.commit = function( callback )
+{
+    this._driver.calls.push( "commit" );
+    setImmediate( callback, null );
+};
+
+Connection.prototype.rollback = function( callback )
+{
+    this._driver.calls.push( "rollback" );
+    setImmediate( callback, null );
+};
+
+Connection.prototype.exec = function( sql, params, callback )
+{
+    if( typeof params === 'function' ) {
+	callback = params;
+	params = [];
+    }
+    var driver = this._driver;
+    driver.statements.push( { sql: sql, params: params } );
+    var result;
+    try {
+	result = driver._query( sql, params );
+    } catch( err ) {
+	return setImmediate( callback, err );
+    }
+    setTimeout( callback, driver._execDelay, null, result );
+};
+
+function FakeDriver( options )
+{
+    options = options !== undefined ? options : {};
+    this._rows = options.rows !== undefined ? options.rows : [];
+    this._failConnects = options.failConnects || 0;
+    this._execDelay = options.execDelay || 0;
+    this.connects = [];
+    this.statements = [];
+    this.calls = [];
+}
+
+FakeDriver.prototype.createConnection = function()
+{
+    return new Connection( this );
+};
+
+// Evaluates a statement of pool.scanPartitioned against the table. Any
+// other statement returns no rows.
+FakeDriver.prototype._query = function( sql, params )
+{
+    var range = sql.match( /^SELECT MIN\( \[(\w+)\] \) AS lo, MAX\( \[\w+\] \) AS hi / );
+    if( range !== null ) {
+	var keys = this._rows.map( function( row ) { return row[range[1]]; } )
+			     .filter( function( key ) { return key !== null; } );
+	return [ { lo: keys.length > 0 ? Math.min.apply( null, keys ) : null,
+		   hi: keys.length > 0 ? Math.max.apply( null, keys ) : null } ];
+    }
+    if( !/ AS sqlany_scan/.test( sql ) ) {
+	return [];
+    }
+
+    var where = sql.match( / WHERE \[(\w+)\] (.*?)(?: ORDER BY |$)/ );
+    var order = sql.match( / ORDER BY \[(\w+)\]$/ );
+    var rows = this._rows;
+    if( where !== null ) {
+	var column = where[1];
+	var values = params.slice( params.length - ( where[2].match( /\?/g ) || [] ).length );
+	rows = rows.filter( function( row ) {
+	    var key = row[column];
+	    if( / IS NULL$/.test( where[2] ) ) {
+		return key === null || key < values[0];
+	    }
+	    if( / AND /.test( where[2] ) ) {
+		return key !== null && key >= values[0] && key < values[1];
+	    }
+	    return key !== null && key >= values[0];
+	} );
+    }
+    if( order !== null ) {
+	// Column names are case insensitive, as on the server
+	var key = Object.keys( this._rows[0] || {} ).filter( function( name ) {
+	    return name.toLowerCase() === order[1].toLowerCase();
+	} )[0];
+	rows = rows.slice().sort( function( a, b ) {
+	    if( a[key] === b[key] ) {
+		return 0;
+	    }
+	    if( a[key] === null || b[key] === null ) {
+		return a[key] === null ? -1 : 1;
+	    }
+	    return a[key] < b[key] ? -1 : 1;
+	} );
+    }
+    return rows;
+};
+
+module.exports = FakeDriver;
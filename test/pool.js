@@ -0,0 +1,232 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+// Tests of how the pool opens, hands out and takes back connections.
+'use strict';
+
+var assert = require( 'assert' );
+var Pool = require( '../lib/pool' );
+var FakeDriver = require( './fake_driver' );
+
+// Calls check once test() is true, or fails the test after a second
+function waitFor( test, check )
+{
+    var started = Date.now();
+    ( function poll() {
+	if( test() ) {
+	    return check();
+	}
+	if( Date.now() - started > 1000 ) {
+	    return check( new Error( 'Condition not reached' ) );
+	}
+	setTimeout( poll, 5 );
+    } )();
+}
+
+module.exports = {
+    'warm-up statements run in a transaction that is committed': function( done ) {
+	var driver = new FakeDriver();
+	var pool = new Pool( driver, { connection: 'fake', warmUp: [ 'SET TEMPORARY OPTION x = 1' ] } );
+	pool.acquire( function( err, conn ) {
+	    assert.ifError( err );
+	    assert.deepStrictEqual( driver.calls, [ 'execBatch transaction' ] );
+	    pool.release( conn );
+	    pool.close( done );
+	} );
+    },
+
+    'released connections are rolled back and reused': function( done ) {
+	var driver = new FakeDriver();
+	var pool = new Pool( driver, { connection: 'fake', max: 1 } );
+	pool.acquire( function( err, first ) {
+	    assert.ifError( err );
+	    pool.release( first );
+	    pool.acquire( function( err, second ) {
+		assert.ifError( err );
+		assert.strictEqual( second, first );
+		assert.deepStrictEqual( driver.calls, [ 'rollback' ] );
+		assert.strictEqual( driver.connects.length, 1 );
+		pool.release( second );
+		pool.close( done );
+	    } );
+	} );
+    },
+
+    'min connections are opened up front': function( done ) {
+	var driver = new FakeDriver();
+	var pool = new Pool( driver, { connection: 'fake', min: 3, max: 5 } );
+	assert.strictEqual( pool.size(), 3 );
+	waitFor( function() { return pool.stats().idle === 3; }, function( err ) {
+	    assert.ifError( err );
+	    assert.strictEqual( driver.connects.length, 3 );
+	    pool.close( done );
+	} );
+    },
+
+    'failed opens are retried with a growing delay': function( done ) {
+	var driver = new FakeDriver( { failConnects: 3 } );
+	var pool = new Pool( driver, { connection: 'fake', min: 1 } );
+	waitFor( function() { return pool.stats().idle === 1; }, function( err ) {
+	    assert.ifError( err );
+	    var connects = driver.connects;
+	    assert.strictEqual( connects.length, 4 );
+	    // 100, 200 and then 400 ms apart, give or take the timers
+	    var delays = [ 100, 200, 400 ];
+	    for( var i = 0; i < delays.length; i++ ) {
+		var gap = connects[i + 1] - connects[i];
+		assert.ok( gap >= delays[i] - 5 && gap < delays[i] * 2,
+			   'retry ' + ( i + 1 ) + ' after ' + gap + ' ms' );
+	    }
+	    pool.close( done );
+	} );
+    },
+
+    'a dropped connection is replaced at once after a good open': function( done ) {
+	var driver = new FakeDriver( { failConnects: 1 } );
+	var pool = new Pool( driver, { connection: 'fake', min: 1 } );
+	waitFor( function() { return pool.stats().idle === 1; }, function( err ) {
+	    assert.ifError( err );
+	    pool.acquire( function( err, conn ) {
+		assert.ifError( err );
+		var opened = Date.now();
+		conn._connected = false;
+		pool.release( conn );
+		waitFor( function() { return pool.stats().idle === 1; }, function( err ) {
+		    assert.ifError( err );
+		    assert.strictEqual( driver.connects.length, 3 );
+		    assert.ok( driver.connects[2] - opened < 50 );
+		    pool.close( done );
+		} );
+	    } );
+	} );
+    },
+
+    'a failed open is passed to the request waiting for it': function( done ) {
+	var driver = new FakeDriver( { failConnects: 1 } );
+	var pool = new Pool( driver, { connection: 'fake' } );
+	pool.acquire( function( err ) {
+	    assert.ok( /Connection refused/.test( err.message ) );
+	    // the pool is not at min, so nothing is retried in the background
+	    assert.strictEqual( pool.size(), 0 );
+	    pool.acquire( function( err, conn ) {
+		assert.ifError( err );
+		pool.release( conn );
+		pool.close( done );
+	    } );
+	} );
+    },
+
+    'closing the pool stops the retries': function( done ) {
+	var driver = new FakeDriver( { failConnects: 100 } );
+	var pool = new Pool( driver, { connection: 'fake', min: 1 } );
+	setTimeout( function() {
+	    pool.close( function() {
+		var connects = driver.connects.length;
+		setTimeout( function() {
+		    assert.strictEqual( driver.connects.length, connects );
+		    done();
+		}, 300 );
+	    } );
+	}, 50 );
+    },
+
+    'requests beyond maxQueue are turned away': function( done ) {
+	var driver = new FakeDriver();
+	var pool = new Pool( driver, { connection: 'fake', max: 1, maxQueue: 2 } );
+	var served = [];
+	pool.acquire( function( err, conn ) {
+	    assert.ifError( err );
+	    // two wait, the third is rejected without waiting
+	    [ 1, 2 ].forEach( function( n ) {
+		pool.acquire( function( err, next ) {
+		    assert.ifError( err );
+		    served.push( n );
+		    pool.release( next );
+		} );
+	    } );
+	    pool.acquire( function( err ) {
+		assert.ok( /Too many requests/.test( err.message ) );
+		assert.strictEqual( pool.stats().waiting, 2 );
+		assert.strictEqual( pool.stats().rejected, 1 );
+		pool.release( conn );
+		waitFor( function() { return served.length === 2; }, function( err ) {
+		    assert.ifError( err );
+		    // in the order they arrived
+		    assert.deepStrictEqual( served, [ 1, 2 ] );
+		    pool.close( done );
+		} );
+	    } );
+	} );
+    },
+
+    'a request that waits past its timeout fails': function( done ) {
+	var driver = new FakeDriver();
+	var pool = new Pool( driver, { connection: 'fake', max: 1 } );
+	pool.acquire( function( err, conn ) {
+	    assert.ifError( err );
+	    var started = Date.now();
+	    pool.acquire( { timeout: 50 }, function( err ) {
+		assert.ok( /Timed out waiting/.test( err.message ) );
+		assert.ok( Date.now() - started >= 45 );
+		var stats = pool.stats();
+		assert.strictEqual( stats.expired, 1 );
+		assert.strictEqual( stats.waiting, 0 );
+		// the connection goes to the next request, not the expired one
+		pool.release( conn );
+		pool.acquire( { timeout: 50 }, function( err, next ) {
+		    assert.ifError( err );
+		    assert.strictEqual( next, conn );
+		    pool.release( next );
+		    pool.close( done );
+		} );
+	    } );
+	} );
+    },
+
+    'exec hands the rest of its timeout to the connection': function( done ) {
+	var driver = new FakeDriver();
+	var pool = new Pool( driver, { connection: 'fake', max: 1, timeout: 1000,
+				       connectionOptions: { deadlineMs: 5000 } } );
+	pool.acquire( function( err, conn ) {
+	    assert.ifError( err );
+	    var deadlines = [];
+	    var setOptions = conn.setOptions;
+	    conn.setOptions = function( options ) {
+		deadlines.push( options.deadlineMs );
+		setOptions.call( this, options );
+	    };
+	    setTimeout( function() { pool.release( conn ); }, 100 );
+	    pool.exec( 'UPDATE t SET v = 1', function( err ) {
+		assert.ifError( err );
+		// restored on release, then what was left of 1000 ms after
+		// waiting 100 ms for the connection
+		assert.strictEqual( deadlines[0], 5000 );
+		assert.ok( deadlines[1] > 0 && deadlines[1] <= 910, 'deadlineMs ' + deadlines[1] );
+		// the update was committed, and rolled back once more on release
+		waitFor( function() { return deadlines.length === 3; }, function( err ) {
+		    assert.ifError( err );
+		    assert.strictEqual( deadlines[2], 5000 );
+		    assert.deepStrictEqual( driver.calls, [ 'rollback', 'commit', 'rollback' ] );
+		    pool.close( done );
+		} );
+	    } );
+	} );
+    },
+
+    'a closed pool fails waiting and new requests': function( done ) {
+	var driver = new FakeDriver();
+	var pool = new Pool( driver, { connection: 'fake', max: 1 } );
+	pool.acquire( function( err, conn ) {
+	    assert.ifError( err );
+	    pool.acquire( function( err ) {
+		assert.ok( /Pool is closed/.test( err.message ) );
+		pool.acquire( function( err ) {
+		    assert.ok( /Pool is closed/.test( err.message ) );
+		    pool.release( conn );
+		    waitFor( function() { return !conn.connected(); }, done );
+		} );
+	    } );
+	    pool.close( function() {} );
+	} );
+    }
+};
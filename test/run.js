@@ -0,0 +1,82 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+// Runs the JavaScript tests, which need neither the native driver nor a
+// database:
+//
+//   npm test
+//   node test/run.js [--filter=text]
+//
+// Each test file exports its tests by name. A test is passed a callback to
+// call when it is done, with an error if it failed; assertions it throws
+// fail it too. Tests run one at a time, and the process exits with 1 if
+// any of them failed.
+'use strict';
+
+var files = [ './pool', './scan' ];
+
+var filter = null;
+process.argv.slice( 2 ).forEach( function( arg ) {
+    var match = arg.match( /^--filter=(.*)$/ );
+    if( match !== null ) {
+	filter = match[1];
+    }
+} );
+
+var tests = [];
+files.forEach( function( file ) {
+    var module_tests = require( file );
+    Object.keys( module_tests ).forEach( function( name ) {
+	var full_name = file.replace( /^\.\//, '' ) + ': ' + name;
+	if( filter === null || full_name.indexOf( filter ) >= 0 ) {
+	    tests.push( { name: full_name, fn: module_tests[name] } );
+	}
+    } );
+} );
+
+// A test that never calls back fails after this long
+var TEST_TIMEOUT_MS = 10000;
+
+var failures = 0;
+
+function runTest( index )
+{
+    if( index === tests.length ) {
+	console.log( ( tests.length - failures ) + ' passed, ' + failures + ' failed' );
+	process.exit( failures > 0 ? 1 : 0 );
+    }
+    var test = tests[index];
+    var finished = false;
+    var timer;
+
+    function finish( err )
+    {
+	if( finished ) {
+	    return;
+	}
+	finished = true;
+	clearTimeout( timer );
+	process.removeListener( 'uncaughtException', finish );
+	if( err ) {
+	    failures++;
+	    console.log( 'not ok - ' + test.name );
+	    console.log( '    ' + ( err.stack || err ).toString().replace( /\n/g, '\n    ' ) );
+	} else {
+	    console.log( 'ok - ' + test.name );
+	}
+	setImmediate( runTest, index + 1 );
+    }
+
+    timer = setTimeout( function() {
+	finish( new Error( 'Timed out' ) );
+    }, TEST_TIMEOUT_MS );
+    // Assertions thrown from callbacks of asynchronous work
+    process.on( 'uncaughtException', finish );
+    try {
+	test.fn( finish );
+    } catch( err ) {
+	finish( err );
+    }
+}
+
+runTest( 0 );
@@ -0,0 +1,164 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+// Tests of pool.scanPartitioned and the key ranges and merge behind it.
+'use strict';
+
+var assert = require( 'assert' );
+var Pool = require( '../lib/pool' );
+var FakeDriver = require( './fake_driver' );
+
+// 1000 rows with ids 0..999, every seventh one NULL, and a value that is
+// not in id order
+function table()
+{
+    var rows = [];
+    for( var i = 0; i < 1000; i++ ) {
+	rows.push( { id: i % 7 === 0 ? null : i, v: ( i * 37 ) % 1009 } );
+    }
+    return rows;
+}
+
+function scan( driver, options, check )
+{
+    var pool = new Pool( driver, { connection: 'fake', max: 4 } );
+    pool.scanPartitioned( 'SELECT * FROM t', options, function( err, rows ) {
+	pool.close( function() {
+	    check( err, rows );
+	} );
+    } );
+}
+
+function ids( rows )
+{
+    return rows.map( function( row ) { return row.id; } );
+}
+
+module.exports = {
+    'rangeBounds splits integers evenly': function( done ) {
+	assert.deepStrictEqual( Pool._rangeBounds( 0, 100, 4 ), [ 25, 50, 75 ] );
+	assert.deepStrictEqual( Pool._rangeBounds( 1, 10, 3 ), [ 4, 7 ] );
+	assert.deepStrictEqual( Pool._rangeBounds( -10, 10, 2 ), [ 0 ] );
+	done();
+    },
+
+    'rangeBounds keeps fractions for non-integer keys': function( done ) {
+	assert.deepStrictEqual( Pool._rangeBounds( 0, 1.5, 3 ), [ 0.5, 1 ] );
+	done();
+    },
+
+    'rangeBounds drops empty and repeated ranges': function( done ) {
+	// fewer distinct keys than partitions
+	assert.deepStrictEqual( Pool._rangeBounds( 0, 2, 5 ), [ 1 ] );
+	assert.deepStrictEqual( Pool._rangeBounds( 5, 5, 4 ), [] );
+	assert.deepStrictEqual( Pool._rangeBounds( 0, 100, 1 ), [] );
+	done();
+    },
+
+    'mergeSorted merges in key order with NULL first': function( done ) {
+	var merged = Pool._mergeSorted( [
+	    [ { k: null, n: 1 }, { k: 2, n: 2 }, { k: 8, n: 3 } ],
+	    [],
+	    [ { k: 1, n: 4 }, { k: 2, n: 5 }, { k: 9, n: 6 } ],
+	    [ { k: 5, n: 7 } ]
+	], 'k' );
+	assert.deepStrictEqual( merged.map( function( row ) { return row.k; } ),
+				[ null, 1, 2, 2, 5, 8, 9 ] );
+	// ties keep the order of the lists
+	assert.deepStrictEqual( merged.map( function( row ) { return row.n; } ),
+				[ 1, 4, 2, 5, 7, 3, 6 ] );
+	done();
+    },
+
+    'mergeSorted matches the column in any case': function( done ) {
+	var merged = Pool._mergeSorted( [
+	    [ { ID: 3 } ], [ { ID: 1 } ], [ { ID: 2 } ]
+	], 'id' );
+	assert.deepStrictEqual( merged, [ { ID: 1 }, { ID: 2 }, { ID: 3 } ] );
+	assert.deepStrictEqual( Pool._mergeSorted( [ [], [] ], 'id' ), [] );
+	done();
+    },
+
+    'scanPartitioned returns every row once, NULL keys included': function( done ) {
+	var driver = new FakeDriver( { rows: table() } );
+	scan( driver, { partitionColumn: 'id', partitions: 4 }, function( err, rows ) {
+	    assert.ifError( err );
+	    assert.strictEqual( rows.length, 1000 );
+	    var seen = {};
+	    rows.forEach( function( row ) {
+		assert.ok( !seen[row.v], 'row returned twice' );
+		seen[row.v] = true;
+	    } );
+	    // one range query and then one statement per partition
+	    assert.strictEqual( driver.statements.length, 5 );
+	    done();
+	} );
+    },
+
+    'scanPartitioned merges the partitions by sortKey': function( done ) {
+	var driver = new FakeDriver( { rows: table() } );
+	scan( driver, { partitionColumn: 'id', partitions: 3, sortKey: 'V' },
+	      function( err, rows ) {
+	    assert.ifError( err );
+	    assert.strictEqual( rows.length, 1000 );
+	    for( var i = 1; i < rows.length; i++ ) {
+		assert.ok( rows[i - 1].v <= rows[i].v, 'rows out of order at ' + i );
+	    }
+	    done();
+	} );
+    },
+
+    'scanPartitioned uses the ranges given': function( done ) {
+	var driver = new FakeDriver( { rows: table() } );
+	scan( driver, { partitionColumn: 'id', ranges: [ 10, 20 ], sortKey: 'id' },
+	      function( err, rows ) {
+	    assert.ifError( err );
+	    assert.strictEqual( driver.statements.length, 3 );
+	    assert.deepStrictEqual( driver.statements.map( function( s ) { return s.params; } ),
+				    [ [ 10 ], [ 10, 20 ], [ 20 ] ] );
+	    // the 143 NULL keys sort first
+	    var keys = ids( rows );
+	    assert.strictEqual( keys.lastIndexOf( null ), 142 );
+	    assert.deepStrictEqual( keys.slice( 143, 146 ), [ 1, 2, 3 ] );
+	    done();
+	} );
+    },
+
+    'scanPartitioned quotes the columns it generates SQL for': function( done ) {
+	var driver = new FakeDriver( { rows: table() } );
+	scan( driver, { partitionColumn: 'id', partitions: 2, sortKey: 'v' },
+	      function( err ) {
+	    assert.ifError( err );
+	    assert.ok( /MIN\( \[id\] \)/.test( driver.statements[0].sql ) );
+	    driver.statements.slice( 1 ).forEach( function( statement ) {
+		assert.ok( / WHERE \[id\] /.test( statement.sql ) );
+		assert.ok( / ORDER BY \[v\]$/.test( statement.sql ) );
+	    } );
+	    done();
+	} );
+    },
+
+    'scanPartitioned rejects column names that are not plain': function( done ) {
+	var driver = new FakeDriver( { rows: table() } );
+	scan( driver, { partitionColumn: 'id; DROP TABLE t', partitions: 2 },
+	      function( err ) {
+	    assert.ok( /partitionColumn/.test( err.message ) );
+	    scan( driver, { partitionColumn: 'id', partitions: 2, sortKey: 'v DESC' },
+		  function( err ) {
+		assert.ok( /sortKey/.test( err.message ) );
+		assert.strictEqual( driver.statements.length, 0 );
+		done();
+	    } );
+	} );
+    },
+
+    'scanPartitioned on an empty table scans it whole': function( done ) {
+	var driver = new FakeDriver( { rows: [] } );
+	scan( driver, { partitionColumn: 'id', partitions: 4 }, function( err, rows ) {
+	    assert.ifError( err );
+	    assert.deepStrictEqual( rows, [] );
+	    assert.strictEqual( driver.statements.length, 2 );
+	    done();
+	} );
+    }
+};
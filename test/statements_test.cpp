@@ -0,0 +1,194 @@
+// ***************************************************************************
+// Copyright (c) 2021 SAP SE or an SAP affiliate company. All rights reserved.
+// ***************************************************************************
+// Tests of statement fingerprints and latency histograms (src/statements.cpp).
+// Build with node-gyp rebuild -- -Dsqlany_test=1 and run
+// build/Release/statements_test; it exits with 1 if a check fails.
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "statements.h"
+
+static int failures = 0;
+
+static void check( bool ok, const char *what, int line )
+/******************************************************/
+{
+    if( !ok ) {
+	fprintf( stderr, "line %d: %s\n", line, what );
+	failures++;
+    }
+}
+
+#define CHECK( expr )	check( ( expr ), #expr, __LINE__ )
+
+static void checkFingerprint( const char *sql, const char *expected, int line )
+/*****************************************************************************/
+{
+    std::string actual = fingerprintSql( sql );
+    if( actual != expected ) {
+	fprintf( stderr, "line %d: fingerprint of \"%s\" is \"%s\", not \"%s\"\n",
+		 line, sql, actual.c_str(), expected );
+	failures++;
+    }
+}
+
+#define CHECK_FINGERPRINT( sql, expected ) \
+    checkFingerprint( ( sql ), ( expected ), __LINE__ )
+
+static void testFingerprints( void )
+/**********************************/
+{
+    // literals
+    CHECK_FINGERPRINT( "SELECT * FROM t WHERE id = 42", "SELECT * FROM t WHERE id = ?" );
+    CHECK_FINGERPRINT( "SELECT 'it''s', 'x' FROM t", "SELECT ?, ? FROM t" );
+    CHECK_FINGERPRINT( "SELECT 1.5, 2e10, 3E-4, 0x1F", "SELECT ?, ?, ?, ?" );
+    CHECK_FINGERPRINT( "SELECT -7", "SELECT -?" );
+
+    // digits inside names are not literals
+    CHECK_FINGERPRINT( "SELECT c1 FROM t2", "SELECT c1 FROM t2" );
+    CHECK_FINGERPRINT( "SELECT a$1, b#2, @v3", "SELECT a$1, b#2, @v3" );
+
+    // quoted identifiers are kept as they are
+    CHECK_FINGERPRINT( "SELECT \"col 1\", [col 2] FROM t",
+		       "SELECT \"col 1\", [col 2] FROM t" );
+    CHECK_FINGERPRINT( "SELECT \"a'b\" FROM t", "SELECT \"a'b\" FROM t" );
+
+    // white space and comments
+    CHECK_FINGERPRINT( "  SELECT\n\t*   FROM  t  ", "SELECT * FROM t" );
+    CHECK_FINGERPRINT( "SELECT 1 -- one\nFROM t", "SELECT ? FROM t" );
+    CHECK_FINGERPRINT( "SELECT /* all */ * FROM t", "SELECT * FROM t" );
+    CHECK_FINGERPRINT( "SELECT * FROM t /* unterminated", "SELECT * FROM t" );
+
+    // IN lists, whatever their length
+    CHECK_FINGERPRINT( "SELECT * FROM t WHERE id IN ( 1, 2, 3 )",
+		       "SELECT * FROM t WHERE id IN (?)" );
+    CHECK_FINGERPRINT( "SELECT * FROM t WHERE id in ('a','b')",
+		       "SELECT * FROM t WHERE id in (?)" );
+    CHECK( fingerprintSql( "SELECT * FROM t WHERE id IN (1)" ) ==
+	   fingerprintSql( "SELECT * FROM t WHERE id IN (1, 2, 3, 4, 5, 6)" ) );
+    // a subquery is not a list of values
+    CHECK_FINGERPRINT( "SELECT * FROM t WHERE id IN (SELECT id FROM u)",
+		       "SELECT * FROM t WHERE id IN (SELECT id FROM u)" );
+    // nor is the argument list of a function whose name ends in "in"
+    CHECK_FINGERPRINT( "SELECT origin(1, 2)", "SELECT origin(?, ?)" );
+
+    // parameters are left alone
+    CHECK_FINGERPRINT( "UPDATE t SET v = ? WHERE id = ?",
+		       "UPDATE t SET v = ? WHERE id = ?" );
+
+    // unterminated literals do not read past the end
+    CHECK_FINGERPRINT( "SELECT 'abc", "SELECT ?" );
+    CHECK_FINGERPRINT( "SELECT [abc", "SELECT [abc" );
+    CHECK_FINGERPRINT( "", "" );
+}
+
+static void testHistogram( void )
+/*******************************/
+{
+    latencyHistogram empty;
+    CHECK( empty.percentile( 0.5 ) == 0 );
+    CHECK( empty.maximum() == 0 );
+
+    // values below HIST_SUB_BUCKETS are exact
+    latencyHistogram small;
+    for( uint64_t i = 0; i < HIST_SUB_BUCKETS; i++ ) {
+	small.record( i );
+    }
+    CHECK( small.percentile( 0.0 ) == 0 );
+    CHECK( small.percentile( 0.5 ) == HIST_SUB_BUCKETS / 2 - 1 );
+    CHECK( small.percentile( 1.0 ) == HIST_SUB_BUCKETS - 1 );
+
+    // 1..1000: each percentile is at or above the true value and within
+    // the precision of a bucket
+    latencyHistogram hist;
+    for( uint64_t i = 1; i <= 1000; i++ ) {
+	hist.record( i );
+    }
+    CHECK( hist.maximum() == 1000 );
+    static const double fractions[] = { 0.1, 0.5, 0.9, 0.99 };
+    for( size_t i = 0; i < sizeof( fractions ) / sizeof( fractions[0] ); i++ ) {
+	uint64_t expected = (uint64_t)( fractions[i] * 1000 + 0.5 );
+	uint64_t value = hist.percentile( fractions[i] );
+	CHECK( value >= expected );
+	CHECK( value <= expected + expected / HIST_SUB_BUCKETS );
+    }
+    // never above the largest value recorded
+    CHECK( hist.percentile( 1.0 ) == 1000 );
+
+    // one slow sample among fast ones only shows in the tail
+    latencyHistogram skewed;
+    for( int i = 0; i < 99; i++ ) {
+	skewed.record( 10 );
+    }
+    skewed.record( 1000000 );
+    CHECK( skewed.percentile( 0.5 ) == 10 );
+    CHECK( skewed.percentile( 0.99 ) == 10 );
+    CHECK( skewed.percentile( 1.0 ) == 1000000 );
+    CHECK( skewed.maximum() == 1000000 );
+
+    // values beyond the last magnitude land in the last bucket
+    latencyHistogram huge;
+    huge.record( UINT64_MAX );
+    CHECK( huge.percentile( 0.5 ) == UINT64_MAX );
+}
+
+static void testRegistry( void )
+/******************************/
+{
+    statementRegistry registry;
+    uint64_t fast[PHASE_NUM_PHASES] = { 1000, 2000, 3000 };
+    uint64_t slow[PHASE_NUM_PHASES] = { 0, 50000000, 0 };
+
+    registry.record( "SELECT ?", false, fast );
+    registry.record( "SELECT ?", true, fast );
+    registry.record( "UPDATE t SET v = ?", false, slow );
+
+    std::vector<statementEntry> entries;
+    registry.top( 10, entries );
+    CHECK( entries.size() == 2 );
+    if( entries.size() == 2 ) {
+	// highest total time first
+	CHECK( entries[0].fingerprint == "UPDATE t SET v = ?" );
+	CHECK( entries[0].calls == 1 );
+	CHECK( entries[0].total_ns == 50000000 );
+	CHECK( entries[1].fingerprint == "SELECT ?" );
+	CHECK( entries[1].calls == 2 );
+	CHECK( entries[1].errors == 1 );
+	// executions that failed count, but add no time
+	CHECK( entries[1].total_ns == 6000 );
+	CHECK( entries[1].phases[PHASE_EXECUTE].percentile( 0.5 ) == 2 );
+    }
+
+    // the least recently executed fingerprint makes room for a new one
+    registry.clear();
+    for( int i = 0; i <= STATEMENT_STATS_LIMIT; i++ ) {
+	registry.record( "SELECT " + std::to_string( i ), false, fast );
+    }
+    registry.top( STATEMENT_STATS_LIMIT * 2, entries );
+    CHECK( entries.size() == STATEMENT_STATS_LIMIT );
+    bool has_first = false;
+    for( size_t i = 0; i < entries.size(); i++ ) {
+	has_first = has_first || entries[i].fingerprint == "SELECT 0";
+    }
+    CHECK( !has_first );
+
+    registry.clear();
+    registry.top( 10, entries );
+    CHECK( entries.empty() );
+}
+
+int main( void )
+/**************/
+{
+    testFingerprints();
+    testHistogram();
+    testRegistry();
+    if( failures > 0 ) {
+	fprintf( stderr, "%d checks failed\n", failures );
+	return 1;
+    }
+    printf( "all checks passed\n" );
+    return 0;
+}